@@ -0,0 +1,108 @@
+#ifndef WEBDRIVERXX_ASYNC_H
+#define WEBDRIVERXX_ASYNC_H
+
+#include "session.h"
+#include "element.h"
+#include "by.h"
+#include "keys.h"
+#include "js_args.h"
+#include "cancellation.h"
+#include "types.h"
+#include "detail/shared.h"
+#include "detail/thread_pool.h"
+#include "detail/meta_tools.h"
+#include <future>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+const size_t kDefaultAsyncConcurrency = 8;
+
+// Runs Element's commands on a thread pool. Every command returns
+// immediately with a future, so independent commands can be in flight
+// at the same time. Commands inherit the caller's CancellationScope.
+class AsyncElement { // copyable
+public:
+	AsyncElement();
+	AsyncElement(
+		const Element& element,
+		const detail::Shared<detail::ThreadPool>& pool
+		);
+
+	const Element& GetElement() const;
+
+	std::future<bool> IsDisplayed() const;
+	std::future<bool> IsEnabled() const;
+	std::future<bool> IsSelected() const;
+	std::future<Point> GetLocation() const;
+	std::future<Size> GetSize() const;
+	std::future<std::string> GetAttribute(const std::string& name) const;
+	std::future<std::string> GetCssProperty(const std::string& name) const;
+	std::future<std::string> GetTagName() const;
+	std::future<std::string> GetText() const;
+
+	std::future<AsyncElement> FindElement(const By& by) const;
+	std::future<std::vector<AsyncElement>> FindElements(const By& by) const;
+
+	std::future<void> Clear() const;
+	std::future<void> Click() const;
+	std::future<void> Submit() const;
+	std::future<void> SendKeys(const std::string& keys) const;
+	std::future<void> SendKeys(const Shortcut& shortcut) const;
+
+	// Runs function(element) on the pool.
+	template<typename Function>
+	auto Run(Function function) const
+		-> std::future<decltype(function(detail::value_ref<const Element>()))>;
+
+private:
+	Element element_;
+	detail::Shared<detail::ThreadPool> pool_;
+};
+
+// Runs Session's commands on a thread pool. Copies share the pool.
+// The transport should support concurrent requests (the default one does).
+class AsyncSession { // copyable
+public:
+	explicit AsyncSession(
+		const Session& session,
+		size_t concurrency = kDefaultAsyncConcurrency
+		);
+	AsyncSession(
+		const Session& session,
+		const detail::Shared<detail::ThreadPool>& pool
+		);
+
+	const Session& GetSession() const;
+	AsyncElement Wrap(const Element& element) const;
+
+	std::future<std::string> GetSource() const;
+	std::future<std::string> GetTitle() const;
+	std::future<std::string> GetUrl() const;
+	std::future<std::string> GetScreenshot() const; // Base64 PNG
+
+	std::future<void> Navigate(const std::string& url) const;
+
+	std::future<void> Execute(const std::string& script, const JsArgs& args = JsArgs()) const;
+	template<typename T>
+	std::future<T> Eval(const std::string& script, const JsArgs& args = JsArgs()) const;
+
+	std::future<AsyncElement> FindElement(const By& by) const;
+	std::future<std::vector<AsyncElement>> FindElements(const By& by) const;
+
+	// Runs function(session) on the pool.
+	template<typename Function>
+	auto Run(Function function) const
+		-> std::future<decltype(function(detail::value_ref<const Session>()))>;
+
+private:
+	Session session_;
+	detail::Shared<detail::ThreadPool> pool_;
+};
+
+} // namespace webdriverxx
+
+#include "async.inl"
+
+#endif
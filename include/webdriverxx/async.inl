@@ -0,0 +1,229 @@
+#include "detail/error_handling.h"
+#include <algorithm>
+
+namespace webdriverxx {
+namespace detail {
+
+inline
+std::vector<AsyncElement> WrapElements(
+	const std::vector<Element>& elements,
+	const Shared<ThreadPool>& pool
+	) {
+	std::vector<AsyncElement> result;
+	result.reserve(elements.size());
+	std::transform(elements.begin(), elements.end(), std::back_inserter(result),
+		[&pool](const Element& element) {
+			return AsyncElement(element, pool);
+		});
+	return result;
+}
+
+} // namespace detail
+
+inline
+AsyncElement::AsyncElement() {}
+
+inline
+AsyncElement::AsyncElement(
+	const Element& element,
+	const detail::Shared<detail::ThreadPool>& pool
+	)
+	: element_(element)
+	, pool_(pool)
+{}
+
+inline
+const Element& AsyncElement::GetElement() const {
+	return element_;
+}
+
+inline
+std::future<bool> AsyncElement::IsDisplayed() const {
+	return Run([](const Element& element) { return element.IsDisplayed(); });
+}
+
+inline
+std::future<bool> AsyncElement::IsEnabled() const {
+	return Run([](const Element& element) { return element.IsEnabled(); });
+}
+
+inline
+std::future<bool> AsyncElement::IsSelected() const {
+	return Run([](const Element& element) { return element.IsSelected(); });
+}
+
+inline
+std::future<Point> AsyncElement::GetLocation() const {
+	return Run([](const Element& element) { return element.GetLocation(); });
+}
+
+inline
+std::future<Size> AsyncElement::GetSize() const {
+	return Run([](const Element& element) { return element.GetSize(); });
+}
+
+inline
+std::future<std::string> AsyncElement::GetAttribute(const std::string& name) const {
+	return Run([name](const Element& element) { return element.GetAttribute(name); });
+}
+
+inline
+std::future<std::string> AsyncElement::GetCssProperty(const std::string& name) const {
+	return Run([name](const Element& element) { return element.GetCssProperty(name); });
+}
+
+inline
+std::future<std::string> AsyncElement::GetTagName() const {
+	return Run([](const Element& element) { return element.GetTagName(); });
+}
+
+inline
+std::future<std::string> AsyncElement::GetText() const {
+	return Run([](const Element& element) { return element.GetText(); });
+}
+
+inline
+std::future<AsyncElement> AsyncElement::FindElement(const By& by) const {
+	const detail::Shared<detail::ThreadPool> pool = pool_;
+	return Run([by, pool](const Element& element) {
+		return AsyncElement(element.FindElement(by), pool);
+	});
+}
+
+inline
+std::future<std::vector<AsyncElement>> AsyncElement::FindElements(const By& by) const {
+	const detail::Shared<detail::ThreadPool> pool = pool_;
+	return Run([by, pool](const Element& element) {
+		return detail::WrapElements(element.FindElements(by), pool);
+	});
+}
+
+inline
+std::future<void> AsyncElement::Clear() const {
+	return Run([](const Element& element) { element.Clear(); });
+}
+
+inline
+std::future<void> AsyncElement::Click() const {
+	return Run([](const Element& element) { element.Click(); });
+}
+
+inline
+std::future<void> AsyncElement::Submit() const {
+	return Run([](const Element& element) { element.Submit(); });
+}
+
+inline
+std::future<void> AsyncElement::SendKeys(const std::string& keys) const {
+	return Run([keys](const Element& element) { element.SendKeys(keys); });
+}
+
+inline
+std::future<void> AsyncElement::SendKeys(const Shortcut& shortcut) const {
+	return Run([shortcut](const Element& element) { element.SendKeys(shortcut); });
+}
+
+template<typename Function>
+auto AsyncElement::Run(Function function) const
+	-> std::future<decltype(function(detail::value_ref<const Element>()))> {
+	WEBDRIVERXX_CHECK(pool_, "Attempt to use empty AsyncElement");
+	const Element element = element_;
+	const CancellationContext cancellation = CancellationContext::Capture();
+	return pool_->Async([element, function, cancellation]{
+		const CancellationScope scope(cancellation);
+		return function(element);
+	});
+}
+
+///////////////////////////////////////////////////////////////////
+
+inline
+AsyncSession::AsyncSession(const Session& session, size_t concurrency)
+	: session_(session)
+	, pool_(new detail::ThreadPool(concurrency))
+{}
+
+inline
+AsyncSession::AsyncSession(
+	const Session& session,
+	const detail::Shared<detail::ThreadPool>& pool
+	)
+	: session_(session)
+	, pool_(pool)
+{}
+
+inline
+const Session& AsyncSession::GetSession() const {
+	return session_;
+}
+
+inline
+AsyncElement AsyncSession::Wrap(const Element& element) const {
+	return AsyncElement(element, pool_);
+}
+
+inline
+std::future<std::string> AsyncSession::GetSource() const {
+	return Run([](const Session& session) { return session.GetSource(); });
+}
+
+inline
+std::future<std::string> AsyncSession::GetTitle() const {
+	return Run([](const Session& session) { return session.GetTitle(); });
+}
+
+inline
+std::future<std::string> AsyncSession::GetUrl() const {
+	return Run([](const Session& session) { return session.GetUrl(); });
+}
+
+inline
+std::future<std::string> AsyncSession::GetScreenshot() const {
+	return Run([](const Session& session) { return session.GetScreenshot(); });
+}
+
+inline
+std::future<void> AsyncSession::Navigate(const std::string& url) const {
+	return Run([url](const Session& session) { session.Navigate(url); });
+}
+
+inline
+std::future<void> AsyncSession::Execute(const std::string& script, const JsArgs& args) const {
+	return Run([script, args](const Session& session) { session.Execute(script, args); });
+}
+
+template<typename T>
+std::future<T> AsyncSession::Eval(const std::string& script, const JsArgs& args) const {
+	return Run([script, args](const Session& session) {
+		return session.Eval<T>(script, args);
+	});
+}
+
+inline
+std::future<AsyncElement> AsyncSession::FindElement(const By& by) const {
+	const detail::Shared<detail::ThreadPool> pool = pool_;
+	return Run([by, pool](const Session& session) {
+		return AsyncElement(session.FindElement(by), pool);
+	});
+}
+
+inline
+std::future<std::vector<AsyncElement>> AsyncSession::FindElements(const By& by) const {
+	const detail::Shared<detail::ThreadPool> pool = pool_;
+	return Run([by, pool](const Session& session) {
+		return detail::WrapElements(session.FindElements(by), pool);
+	});
+}
+
+template<typename Function>
+auto AsyncSession::Run(Function function) const
+	-> std::future<decltype(function(detail::value_ref<const Session>()))> {
+	const Session session = session_;
+	const CancellationContext cancellation = CancellationContext::Capture();
+	return pool_->Async([session, function, cancellation]{
+		const CancellationScope scope(cancellation);
+		return function(session);
+	});
+}
+
+} // namespace webdriverxx
@@ -0,0 +1,92 @@
+#ifndef WEBDRIVERXX_BATCH_H
+#define WEBDRIVERXX_BATCH_H
+
+#include "session.h"
+#include "async.h"
+#include "cancellation.h"
+#include "detail/shared.h"
+#include "detail/thread_pool.h"
+#include "detail/meta_tools.h"
+#include <picojson.h>
+#include <exception>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+struct BatchResult {
+	enum Status {
+		Succeeded,
+		Failed,
+		Skipped // An earlier command of the same session failed
+	};
+
+	Status status;
+	std::string error;
+
+	BatchResult() : status(Succeeded) {}
+};
+
+namespace detail {
+
+struct BatchCommand {
+	std::string lane; // Session ID, commands of a lane are sent in order
+	CancellationContext cancellation;
+	std::function<void()> run; // Fulfills the promise on success
+	std::function<void(std::exception_ptr)> fail;
+};
+
+} // namespace detail
+
+// Queues commands and sends them all at once. Commands of a session are
+// sent back to back in the order they were queued, because a WebDriver
+// server executes them one at a time anyway and later ones often depend
+// on earlier ones. Only commands of different sessions are sent
+// concurrently, so a batch of commands of a single session, such as
+// many SetCookie calls or Clear and SendKeys, takes as long as calling
+// them directly. Every command gets a future for its result. Queued
+// commands that are never sent are dropped, their futures report
+// a broken promise.
+class CommandBatch { // noncopyable
+public:
+	explicit CommandBatch(size_t concurrency = kDefaultAsyncConcurrency);
+	explicit CommandBatch(const detail::Shared<detail::ThreadPool>& pool);
+
+	// Queues function(session). Commands inherit the caller's CancellationScope.
+	template<typename Function>
+	auto Add(const Session& session, Function function)
+		-> std::future<decltype(function(detail::value_ref<const Session>()))>;
+
+	// Queues a raw POST of the command relative to the session,
+	// e.g. "cookie" or "window/current/size".
+	std::future<picojson::value> Post(
+		const Session& session,
+		const std::string& command,
+		const picojson::value& data = picojson::value()
+		);
+
+	size_t GetSize() const;
+
+	// Sends queued commands and waits for all of them. Returns their
+	// outcomes in the order they were queued. The batch can be reused.
+	std::vector<BatchResult> Run();
+
+private:
+	template<typename Result>
+	struct Fulfill;
+
+	CommandBatch(CommandBatch&);
+	CommandBatch& operator = (CommandBatch&);
+
+private:
+	detail::Shared<detail::ThreadPool> pool_;
+	std::vector<detail::BatchCommand> commands_;
+};
+
+} // namespace webdriverxx
+
+#include "batch.inl"
+
+#endif
@@ -0,0 +1,117 @@
+#include "detail/error_handling.h"
+#include <map>
+#include <memory>
+
+namespace webdriverxx {
+
+template<typename Result>
+struct CommandBatch::Fulfill {
+	template<typename Function>
+	static void Run(std::promise<Result>& promise, Function& function, const Session& session) {
+		promise.set_value(function(session));
+	}
+};
+
+template<>
+struct CommandBatch::Fulfill<void> {
+	template<typename Function>
+	static void Run(std::promise<void>& promise, Function& function, const Session& session) {
+		function(session);
+		promise.set_value();
+	}
+};
+
+inline
+CommandBatch::CommandBatch(size_t concurrency)
+	: pool_(new detail::ThreadPool(concurrency))
+{}
+
+inline
+CommandBatch::CommandBatch(const detail::Shared<detail::ThreadPool>& pool)
+	: pool_(pool)
+{
+	WEBDRIVERXX_CHECK(pool_, "Thread pool is empty");
+}
+
+template<typename Function>
+auto CommandBatch::Add(const Session& session, Function function)
+	-> std::future<decltype(function(detail::value_ref<const Session>()))> {
+	typedef decltype(function(detail::value_ref<const Session>())) Result;
+	const auto promise = std::make_shared<std::promise<Result>>();
+	detail::BatchCommand command;
+	command.lane = session.GetId();
+	command.cancellation = CancellationContext::Capture();
+	command.run = [promise, function, session]() mutable {
+		Fulfill<Result>::Run(*promise, function, session);
+	};
+	command.fail = [promise](std::exception_ptr error) {
+		promise->set_exception(error);
+	};
+	commands_.push_back(command);
+	return promise->get_future();
+}
+
+inline
+std::future<picojson::value> CommandBatch::Post(
+	const Session& session,
+	const std::string& command,
+	const picojson::value& data
+	) {
+	return Add(session, [command, data](const Session& session) {
+		return session.PostCommand(command, data);
+	});
+}
+
+inline
+size_t CommandBatch::GetSize() const {
+	return commands_.size();
+}
+
+inline
+std::vector<BatchResult> CommandBatch::Run() {
+	const auto commands = std::make_shared<std::vector<detail::BatchCommand>>();
+	commands->swap(commands_);
+	const auto results = std::make_shared<std::vector<BatchResult>>(commands->size());
+
+	std::map<std::string, std::vector<size_t>> lanes;
+	for (size_t i = 0; i < commands->size(); ++i)
+		lanes[(*commands)[i].lane].push_back(i);
+
+	std::vector<std::future<void>> sent;
+	sent.reserve(lanes.size());
+	for (const auto& lane : lanes) {
+		const std::vector<size_t> order = lane.second;
+		sent.push_back(pool_->Async([commands, results, order]{
+			bool failed = false;
+			for (const size_t index : order) {
+				const detail::BatchCommand& command = (*commands)[index];
+				BatchResult& result = (*results)[index];
+				if (failed) {
+					result.status = BatchResult::Skipped;
+					result.error = "Skipped because an earlier command of the session failed";
+					command.fail(std::make_exception_ptr(WebDriverException(result.error)));
+					continue;
+				}
+				try {
+					const CancellationScope scope(command.cancellation);
+					command.run();
+				} catch (const std::exception& e) {
+					failed = true;
+					result.status = BatchResult::Failed;
+					result.error = e.what();
+					command.fail(std::current_exception());
+				} catch (...) {
+					failed = true;
+					result.status = BatchResult::Failed;
+					result.error = "Unknown exception";
+					command.fail(std::current_exception());
+				}
+			}
+		}));
+	}
+	for (auto& lane : sent)
+		lane.wait();
+	return *results;
+}
+
+} // namespace webdriverxx
@@ -0,0 +1,223 @@
+#ifndef WEBDRIVERXX_CANCELLATION_H
+#define WEBDRIVERXX_CANCELLATION_H
+
+#include "types.h"
+#include "detail/error_handling.h"
+#include "detail/time.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+struct CancellationState {
+	std::atomic<bool> cancelled;
+	const TimePoint deadline; // 0 means no deadline
+
+	explicit CancellationState(TimePoint deadline)
+		: cancelled(false)
+		, deadline(deadline)
+	{}
+};
+
+} // namespace detail
+
+// Stops commands that are in progress or not started yet.
+// A token is cancelled by Cancel() or when its deadline passes.
+// Copies share the state, so a token can be cancelled from any thread.
+class CancellationToken { // copyable
+public:
+	// Never cancelled.
+	CancellationToken() {}
+
+	static CancellationToken MakeCancellable() {
+		return CancellationToken(0);
+	}
+
+	static CancellationToken WithDeadline(TimePoint deadline) {
+		return CancellationToken(deadline);
+	}
+
+	static CancellationToken WithTimeoutMs(Duration timeoutMs) {
+		return CancellationToken(detail::Now() + timeoutMs);
+	}
+
+	bool CanBeCancelled() const {
+		return !!state_;
+	}
+
+	void Cancel() const {
+		WEBDRIVERXX_CHECK(state_, "Token cannot be cancelled");
+		state_->cancelled = true;
+	}
+
+	bool IsCancelled() const {
+		return state_ && (state_->cancelled ||
+			(state_->deadline && detail::Now() >= state_->deadline));
+	}
+
+	// 0 if there is no deadline.
+	TimePoint GetDeadline() const {
+		return state_ ? state_->deadline : 0;
+	}
+
+private:
+	explicit CancellationToken(TimePoint deadline)
+		: state_(std::make_shared<detail::CancellationState>(deadline))
+	{}
+
+private:
+	std::shared_ptr<detail::CancellationState> state_;
+};
+
+namespace detail {
+
+struct CancellationScopeNode {
+	const CancellationToken* token;
+	const CancellationScopeNode* outer;
+};
+
+inline
+const CancellationScopeNode*& GetCancellationScopeHead() {
+	static thread_local const CancellationScopeNode* head = nullptr;
+	return head;
+}
+
+// Shortens a delay so that it ends before the deadline (0 means none).
+inline
+Duration LimitToDeadline(Duration milliseconds, TimePoint deadline) {
+	if (!deadline)
+		return milliseconds;
+	const TimePoint now = Now();
+	return deadline <= now ? 0 :
+		deadline - now < milliseconds ? static_cast<Duration>(deadline - now) : milliseconds;
+}
+
+} // namespace detail
+
+// Tokens that apply to the current thread. Used to carry
+// them over to another thread, see CancellationScope.
+class CancellationContext { // copyable
+public:
+	static CancellationContext Capture() {
+		CancellationContext result;
+		for (auto node = detail::GetCancellationScopeHead(); node; node = node->outer)
+			result.tokens_.push_back(*node->token);
+		return result;
+	}
+
+	void Add(const CancellationToken& token) {
+		if (token.CanBeCancelled())
+			tokens_.push_back(token);
+	}
+
+	bool IsEmpty() const {
+		return tokens_.empty();
+	}
+
+	bool IsCancelled() const {
+		for (const auto& token : tokens_)
+			if (token.IsCancelled())
+				return true;
+		return false;
+	}
+
+	// The earliest deadline, 0 if there is none.
+	TimePoint GetDeadline() const {
+		TimePoint result = 0;
+		for (const auto& token : tokens_) {
+			const TimePoint deadline = token.GetDeadline();
+			if (deadline && (!result || deadline < result))
+				result = deadline;
+		}
+		return result;
+	}
+
+	void ThrowIfCancelled() const {
+		WEBDRIVERXX_CHECK(!IsCancelled(), "Operation is cancelled or its deadline is exceeded");
+	}
+
+	const std::vector<CancellationToken>& GetTokens() const {
+		return tokens_;
+	}
+
+private:
+	std::vector<CancellationToken> tokens_;
+};
+
+namespace detail {
+
+// Hides all cancellation scopes of the current thread until the end
+// of the scope. For cleanup that must not be stopped.
+class CancellationMask { // noncopyable
+public:
+	CancellationMask()
+		: outer_(GetCancellationScopeHead())
+	{
+		GetCancellationScopeHead() = nullptr;
+	}
+
+	~CancellationMask() {
+		GetCancellationScopeHead() = outer_;
+	}
+
+private:
+	CancellationMask(CancellationMask&);
+	CancellationMask& operator = (CancellationMask&);
+
+private:
+	const CancellationScopeNode *const outer_;
+};
+
+} // namespace detail
+
+// Applies tokens to all commands and waits called from the current
+// thread until the end of the scope. Scopes can be nested, commands
+// stop when any of the tokens is cancelled.
+class CancellationScope { // noncopyable
+public:
+	explicit CancellationScope(const CancellationToken& token)
+		: outer_(detail::GetCancellationScopeHead())
+	{
+		CancellationContext context;
+		context.Add(token);
+		Install(context);
+	}
+
+	// Reinstalls tokens captured in another thread.
+	explicit CancellationScope(const CancellationContext& context)
+		: outer_(detail::GetCancellationScopeHead())
+	{
+		Install(context);
+	}
+
+	~CancellationScope() {
+		detail::GetCancellationScopeHead() = outer_;
+	}
+
+private:
+	void Install(const CancellationContext& context) {
+		tokens_ = context.GetTokens();
+		nodes_.resize(tokens_.size());
+		const detail::CancellationScopeNode* head = outer_;
+		for (size_t i = 0; i < tokens_.size(); ++i) {
+			nodes_[i].token = &tokens_[i];
+			nodes_[i].outer = head;
+			head = &nodes_[i];
+		}
+		detail::GetCancellationScopeHead() = head;
+	}
+
+	CancellationScope(CancellationScope&);
+	CancellationScope& operator = (CancellationScope&);
+
+private:
+	const detail::CancellationScopeNode *const outer_;
+	std::vector<CancellationToken> tokens_;
+	std::vector<detail::CancellationScopeNode> nodes_;
+};
+
+} // namespace webdriverxx
+
+#endif
@@ -3,8 +3,13 @@
 
 #include "session.h"
 #include "capabilities.h"
+#include "connection_options.h"
+#include "metrics.h"
+#include "retry.h"
+#include "session_reaper.h"
 #include "detail/resource.h"
 #include "detail/http_connection.h"
+#include "detail/http_multiplexer.h"
 #include <picojson.h>
 #include <string>
 #include <vector>
@@ -17,10 +22,26 @@ const char *const kDefaultWebDriverUrl = "http://localhost:4444/wd/hub/";
 class Client { // copyable
 public:
 	explicit Client(const std::string& url = kDefaultWebDriverUrl);
+	Client(const std::string& url, const ConnectionOptions& options);
+	// Sends all requests through a custom transport.
+	Client(const std::string& url, const detail::Shared<detail::IHttpClient>& http_client);
 	virtual ~Client() {}
 
 	picojson::object GetStatus() const;
 
+	// Applies to this client and all its sessions.
+	const Client& SetRetryPolicy(const RetryPolicy& policy) const;
+	RetryPolicy GetRetryPolicy() const;
+
+	// Sessions of this client are deleted by the reaper in background
+	// instead of by the thread that releases their last copy.
+	// An empty reaper brings back synchronous deletion.
+	const Client& SetSessionReaper(const detail::Shared<SessionReaper>& reaper) const;
+	detail::Shared<SessionReaper> GetSessionReaper() const;
+
+	// Counters of this client and all its sessions.
+	Metrics GetMetrics() const;
+
 	// Returns existing sessions.
 	std::vector<Session> GetSessions() const;
 
@@ -30,7 +51,24 @@ public:
 		const Capabilities& required
 		) const;
 
+	// Creates a session that is not deleted with its last copy, so it can
+	// outlive the process. Use Session::DeleteSession() to delete it.
+	Session CreatePersistentSession(
+		const Capabilities& desired,
+		const Capabilities& required
+		) const;
+
+	// Gives access to an existing session without taking ownership of it.
+	// Doesn't check that the session exists.
+	Session AttachSession(const std::string& id) const;
+
 private:
+	Session InternalCreateSession(
+		const Capabilities& desired,
+		const Capabilities& required,
+		detail::Resource::Ownership mode
+		) const;
+
 	Session MakeSession(
 		const std::string& id,
 		detail::Resource::Ownership mode
@@ -5,13 +5,53 @@
 #include <algorithm>
 
 namespace webdriverxx {
+namespace detail {
+
+inline
+Shared<IHttpClient> MakeHttpClient(const ConnectionOptions& options) {
+	if (options.http_version == http_version::Http11)
+		return Shared<IHttpClient>(new HttpConnection(options));
+	#if WEBDRIVERXX_HAS_HTTP_MULTIPLEXER
+		return Shared<IHttpClient>(new HttpMultiplexer(options));
+	#else
+		WEBDRIVERXX_THROW("HTTP/2 requires libcurl 7.49.0 or newer");
+	#endif
+}
+
+// Accepts "unix:/path/to/socket" and "unix:/path/to/socket:/base/path/"
+// URLs in addition to HTTP ones.
+inline
+Shared<Resource> MakeRootResource(const std::string& url, ConnectionOptions options) {
+	const std::string kUnixScheme = "unix:";
+	if (url.compare(0, kUnixScheme.size(), kUnixScheme) != 0)
+		return Shared<Resource>(new RootResource(url, MakeHttpClient(options)));
+	const size_t path_end = url.find(':', kUnixScheme.size());
+	options.unix_socket_path = url.substr(kUnixScheme.size(), path_end - kUnixScheme.size());
+	WEBDRIVERXX_CHECK(!options.unix_socket_path.empty(), Fmt()
+		<< "Unix socket path is missing in URL " << url);
+	const std::string base_path = path_end == std::string::npos ? "/" : url.substr(path_end + 1);
+	// The host is only used for the Host header
+	return Shared<Resource>(new RootResource("http://localhost" + base_path, MakeHttpClient(options)));
+}
+
+} // namespace detail
 
 inline
 Client::Client(const std::string& url)
-	: resource_(new detail::RootResource(
-		url,
-		detail::Shared<detail::IHttpClient>(new detail::HttpConnection)
-		))
+	: resource_(detail::MakeRootResource(url, ConnectionOptions()))
+{}
+
+inline
+Client::Client(const std::string& url, const ConnectionOptions& options)
+	: resource_(detail::MakeRootResource(url, options))
+{}
+
+inline
+Client::Client(
+	const std::string& url,
+	const detail::Shared<detail::IHttpClient>& http_client
+	)
+	: resource_(new detail::RootResource(url, http_client))
 {}
 
 inline
@@ -23,6 +63,33 @@ picojson::object Client::GetStatus() const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_END()
 }
 
+inline
+const Client& Client::SetRetryPolicy(const RetryPolicy& policy) const {
+	resource_->GetTransport()->SetRetryPolicy(policy);
+	return *this;
+}
+
+inline
+RetryPolicy Client::GetRetryPolicy() const {
+	return resource_->GetTransport()->GetRetryPolicy();
+}
+
+inline
+const Client& Client::SetSessionReaper(const detail::Shared<SessionReaper>& reaper) const {
+	resource_->GetTransport()->SetSessionReaper(reaper);
+	return *this;
+}
+
+inline
+detail::Shared<SessionReaper> Client::GetSessionReaper() const {
+	return resource_->GetTransport()->GetSessionReaper();
+}
+
+inline
+Metrics Client::GetMetrics() const {
+	return resource_->GetTransport()->GetMetrics()->GetSnapshot();
+}
+
 inline
 std::vector<Session> Client::GetSessions() const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
@@ -45,6 +112,30 @@ Session Client::CreateSession(
 	const Capabilities& desired,
 	const Capabilities& required
 	) const {
+	return InternalCreateSession(desired, required, detail::Resource::IsOwner);
+}
+
+inline
+Session Client::CreatePersistentSession(
+	const Capabilities& desired,
+	const Capabilities& required
+	) const {
+	return InternalCreateSession(desired, required, detail::Resource::IsObserver);
+}
+
+inline
+Session Client::AttachSession(const std::string& id) const {
+	WEBDRIVERXX_CHECK(!id.empty() && id.find('/') == std::string::npos, detail::Fmt()
+		<< "Invalid session ID (" << id << ")");
+	return MakeSession(id, detail::Resource::IsObserver);
+}
+
+inline
+Session Client::InternalCreateSession(
+	const Capabilities& desired,
+	const Capabilities& required,
+	detail::Resource::Ownership mode
+	) const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
 	const auto response = resource_->Post("session",
 		JsonObject()
@@ -57,7 +148,7 @@ Session Client::CreateSession(
 	
 	const auto sessionId = response.get("sessionId").to_str();
 	
-	return MakeSession(sessionId, detail::Resource::IsOwner);
+	return MakeSession(sessionId, mode);
 	WEBDRIVERXX_FUNCTION_CONTEXT_END()
 }
 
@@ -0,0 +1,65 @@
+#ifndef WEBDRIVERXX_CONNECTION_OPTIONS_H
+#define WEBDRIVERXX_CONNECTION_OPTIONS_H
+
+#include <cstddef>
+#include <string>
+
+namespace webdriverxx {
+namespace http_version {
+
+enum Value {
+	// A pool of HTTP/1.1 connections, one request per connection at a time.
+	Http11,
+	// A single connection shared by all concurrent requests. Uses HTTP/2
+	// over TLS (ALPN) or h2c upgrade, falls back to HTTP/1.1 if the server
+	// doesn't support HTTP/2.
+	Http2,
+	// Same as Http2 but speaks HTTP/2 right away, without upgrade.
+	// For plain-text (h2c) servers known to support HTTP/2.
+	Http2PriorKnowledge
+};
+
+} // namespace http_version
+
+struct ConnectionOptions {
+	http_version::Value http_version;
+	// Connects to a Unix domain socket instead of the host and port
+	// from the URL. For drivers running on the same machine.
+	std::string unix_socket_path;
+	// Asks the server to compress responses with any encoding
+	// libcurl supports: gzip, deflate and, if built with it, brotli.
+	bool accept_compressed_responses;
+	// Request bodies of at least this many bytes are sent gzipped,
+	// 0 means never. Requires WEBDRIVERXX_ENABLE_ZLIB and zlib.
+	size_t request_compression_threshold;
+
+	ConnectionOptions()
+		: http_version(http_version::Http11)
+		, accept_compressed_responses(false)
+		, request_compression_threshold(0)
+	{}
+
+	ConnectionOptions& SetHttpVersion(http_version::Value value) {
+		http_version = value;
+		return *this;
+	}
+
+	ConnectionOptions& SetUnixSocketPath(const std::string& value) {
+		unix_socket_path = value;
+		return *this;
+	}
+
+	ConnectionOptions& SetAcceptCompressedResponses(bool value) {
+		accept_compressed_responses = value;
+		return *this;
+	}
+
+	ConnectionOptions& SetRequestCompressionThreshold(size_t bytes) {
+		request_compression_threshold = bytes;
+		return *this;
+	}
+};
+
+} // namespace webdriverxx
+
+#endif
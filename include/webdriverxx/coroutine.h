@@ -0,0 +1,217 @@
+#ifndef WEBDRIVERXX_COROUTINE_H
+#define WEBDRIVERXX_COROUTINE_H
+
+// C++20 coroutine API. Everything below is available only if
+// the compiler supports coroutines, check WEBDRIVERXX_HAS_COROUTINES.
+
+#if defined(__cpp_impl_coroutine)
+	#if __cpp_impl_coroutine >= 201902L
+		#define WEBDRIVERXX_HAS_COROUTINES 1
+	#endif
+#endif
+
+#ifndef WEBDRIVERXX_HAS_COROUTINES
+	#define WEBDRIVERXX_HAS_COROUTINES 0
+#endif
+
+#if WEBDRIVERXX_HAS_COROUTINES
+
+#include "session.h"
+#include "element.h"
+#include "by.h"
+#include "keys.h"
+#include "js_args.h"
+#include "cancellation.h"
+#include "types.h"
+#include "wait.h"
+#include "detail/shared.h"
+#include "detail/task.h"
+#include "detail/thread_pool.h"
+#include "detail/timer_wheel.h"
+#include <coroutine>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+const size_t kDefaultSchedulerThreads = 4;
+
+namespace detail {
+
+struct ResumeAwaiter {
+	Shared<ThreadPool> pool;
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle) const {
+		pool->Post([handle]{ handle.resume(); });
+	}
+
+	void await_resume() const noexcept {}
+};
+
+struct DelayAwaiter {
+	Shared<ThreadPool> pool;
+	Shared<TimerWheel> timers;
+	Duration milliseconds;
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle) const {
+		// The awaiter may be gone as soon as the timer is scheduled
+		const Shared<ThreadPool> pool = this->pool;
+		const Shared<TimerWheel> timers = this->timers;
+		timers->Schedule(milliseconds, [pool, handle]{
+			pool->Post([handle]{ handle.resume(); });
+		});
+	}
+
+	void await_resume() const noexcept {}
+};
+
+// Runs a blocking function on the pool and then resumes the awaiting coroutine.
+template<typename T, typename Function>
+class CallAwaiter {
+public:
+	CallAwaiter(const Shared<ThreadPool>& pool, Function function)
+		: pool_(pool)
+		, function_(std::move(function))
+	{}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		pool_->Post([this, handle]{
+			CallAndStore(outcome_, function_);
+			handle.resume();
+		});
+	}
+
+	T await_resume() {
+		return outcome_.Get();
+	}
+
+private:
+	Shared<ThreadPool> pool_;
+	Function function_;
+	Outcome<T> outcome_;
+};
+
+} // namespace detail
+
+// Runs coroutine flows on a small fixed number of threads.
+// Suspended flows don't occupy threads.
+class Scheduler { // copyable
+public:
+	explicit Scheduler(size_t threads = kDefaultSchedulerThreads);
+
+	size_t GetThreadCount() const;
+
+	// Starts the flow on a scheduler thread. The future becomes ready
+	// when the flow finishes. Keep the scheduler alive until then.
+	template<typename T>
+	std::future<T> Spawn(Task<T> flow) const;
+
+	// Moves the awaiting flow to a scheduler thread.
+	detail::ResumeAwaiter Resume() const;
+
+	// Suspends the awaiting flow without blocking a thread.
+	detail::DelayAwaiter Delay(Duration milliseconds) const;
+
+	// Calls a blocking function and resumes the awaiting flow with its result.
+	template<typename Function>
+	auto Execute(Function function) const
+		-> detail::CallAwaiter<decltype(function()), Function>;
+
+private:
+	detail::Shared<detail::ThreadPool> pool_;
+	detail::Shared<detail::TimerWheel> timers_;
+};
+
+// Awaitable counterpart of Element.
+class CoElement { // copyable
+public:
+	CoElement();
+	CoElement(const Element& element, const Scheduler& scheduler);
+
+	const Element& GetElement() const;
+
+	Task<bool> IsDisplayed() const;
+	Task<bool> IsEnabled() const;
+	Task<bool> IsSelected() const;
+	Task<Point> GetLocation() const;
+	Task<Size> GetSize() const;
+	Task<std::string> GetAttribute(const std::string& name) const;
+	Task<std::string> GetCssProperty(const std::string& name) const;
+	Task<std::string> GetTagName() const;
+	Task<std::string> GetText() const;
+
+	Task<CoElement> FindElement(const By& by) const;
+	Task<std::vector<CoElement>> FindElements(const By& by) const;
+
+	Task<> Clear() const;
+	Task<> Click() const;
+	Task<> Submit() const;
+	Task<> SendKeys(const std::string& keys) const;
+	Task<> SendKeys(const Shortcut& shortcut) const;
+
+private:
+	Element element_;
+	Scheduler scheduler_;
+};
+
+// Awaitable counterpart of Session.
+class CoSession { // copyable
+public:
+	CoSession(const Session& session, const Scheduler& scheduler);
+
+	const Session& GetSession() const;
+	const Scheduler& GetScheduler() const;
+	CoElement Wrap(const Element& element) const;
+
+	Task<std::string> GetSource() const;
+	Task<std::string> GetTitle() const;
+	Task<std::string> GetUrl() const;
+	Task<std::string> GetScreenshot() const; // Base64 PNG
+
+	Task<> Navigate(const std::string& url) const;
+
+	Task<> Execute(const std::string& script, const JsArgs& args = JsArgs()) const;
+	template<typename T>
+	Task<T> Eval(const std::string& script, const JsArgs& args = JsArgs()) const;
+
+	Task<CoElement> FindElement(const By& by) const;
+	Task<std::vector<CoElement>> FindElements(const By& by) const;
+
+private:
+	Session session_;
+	Scheduler scheduler_;
+};
+
+// Awaitable counterparts of WaitForValue and WaitUntil.
+// Getter is called on a scheduler thread, the flow sleeps between attempts
+// without blocking a thread.
+template<typename Getter>
+auto CoWaitForValue(
+	const Scheduler& scheduler,
+	Getter getter,
+	Duration timeoutMs = 5000,
+	Duration intervalMs = 50
+	) -> Task<decltype(getter())>;
+
+template<typename Getter>
+auto CoWaitUntil(
+	const Scheduler& scheduler,
+	Getter getter,
+	Duration timeoutMs = 5000,
+	Duration intervalMs = 50
+	) -> Task<decltype(getter())>;
+
+} // namespace webdriverxx
+
+#include "coroutine.inl"
+
+#endif // WEBDRIVERXX_HAS_COROUTINES
+
+#endif
@@ -0,0 +1,349 @@
+#include "detail/error_handling.h"
+#include "detail/time.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace webdriverxx {
+
+inline
+Scheduler::Scheduler(size_t threads)
+	: pool_(new detail::ThreadPool(threads))
+	, timers_(new detail::TimerWheel)
+{}
+
+inline
+size_t Scheduler::GetThreadCount() const {
+	return pool_->GetSize();
+}
+
+template<typename T>
+std::future<T> Scheduler::Spawn(Task<T> flow) const {
+	const auto result = std::make_shared<std::promise<T>>();
+	auto future = result->get_future();
+	detail::RunDetached(Resume(), std::move(flow), result);
+	return future;
+}
+
+inline
+detail::ResumeAwaiter Scheduler::Resume() const {
+	const detail::ResumeAwaiter result = { pool_ };
+	return result;
+}
+
+inline
+detail::DelayAwaiter Scheduler::Delay(Duration milliseconds) const {
+	const detail::DelayAwaiter result = { pool_, timers_, milliseconds };
+	return result;
+}
+
+template<typename Function>
+auto Scheduler::Execute(Function function) const
+	-> detail::CallAwaiter<decltype(function()), Function> {
+	return detail::CallAwaiter<decltype(function()), Function>(pool_, std::move(function));
+}
+
+namespace detail {
+
+// Arguments are copied into the coroutine frame, so the returned
+// task doesn't depend on the lifetime of the object that created it.
+// The caller's CancellationScope is captured when the task is created.
+// Awaiters are named locals here and below: some compilers (GCC 12)
+// destroy non-trivial temporaries of a co_await operand twice.
+template<typename Function>
+auto CoCall(Scheduler scheduler, Function function) -> Task<decltype(function())> {
+	auto call = scheduler.Execute([function, cancellation = CancellationContext::Capture()]{
+		const CancellationScope scope(cancellation);
+		return function();
+	});
+	co_return co_await call;
+}
+
+inline
+std::vector<CoElement> WrapCoElements(
+	const std::vector<Element>& elements,
+	const Scheduler& scheduler
+	) {
+	std::vector<CoElement> result;
+	result.reserve(elements.size());
+	std::transform(elements.begin(), elements.end(), std::back_inserter(result),
+		[&scheduler](const Element& element) {
+			return CoElement(element, scheduler);
+		});
+	return result;
+}
+
+template<typename Value, typename DescriptiveGetter>
+Task<Value> CoWait(
+	Scheduler scheduler,
+	DescriptiveGetter getter,
+	Duration timeoutMs,
+	Duration intervalMs
+	) {
+	const TimePoint timeout = Now() + timeoutMs;
+	for (;;) {
+		auto attempt = scheduler.Execute([&getter]{ return getter(nullptr); });
+		auto value_ptr = co_await attempt;
+		if (value_ptr)
+			co_return std::move(*value_ptr);
+		if (Now() >= timeout) {
+			std::string description;
+			auto last_attempt = scheduler.Execute([&getter, &description]{
+				return getter(&description);
+			});
+			value_ptr = co_await last_attempt;
+			if (value_ptr)
+				co_return std::move(*value_ptr);
+			throw WebDriverException(Fmt()
+				<< "Timeout after " << timeoutMs << "ms of waiting, last attempt returned: "
+				<< description
+				);
+		}
+		const auto delay = scheduler.Delay(intervalMs);
+		co_await delay;
+	}
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////
+
+inline
+CoElement::CoElement() {}
+
+inline
+CoElement::CoElement(const Element& element, const Scheduler& scheduler)
+	: element_(element)
+	, scheduler_(scheduler)
+{}
+
+inline
+const Element& CoElement::GetElement() const {
+	return element_;
+}
+
+inline
+Task<bool> CoElement::IsDisplayed() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.IsDisplayed(); });
+}
+
+inline
+Task<bool> CoElement::IsEnabled() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.IsEnabled(); });
+}
+
+inline
+Task<bool> CoElement::IsSelected() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.IsSelected(); });
+}
+
+inline
+Task<Point> CoElement::GetLocation() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.GetLocation(); });
+}
+
+inline
+Task<Size> CoElement::GetSize() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.GetSize(); });
+}
+
+inline
+Task<std::string> CoElement::GetAttribute(const std::string& name) const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element, name]{ return element.GetAttribute(name); });
+}
+
+inline
+Task<std::string> CoElement::GetCssProperty(const std::string& name) const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element, name]{ return element.GetCssProperty(name); });
+}
+
+inline
+Task<std::string> CoElement::GetTagName() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.GetTagName(); });
+}
+
+inline
+Task<std::string> CoElement::GetText() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ return element.GetText(); });
+}
+
+inline
+Task<CoElement> CoElement::FindElement(const By& by) const {
+	const Element element = element_;
+	const Scheduler scheduler = scheduler_;
+	return detail::CoCall(scheduler_, [element, scheduler, by]{
+		return CoElement(element.FindElement(by), scheduler);
+	});
+}
+
+inline
+Task<std::vector<CoElement>> CoElement::FindElements(const By& by) const {
+	const Element element = element_;
+	const Scheduler scheduler = scheduler_;
+	return detail::CoCall(scheduler_, [element, scheduler, by]{
+		return detail::WrapCoElements(element.FindElements(by), scheduler);
+	});
+}
+
+inline
+Task<> CoElement::Clear() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ element.Clear(); });
+}
+
+inline
+Task<> CoElement::Click() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ element.Click(); });
+}
+
+inline
+Task<> CoElement::Submit() const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element]{ element.Submit(); });
+}
+
+inline
+Task<> CoElement::SendKeys(const std::string& keys) const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element, keys]{ element.SendKeys(keys); });
+}
+
+inline
+Task<> CoElement::SendKeys(const Shortcut& shortcut) const {
+	const Element element = element_;
+	return detail::CoCall(scheduler_, [element, shortcut]{ element.SendKeys(shortcut); });
+}
+
+///////////////////////////////////////////////////////////////////
+
+inline
+CoSession::CoSession(const Session& session, const Scheduler& scheduler)
+	: session_(session)
+	, scheduler_(scheduler)
+{}
+
+inline
+const Session& CoSession::GetSession() const {
+	return session_;
+}
+
+inline
+const Scheduler& CoSession::GetScheduler() const {
+	return scheduler_;
+}
+
+inline
+CoElement CoSession::Wrap(const Element& element) const {
+	return CoElement(element, scheduler_);
+}
+
+inline
+Task<std::string> CoSession::GetSource() const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session]{ return session.GetSource(); });
+}
+
+inline
+Task<std::string> CoSession::GetTitle() const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session]{ return session.GetTitle(); });
+}
+
+inline
+Task<std::string> CoSession::GetUrl() const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session]{ return session.GetUrl(); });
+}
+
+inline
+Task<std::string> CoSession::GetScreenshot() const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session]{ return session.GetScreenshot(); });
+}
+
+inline
+Task<> CoSession::Navigate(const std::string& url) const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session, url]{ session.Navigate(url); });
+}
+
+inline
+Task<> CoSession::Execute(const std::string& script, const JsArgs& args) const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session, script, args]{ session.Execute(script, args); });
+}
+
+template<typename T>
+Task<T> CoSession::Eval(const std::string& script, const JsArgs& args) const {
+	const Session session = session_;
+	return detail::CoCall(scheduler_, [session, script, args]{
+		return session.Eval<T>(script, args);
+	});
+}
+
+inline
+Task<CoElement> CoSession::FindElement(const By& by) const {
+	const Session session = session_;
+	const Scheduler scheduler = scheduler_;
+	return detail::CoCall(scheduler_, [session, scheduler, by]{
+		return CoElement(session.FindElement(by), scheduler);
+	});
+}
+
+inline
+Task<std::vector<CoElement>> CoSession::FindElements(const By& by) const {
+	const Session session = session_;
+	const Scheduler scheduler = scheduler_;
+	return detail::CoCall(scheduler_, [session, scheduler, by]{
+		return detail::WrapCoElements(session.FindElements(by), scheduler);
+	});
+}
+
+///////////////////////////////////////////////////////////////////
+
+template<typename Getter>
+auto CoWaitForValue(
+	const Scheduler& scheduler,
+	Getter getter,
+	Duration timeoutMs,
+	Duration intervalMs
+	) -> Task<decltype(getter())> {
+	typedef decltype(getter()) Value;
+	return detail::CoWait<Value>(scheduler,
+		[getter](std::string* description) {
+			return detail::TryToCallGetter<Value>(getter, description);
+		},
+		timeoutMs, intervalMs);
+}
+
+template<typename Getter>
+auto CoWaitUntil(
+	const Scheduler& scheduler,
+	Getter getter,
+	Duration timeoutMs,
+	Duration intervalMs
+	) -> Task<decltype(getter())> {
+	typedef decltype(getter()) Value;
+	return detail::CoWait<Value>(scheduler,
+		[getter](std::string* description) -> std::unique_ptr<Value> {
+			auto value_ptr = detail::TryToCallGetter<Value>(getter, description);
+			if (!value_ptr || !!*value_ptr)
+				return value_ptr;
+			if (description)
+				*description = "Value is falsy";
+			value_ptr.reset();
+			return value_ptr;
+		}, timeoutMs, intervalMs);
+}
+
+} // namespace webdriverxx
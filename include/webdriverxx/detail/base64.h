@@ -0,0 +1,73 @@
+#ifndef WEBDRIVERXX_DETAIL_BASE64_H
+#define WEBDRIVERXX_DETAIL_BASE64_H
+
+#include "error_handling.h"
+#include <cstddef>
+#include <string>
+
+namespace webdriverxx {
+namespace detail {
+
+inline
+std::string DecodeBase64(const std::string& text) {
+	std::string result;
+	result.reserve(text.size() / 4 * 3);
+	unsigned bits = 0;
+	int count = 0;
+	for (const char c : text) {
+		int digit;
+		if (c >= 'A' && c <= 'Z') digit = c - 'A';
+		else if (c >= 'a' && c <= 'z') digit = c - 'a' + 26;
+		else if (c >= '0' && c <= '9') digit = c - '0' + 52;
+		else if (c == '+' || c == '-') digit = 62;
+		else if (c == '/' || c == '_') digit = 63;
+		else if (c == '=') break;
+		else if (c == '\r' || c == '\n' || c == ' ') continue;
+		else WEBDRIVERXX_THROW("Invalid base64 character");
+		bits = (bits << 6) | static_cast<unsigned>(digit);
+		if (++count == 4) {
+			result += static_cast<char>((bits >> 16) & 0xFF);
+			result += static_cast<char>((bits >> 8) & 0xFF);
+			result += static_cast<char>(bits & 0xFF);
+			bits = 0;
+			count = 0;
+		}
+	}
+	WEBDRIVERXX_CHECK(count != 1, "Truncated base64 data");
+	if (count == 2)
+		result += static_cast<char>((bits >> 4) & 0xFF);
+	if (count == 3) {
+		result += static_cast<char>((bits >> 10) & 0xFF);
+		result += static_cast<char>((bits >> 2) & 0xFF);
+	}
+	return result;
+}
+
+// Appends four digits for one to three bytes, padded with '='.
+inline
+void EncodeBase64Group(const unsigned char* bytes, size_t count, std::string& out) {
+	static const char digits[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	const unsigned bits = (bytes[0] << 16)
+		| (count > 1 ? bytes[1] << 8 : 0)
+		| (count > 2 ? bytes[2] : 0);
+	out += digits[(bits >> 18) & 0x3F];
+	out += digits[(bits >> 12) & 0x3F];
+	out += count > 1 ? digits[(bits >> 6) & 0x3F] : '=';
+	out += count > 2 ? digits[bits & 0x3F] : '=';
+}
+
+inline
+std::string EncodeBase64(const std::string& data) {
+	std::string result;
+	result.reserve((data.size() + 2) / 3 * 4);
+	const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(data.data());
+	for (size_t i = 0; i < data.size(); i += 3)
+		EncodeBase64Group(bytes + i, data.size() - i < 3 ? data.size() - i : 3, result);
+	return result;
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,1121 @@
+#ifndef WEBDRIVERXX_DETAIL_DOM_QUERY_H
+#define WEBDRIVERXX_DETAIL_DOM_QUERY_H
+
+#include "error_handling.h"
+#include "../by.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+const size_t kNoDomNode = static_cast<size_t>(-1); // Also stands for the document
+
+struct DomNode {
+	size_t parent; // kNoDomNode for the top element
+	size_t end; // One past the last descendant
+	size_t previous_sibling; // Element, kNoDomNode if there is none
+	bool is_text;
+	bool visible;
+	bool block; // Not inline, so its text goes on separate lines
+	size_t ordinal; // Among elements in document order
+	std::string name; // Lower case tag name, or the text of a text node
+	std::vector<std::pair<std::string, std::string>> attributes; // Lower case names
+
+	DomNode()
+		: parent(kNoDomNode)
+		, end(0)
+		, previous_sibling(kNoDomNode)
+		, is_text(false)
+		, visible(false)
+		, block(false)
+		, ordinal(0)
+	{}
+};
+
+inline
+std::string ToLowerAscii(std::string value) {
+	for (auto& c : value)
+		if (c >= 'A' && c <= 'Z')
+			c = static_cast<char>(c - 'A' + 'a');
+	return value;
+}
+
+inline
+bool IsXmlSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+inline
+std::string NormalizeSpace(const std::string& value) {
+	std::string result;
+	bool space = false;
+	for (const char c : value) {
+		if (IsXmlSpace(c)) {
+			space = !result.empty();
+		} else {
+			if (space)
+				result += ' ';
+			result += c;
+			space = false;
+		}
+	}
+	return result;
+}
+
+// Nodes of a document in document order, children right after their parent.
+class DomTree { // copyable
+public:
+	std::vector<DomNode> nodes;
+
+	// Computes ends and siblings once all nodes are added.
+	void Link() {
+		for (size_t i = nodes.size(); i-- > 0;) {
+			nodes[i].end = std::max(nodes[i].end, i + 1);
+			if (nodes[i].parent != kNoDomNode)
+				nodes[nodes[i].parent].end = std::max(nodes[nodes[i].parent].end, nodes[i].end);
+		}
+		std::vector<size_t> last_child(nodes.size() + 1, kNoDomNode);
+		size_t ordinal = 0;
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].is_text)
+				continue;
+			nodes[i].ordinal = ordinal++;
+			size_t& last = last_child[nodes[i].parent == kNoDomNode ? nodes.size() : nodes[i].parent];
+			nodes[i].previous_sibling = last;
+			last = i;
+		}
+	}
+
+	const std::string* FindAttribute(size_t node, const std::string& name) const {
+		for (const auto& attribute : nodes[node].attributes)
+			if (attribute.first == name)
+				return &attribute.second;
+		return nullptr;
+	}
+
+	bool HasClass(size_t node, const std::string& name) const {
+		const std::string* classes = FindAttribute(node, "class");
+		if (!classes || name.empty())
+			return false;
+		for (size_t begin = 0; begin < classes->size();) {
+			size_t end = begin;
+			while (end < classes->size() && !IsXmlSpace((*classes)[end]))
+				++end;
+			if (classes->compare(begin, end - begin, name) == 0 && end - begin == name.size())
+				return true;
+			begin = end + 1;
+		}
+		return false;
+	}
+
+	// Text of visible text nodes inside the node with collapsed whitespace
+	// and line breaks around blocks, close to what WebDriver returns.
+	std::string GetText(size_t node) const {
+		std::string text;
+		std::vector<size_t> block_ends;
+		for (size_t i = node + 1; i < nodes[node].end; ++i) {
+			for (; !block_ends.empty() && block_ends.back() <= i; block_ends.pop_back())
+				text += '\n';
+			if (nodes[i].is_text) {
+				if (nodes[nodes[i].parent].visible)
+					text += nodes[i].name;
+			} else if (nodes[i].visible && (nodes[i].block || nodes[i].name == "br")) {
+				text += '\n';
+				block_ends.push_back(nodes[i].end);
+			}
+		}
+		std::string result;
+		for (size_t begin = 0; begin <= text.size();) {
+			size_t end = text.find('\n', begin);
+			if (end == std::string::npos)
+				end = text.size();
+			const std::string line = NormalizeSpace(text.substr(begin, end - begin));
+			if (!line.empty())
+				result += (result.empty() ? "" : "\n") + line;
+			begin = end + 1;
+		}
+		return result;
+	}
+
+	// XPath string value: all text inside the node.
+	std::string GetStringValue(size_t node) const {
+		std::string result;
+		const size_t begin = node == kNoDomNode ? 0 : node + 1;
+		const size_t end = node == kNoDomNode ? nodes.size() : nodes[node].end;
+		for (size_t i = begin; i < end; ++i)
+			if (nodes[i].is_text)
+				result += nodes[i].name;
+		return result;
+	}
+
+	std::vector<std::string> GetChildTexts(size_t node) const {
+		std::vector<std::string> result;
+		ForEachChild(node, true, [&result, this](size_t child) {
+			result.push_back(nodes[child].name);
+		});
+		return result;
+	}
+
+	std::vector<size_t> GetChildren(size_t node) const {
+		std::vector<size_t> result;
+		ForEachChild(node, false, [&result](size_t child) {
+			result.push_back(child);
+		});
+		return result;
+	}
+
+	size_t GetNextSibling(size_t node) const {
+		const size_t parent_end = nodes[node].parent == kNoDomNode ?
+			nodes.size() : nodes[nodes[node].parent].end;
+		for (size_t i = nodes[node].end; i < parent_end; i = nodes[i].end)
+			if (!nodes[i].is_text)
+				return i;
+		return kNoDomNode;
+	}
+
+	// Elements inside the node (or the document) in document order.
+	std::vector<size_t> GetDescendants(size_t node) const {
+		std::vector<size_t> result;
+		const size_t begin = node == kNoDomNode ? 0 : node + 1;
+		const size_t end = node == kNoDomNode ? nodes.size() : nodes[node].end;
+		for (size_t i = begin; i < end; ++i)
+			if (!nodes[i].is_text)
+				result.push_back(i);
+		return result;
+	}
+
+private:
+	template<typename Function>
+	void ForEachChild(size_t node, bool texts, Function function) const {
+		const size_t begin = node == kNoDomNode ? 0 : node + 1;
+		const size_t end = node == kNoDomNode ? nodes.size() : nodes[node].end;
+		for (size_t i = begin; i < end; i = nodes[i].end)
+			if (nodes[i].is_text == texts)
+				function(i);
+	}
+};
+
+// Selectors: lists of compound selectors joined by descendant, child and
+// sibling combinators. Compounds: tag, #id, .class, [attr], [attr=value]
+// with = ~= |= ^= $= *=, :first-child, :last-child, :only-child and
+// :nth-child(n). Other pseudo-classes are rejected.
+class CssQuery { // copyable
+public:
+	explicit CssQuery(const std::string& selector)
+		: text_(selector)
+		, position_(0)
+	{
+		do {
+			selectors_.push_back(ParseComplex());
+		} while (Accept(','));
+		SkipSpaces();
+		CheckSyntax(position_ == text_.size());
+	}
+
+	bool Matches(const DomTree& tree, size_t node) const {
+		for (const auto& selector : selectors_)
+			if (MatchesComplex(tree, node, selector, selector.compounds.size() - 1))
+				return true;
+		return false;
+	}
+
+private:
+	struct AttributeTest {
+		std::string name;
+		char op; // 0 for presence
+		std::string value;
+	};
+
+	struct Compound {
+		std::string tag; // Empty for any
+		std::vector<std::string> ids;
+		std::vector<std::string> classes;
+		std::vector<AttributeTest> attributes;
+		std::vector<std::pair<std::string, int>> pseudo_classes;
+	};
+
+	struct Complex {
+		std::vector<Compound> compounds;
+		std::vector<char> combinators; // ' ', '>', '+' or '~' before each compound but the first
+	};
+
+	void CheckSyntax(bool condition) const {
+		WEBDRIVERXX_CHECK(condition, Fmt() << "Unsupported CSS selector (selector: " << text_
+			<< ", position: " << position_ << ")");
+	}
+
+	void SkipSpaces() {
+		while (position_ < text_.size() && IsXmlSpace(text_[position_]))
+			++position_;
+	}
+
+	bool Accept(char c) {
+		SkipSpaces();
+		if (position_ < text_.size() && text_[position_] == c) {
+			++position_;
+			return true;
+		}
+		return false;
+	}
+
+	static
+	bool IsNameChar(char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+			|| c == '-' || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+	}
+
+	std::string ParseName() {
+		std::string result;
+		while (position_ < text_.size()) {
+			const char c = text_[position_];
+			if (c == '\\' && position_ + 1 < text_.size()) {
+				result += text_[position_ + 1];
+				position_ += 2;
+			} else if (IsNameChar(c)) {
+				result += c;
+				++position_;
+			} else {
+				break;
+			}
+		}
+		CheckSyntax(!result.empty());
+		return result;
+	}
+
+	std::string ParseString() {
+		const char quote = text_[position_++];
+		std::string result;
+		while (position_ < text_.size() && text_[position_] != quote) {
+			if (text_[position_] == '\\' && position_ + 1 < text_.size())
+				++position_;
+			result += text_[position_++];
+		}
+		CheckSyntax(position_ < text_.size());
+		++position_;
+		return result;
+	}
+
+	Complex ParseComplex() {
+		Complex result;
+		SkipSpaces();
+		result.compounds.push_back(ParseCompound());
+		for (;;) {
+			const size_t before_spaces = position_;
+			SkipSpaces();
+			if (position_ == text_.size() || text_[position_] == ',')
+				break;
+			char combinator = ' ';
+			const char c = text_[position_];
+			if (c == '>' || c == '+' || c == '~') {
+				combinator = c;
+				++position_;
+				SkipSpaces();
+			} else {
+				CheckSyntax(position_ > before_spaces);
+			}
+			result.combinators.push_back(combinator);
+			result.compounds.push_back(ParseCompound());
+		}
+		return result;
+	}
+
+	Compound ParseCompound() {
+		Compound result;
+		const size_t start = position_;
+		if (position_ < text_.size() && text_[position_] == '*')
+			++position_;
+		else if (position_ < text_.size() && IsNameChar(text_[position_]))
+			result.tag = ToLowerAscii(ParseName());
+		while (position_ < text_.size()) {
+			const char c = text_[position_];
+			if (c == '#') {
+				++position_;
+				result.ids.push_back(ParseName());
+			} else if (c == '.') {
+				++position_;
+				result.classes.push_back(ParseName());
+			} else if (c == '[') {
+				++position_;
+				result.attributes.push_back(ParseAttributeTest());
+			} else if (c == ':') {
+				++position_;
+				result.pseudo_classes.push_back(ParsePseudoClass());
+			} else {
+				break;
+			}
+		}
+		CheckSyntax(position_ > start);
+		return result;
+	}
+
+	AttributeTest ParseAttributeTest() {
+		AttributeTest result;
+		SkipSpaces();
+		result.name = ToLowerAscii(ParseName());
+		result.op = 0;
+		SkipSpaces();
+		CheckSyntax(position_ < text_.size());
+		char c = text_[position_];
+		if (c == '~' || c == '|' || c == '^' || c == '$' || c == '*') {
+			result.op = c;
+			++position_;
+			CheckSyntax(position_ < text_.size() && text_[position_] == '=');
+			c = '=';
+		} else if (c == '=') {
+			result.op = '=';
+		}
+		if (result.op) {
+			++position_;
+			SkipSpaces();
+			CheckSyntax(position_ < text_.size());
+			result.value = text_[position_] == '"' || text_[position_] == '\'' ?
+				ParseString() : ParseName();
+		}
+		CheckSyntax(Accept(']'));
+		return result;
+	}
+
+	std::pair<std::string, int> ParsePseudoClass() {
+		const std::string name = ToLowerAscii(ParseName());
+		if (name == "first-child" || name == "last-child" || name == "only-child")
+			return std::make_pair(name, 0);
+		CheckSyntax(name == "nth-child" && Accept('('));
+		SkipSpaces();
+		const size_t start = position_;
+		while (position_ < text_.size() && text_[position_] >= '0' && text_[position_] <= '9')
+			++position_;
+		CheckSyntax(position_ > start);
+		const int number = std::atoi(text_.substr(start, position_ - start).c_str());
+		CheckSyntax(Accept(')'));
+		return std::make_pair(name, number);
+	}
+
+	static
+	bool MatchesAttribute(const std::string& actual, const AttributeTest& test) {
+		const std::string& expected = test.value;
+		switch (test.op) {
+		case 0: return true;
+		case '=': return actual == expected;
+		case '^': return !expected.empty() && actual.compare(0, expected.size(), expected) == 0;
+		case '$': return !expected.empty() && actual.size() >= expected.size()
+			&& actual.compare(actual.size() - expected.size(), expected.size(), expected) == 0;
+		case '*': return !expected.empty() && actual.find(expected) != std::string::npos;
+		case '|': return actual == expected || actual.compare(0, expected.size() + 1, expected + "-") == 0;
+		case '~': {
+			const std::string padded = " " + NormalizeSpace(actual) + " ";
+			return !expected.empty() && padded.find(" " + expected + " ") != std::string::npos;
+		}
+		}
+		return false;
+	}
+
+	static
+	bool MatchesCompound(const DomTree& tree, size_t node, const Compound& compound) {
+		if (node == kNoDomNode)
+			return false;
+		if (!compound.tag.empty() && tree.nodes[node].name != compound.tag)
+			return false;
+		for (const auto& id : compound.ids) {
+			const std::string* value = tree.FindAttribute(node, "id");
+			if (!value || *value != id)
+				return false;
+		}
+		for (const auto& name : compound.classes)
+			if (!tree.HasClass(node, name))
+				return false;
+		for (const auto& test : compound.attributes) {
+			const std::string* value = tree.FindAttribute(node, test.name);
+			if (!value || !MatchesAttribute(*value, test))
+				return false;
+		}
+		for (const auto& pseudo_class : compound.pseudo_classes) {
+			const bool first = tree.nodes[node].previous_sibling == kNoDomNode;
+			const bool last = tree.GetNextSibling(node) == kNoDomNode;
+			if (pseudo_class.first == "first-child" && !first)
+				return false;
+			if (pseudo_class.first == "last-child" && !last)
+				return false;
+			if (pseudo_class.first == "only-child" && !(first && last))
+				return false;
+			if (pseudo_class.first == "nth-child") {
+				int position = 1;
+				for (size_t i = tree.nodes[node].previous_sibling; i != kNoDomNode; i = tree.nodes[i].previous_sibling)
+					++position;
+				if (position != pseudo_class.second)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	static
+	bool MatchesComplex(const DomTree& tree, size_t node, const Complex& complex, size_t index) {
+		if (!MatchesCompound(tree, node, complex.compounds[index]))
+			return false;
+		if (index == 0)
+			return true;
+		switch (complex.combinators[index - 1]) {
+		case '>':
+			return MatchesComplex(tree, tree.nodes[node].parent, complex, index - 1);
+		case '+':
+			return MatchesComplex(tree, tree.nodes[node].previous_sibling, complex, index - 1);
+		case '~':
+			for (size_t i = tree.nodes[node].previous_sibling; i != kNoDomNode; i = tree.nodes[i].previous_sibling)
+				if (MatchesComplex(tree, i, complex, index - 1))
+					return true;
+			return false;
+		default:
+			for (size_t i = tree.nodes[node].parent; i != kNoDomNode; i = tree.nodes[i].parent)
+				if (MatchesComplex(tree, i, complex, index - 1))
+					return true;
+			return false;
+		}
+	}
+
+private:
+	std::string text_;
+	size_t position_;
+	std::vector<Complex> selectors_;
+};
+
+// Location paths with child, descendant, descendant-or-self, self, parent,
+// ancestor and sibling axes, element name tests and predicates. Predicates
+// support positions, last(), position(), @attr, text(), relative paths,
+// = != < > <= >=, and, or, not(), contains(), starts-with(),
+// normalize-space(), string-length(), concat(), true() and false().
+class XPathQuery { // copyable
+public:
+	explicit XPathQuery(const std::string& path)
+		: text_(path)
+		, position_(0)
+	{
+		steps_ = ParsePath();
+		SkipSpaces();
+		CheckSyntax(position_ == text_.size() && !steps_.empty());
+	}
+
+	// Elements the path selects from the context node in document order.
+	std::vector<size_t> Evaluate(const DomTree& tree, size_t context) const {
+		std::vector<size_t> result = EvaluatePath(tree, context, steps_);
+		result.erase(std::remove(result.begin(), result.end(), kNoDomNode), result.end());
+		return result;
+	}
+
+private:
+	enum Axis { Root, Child, Descendant, DescendantOrSelf, Self, Parent, Ancestor,
+		FollowingSibling, PrecedingSibling };
+
+	struct Expression;
+	typedef std::shared_ptr<Expression> ExpressionPtr;
+
+	struct Step {
+		Axis axis;
+		std::string name; // "*" for any element, "node()" for any node
+		std::vector<ExpressionPtr> predicates;
+	};
+
+	struct Expression {
+		enum Kind { Number, Literal, AttributeValue, Texts, Path, Function, Binary, Negative };
+		Kind kind;
+		double number;
+		std::string text; // Literal, attribute or function name, operator
+		std::vector<ExpressionPtr> operands;
+		std::vector<Step> steps; // Path
+	};
+
+	// Nodes in document order, the document may be among them.
+	std::vector<size_t> EvaluatePath(const DomTree& tree, size_t context, const std::vector<Step>& steps) const {
+		std::vector<size_t> current(1, context);
+		for (const auto& step : steps) {
+			std::vector<size_t> next;
+			for (const size_t node : current) {
+				const std::vector<size_t> selected = ApplyStep(tree, node, step);
+				next.insert(next.end(), selected.begin(), selected.end());
+			}
+			// Document order is index order, with the document before all
+			std::sort(next.begin(), next.end(), [](size_t a, size_t b) { return a + 1 < b + 1; });
+			next.erase(std::unique(next.begin(), next.end()), next.end());
+			current.swap(next);
+		}
+		return current;
+	}
+
+	struct Value {
+		enum Kind { Boolean, Number, String, Strings };
+		Kind kind;
+		bool boolean;
+		double number;
+		std::vector<std::string> strings; // One for String
+
+		static Value MakeBoolean(bool value) { Value v; v.kind = Boolean; v.boolean = value; return v; }
+		static Value MakeNumber(double value) { Value v; v.kind = Number; v.number = value; return v; }
+		static Value MakeString(const std::string& value) {
+			Value v; v.kind = String; v.strings.push_back(value); return v;
+		}
+		static Value MakeStrings(const std::vector<std::string>& values) {
+			Value v; v.kind = Strings; v.strings = values; return v;
+		}
+
+		Value() : kind(Boolean), boolean(false), number(0) {}
+	};
+
+	struct Context {
+		const DomTree& tree;
+		size_t node;
+		size_t position; // From 1
+		size_t size;
+	};
+
+	void CheckSyntax(bool condition) const {
+		WEBDRIVERXX_CHECK(condition, Fmt() << "Unsupported XPath expression (xpath: " << text_
+			<< ", position: " << position_ << ")");
+	}
+
+	void SkipSpaces() {
+		while (position_ < text_.size() && IsXmlSpace(text_[position_]))
+			++position_;
+	}
+
+	bool Accept(const char* token) {
+		SkipSpaces();
+		const size_t size = std::char_traits<char>::length(token);
+		if (text_.compare(position_, size, token) == 0) {
+			position_ += size;
+			return true;
+		}
+		return false;
+	}
+
+	bool Peek(char c) {
+		SkipSpaces();
+		return position_ < text_.size() && text_[position_] == c;
+	}
+
+	static
+	bool IsNameChar(char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+			|| c == '-' || c == '_' || c == '.' || static_cast<unsigned char>(c) >= 0x80;
+	}
+
+	std::string ParseName() {
+		SkipSpaces();
+		const size_t start = position_;
+		while (position_ < text_.size() && (IsNameChar(text_[position_]) ||
+			(text_[position_] == ':' && text_.compare(position_, 2, "::") != 0)))
+			++position_;
+		CheckSyntax(position_ > start);
+		return text_.substr(start, position_ - start);
+	}
+
+	std::vector<Step> ParsePath() {
+		std::vector<Step> result;
+		SkipSpaces();
+		if (Peek('/')) {
+			Step document = { Root, "node()", std::vector<ExpressionPtr>() };
+			result.push_back(document);
+			if (Accept("//")) {
+				Step any = { DescendantOrSelf, "node()", std::vector<ExpressionPtr>() };
+				result.push_back(any);
+			} else {
+				Accept("/");
+				if (position_ == text_.size())
+					return result;
+			}
+		}
+		for (;;) {
+			result.push_back(ParseStep());
+			if (Accept("//")) {
+				Step any = { DescendantOrSelf, "node()", std::vector<ExpressionPtr>() };
+				result.push_back(any);
+			} else if (!Accept("/")) {
+				break;
+			}
+		}
+		return result;
+	}
+
+	Step ParseStep() {
+		Step result = { Child, std::string(), std::vector<ExpressionPtr>() };
+		if (Accept("..")) {
+			result.axis = Parent;
+			result.name = "node()";
+			return result;
+		}
+		if (Accept(".")) {
+			result.axis = Self;
+			result.name = "node()";
+			return result;
+		}
+		if (Accept("*")) {
+			result.name = "*";
+		} else {
+			std::string name = ParseName();
+			if (Accept("::")) {
+				result.axis = ParseAxis(name);
+				if (Accept("*"))
+					name = "*";
+				else
+					name = ParseName();
+			}
+			if (Accept("(")) {
+				CheckSyntax(name == "node" && Accept(")"));
+				name = "node()";
+			}
+			result.name = name == "*" || name == "node()" ? name : ToLowerAscii(StripPrefix(name));
+		}
+		while (Accept("[")) {
+			result.predicates.push_back(ParseOr());
+			CheckSyntax(Accept("]"));
+		}
+		return result;
+	}
+
+	static
+	std::string StripPrefix(const std::string& name) {
+		const size_t colon = name.find(':');
+		return colon == std::string::npos ? name : name.substr(colon + 1);
+	}
+
+	Axis ParseAxis(const std::string& name) {
+		if (name == "child") return Child;
+		if (name == "descendant") return Descendant;
+		if (name == "descendant-or-self") return DescendantOrSelf;
+		if (name == "self") return Self;
+		if (name == "parent") return Parent;
+		if (name == "ancestor") return Ancestor;
+		if (name == "following-sibling") return FollowingSibling;
+		if (name == "preceding-sibling") return PrecedingSibling;
+		CheckSyntax(false);
+		return Child;
+	}
+
+	ExpressionPtr MakeExpression(Expression::Kind kind, const std::string& text = std::string()) {
+		const ExpressionPtr result = std::make_shared<Expression>();
+		result->kind = kind;
+		result->number = 0;
+		result->text = text;
+		return result;
+	}
+
+	ExpressionPtr MakeBinary(const std::string& op, const ExpressionPtr& left, const ExpressionPtr& right) {
+		const ExpressionPtr result = MakeExpression(Expression::Binary, op);
+		result->operands.push_back(left);
+		result->operands.push_back(right);
+		return result;
+	}
+
+	bool AcceptKeyword(const char* keyword) {
+		SkipSpaces();
+		const size_t saved = position_;
+		if (!Accept(keyword))
+			return false;
+		if (position_ < text_.size() && IsNameChar(text_[position_])) {
+			position_ = saved;
+			return false;
+		}
+		return true;
+	}
+
+	ExpressionPtr ParseOr() {
+		ExpressionPtr result = ParseAnd();
+		while (AcceptKeyword("or"))
+			result = MakeBinary("or", result, ParseAnd());
+		return result;
+	}
+
+	ExpressionPtr ParseAnd() {
+		ExpressionPtr result = ParseEquality();
+		while (AcceptKeyword("and"))
+			result = MakeBinary("and", result, ParseEquality());
+		return result;
+	}
+
+	ExpressionPtr ParseEquality() {
+		ExpressionPtr result = ParseRelational();
+		for (;;) {
+			if (Accept("!="))
+				result = MakeBinary("!=", result, ParseRelational());
+			else if (Accept("="))
+				result = MakeBinary("=", result, ParseRelational());
+			else
+				return result;
+		}
+	}
+
+	ExpressionPtr ParseRelational() {
+		ExpressionPtr result = ParseUnary();
+		for (;;) {
+			if (Accept("<="))
+				result = MakeBinary("<=", result, ParseUnary());
+			else if (Accept(">="))
+				result = MakeBinary(">=", result, ParseUnary());
+			else if (Accept("<"))
+				result = MakeBinary("<", result, ParseUnary());
+			else if (Accept(">"))
+				result = MakeBinary(">", result, ParseUnary());
+			else
+				return result;
+		}
+	}
+
+	ExpressionPtr ParseUnary() {
+		if (Accept("-")) {
+			const ExpressionPtr result = MakeExpression(Expression::Negative);
+			result->operands.push_back(ParseUnary());
+			return result;
+		}
+		return ParsePrimary();
+	}
+
+	ExpressionPtr ParsePrimary() {
+		SkipSpaces();
+		CheckSyntax(position_ < text_.size());
+		const char c = text_[position_];
+		if (c == '(') {
+			++position_;
+			const ExpressionPtr result = ParseOr();
+			CheckSyntax(Accept(")"));
+			return result;
+		}
+		if (c == '"' || c == '\'') {
+			const size_t end = text_.find(c, position_ + 1);
+			CheckSyntax(end != std::string::npos);
+			const ExpressionPtr result = MakeExpression(Expression::Literal,
+				text_.substr(position_ + 1, end - position_ - 1));
+			position_ = end + 1;
+			return result;
+		}
+		if ((c >= '0' && c <= '9') || (c == '.' && position_ + 1 < text_.size()
+			&& text_[position_ + 1] >= '0' && text_[position_ + 1] <= '9')) {
+			const char* begin = text_.c_str() + position_;
+			char* end = nullptr;
+			const ExpressionPtr result = MakeExpression(Expression::Number);
+			result->number = std::strtod(begin, &end);
+			position_ += end - begin;
+			return result;
+		}
+		if (c == '@') {
+			++position_;
+			return MakeExpression(Expression::AttributeValue, ToLowerAscii(StripPrefix(ParseName())));
+		}
+		const size_t start = position_;
+		const std::string name = c == '.' || c == '/' || c == '*' ? std::string() : ParseName();
+		if (name.empty() || name == "node" || !Accept("(")) {
+			position_ = start;
+			const ExpressionPtr result = MakeExpression(Expression::Path);
+			result->steps = ParsePath();
+			return result;
+		}
+		if (name == "text") {
+			CheckSyntax(Accept(")"));
+			return MakeExpression(Expression::Texts);
+		}
+		const ExpressionPtr result = MakeExpression(Expression::Function, name);
+		if (!Accept(")")) {
+			do {
+				result->operands.push_back(ParseOr());
+			} while (Accept(","));
+			CheckSyntax(Accept(")"));
+		}
+		CheckFunction(*result);
+		return result;
+	}
+
+	void CheckFunction(const Expression& function) const {
+		const std::string& name = function.text;
+		const size_t count = function.operands.size();
+		CheckSyntax(
+			((name == "last" || name == "position" || name == "true" || name == "false") && count == 0) ||
+			((name == "not" || name == "string-length" || name == "normalize-space" || name == "string") && count <= 1
+				&& (count == 1 || name != "not")) ||
+			((name == "contains" || name == "starts-with") && count == 2) ||
+			(name == "concat" && count >= 2)
+			);
+	}
+
+	// Candidates for a step from the node in axis order.
+	static
+	std::vector<size_t> GetAxis(const DomTree& tree, size_t node, Axis axis) {
+		std::vector<size_t> result;
+		switch (axis) {
+		case Root:
+			result.push_back(kNoDomNode);
+			return result;
+		case Child:
+			return tree.GetChildren(node);
+		case Descendant:
+			return tree.GetDescendants(node);
+		case DescendantOrSelf:
+			result.push_back(node);
+			for (const size_t descendant : tree.GetDescendants(node))
+				result.push_back(descendant);
+			return result;
+		case Self:
+			result.push_back(node);
+			return result;
+		case Parent:
+			if (node != kNoDomNode)
+				result.push_back(tree.nodes[node].parent);
+			return result;
+		case Ancestor:
+			if (node != kNoDomNode) {
+				for (size_t i = tree.nodes[node].parent; i != kNoDomNode; i = tree.nodes[i].parent)
+					result.push_back(i);
+				result.push_back(kNoDomNode);
+			}
+			return result;
+		case FollowingSibling:
+			if (node != kNoDomNode)
+				for (size_t i = tree.GetNextSibling(node); i != kNoDomNode; i = tree.GetNextSibling(i))
+					result.push_back(i);
+			return result;
+		case PrecedingSibling:
+			if (node != kNoDomNode)
+				for (size_t i = tree.nodes[node].previous_sibling; i != kNoDomNode; i = tree.nodes[i].previous_sibling)
+					result.push_back(i);
+			return result;
+		}
+		return result;
+	}
+
+	static
+	bool MatchesNameTest(const DomTree& tree, size_t node, const std::string& name) {
+		if (name == "node()")
+			return true;
+		if (node == kNoDomNode)
+			return false;
+		return name == "*" || tree.nodes[node].name == name;
+	}
+
+	std::vector<size_t> ApplyStep(const DomTree& tree, size_t node, const Step& step) const {
+		std::vector<size_t> result;
+		for (const size_t candidate : GetAxis(tree, node, step.axis))
+			if (MatchesNameTest(tree, candidate, step.name))
+				result.push_back(candidate);
+		for (const auto& predicate : step.predicates) {
+			std::vector<size_t> filtered;
+			for (size_t i = 0; i < result.size(); ++i) {
+				const Context context = { tree, result[i], i + 1, result.size() };
+				const Value value = Evaluate(context, *predicate);
+				if (value.kind == Value::Number ? value.number == static_cast<double>(i + 1) : ToBoolean(value))
+					filtered.push_back(result[i]);
+			}
+			result.swap(filtered);
+		}
+		return result;
+	}
+
+	static
+	bool ToBoolean(const Value& value) {
+		switch (value.kind) {
+		case Value::Boolean: return value.boolean;
+		case Value::Number: return value.number != 0 && value.number == value.number;
+		case Value::String: return !value.strings[0].empty();
+		case Value::Strings: return !value.strings.empty();
+		}
+		return false;
+	}
+
+	static
+	double ToNumber(const std::string& value) {
+		const std::string trimmed = NormalizeSpace(value);
+		char* end = nullptr;
+		const double result = std::strtod(trimmed.c_str(), &end);
+		return trimmed.empty() || *end ? std::numeric_limits<double>::quiet_NaN() : result;
+	}
+
+	static
+	std::string ToString(const Value& value) {
+		switch (value.kind) {
+		case Value::Boolean: return value.boolean ? "true" : "false";
+		case Value::Number: return Fmt() << value.number;
+		case Value::String:
+		case Value::Strings: return value.strings.empty() ? std::string() : value.strings[0];
+		}
+		return std::string();
+	}
+
+	static
+	double ToNumber(const Value& value) {
+		switch (value.kind) {
+		case Value::Boolean: return value.boolean ? 1 : 0;
+		case Value::Number: return value.number;
+		default: return ToNumber(ToString(value));
+		}
+	}
+
+	static
+	bool CompareAtoms(const std::string& op, double a, double b) {
+		if (op == "=") return a == b;
+		if (op == "!=") return a != b;
+		if (op == "<") return a < b;
+		if (op == ">") return a > b;
+		if (op == "<=") return a <= b;
+		return a >= b;
+	}
+
+	static
+	bool Compare(const std::string& op, const Value& left, const Value& right) {
+		const bool is_equality = op == "=" || op == "!=";
+		if (left.kind == Value::Strings || right.kind == Value::Strings) {
+			const Value& set = left.kind == Value::Strings ? left : right;
+			const Value& other = left.kind == Value::Strings ? right : left;
+			const bool set_on_left = &set == &left;
+			if (other.kind == Value::Boolean)
+				return CompareAtoms(op, set_on_left ? ToBoolean(set) : other.boolean,
+					set_on_left ? other.boolean : ToBoolean(set));
+			for (const auto& item : set.strings) {
+				if (other.kind == Value::Strings) {
+					for (const auto& other_item : other.strings)
+						if (CompareStrings(op, item, other_item, is_equality))
+							return true;
+				} else if (other.kind == Value::Number || !is_equality) {
+					const double a = ToNumber(item);
+					const double b = ToNumber(other);
+					if (CompareAtoms(op, set_on_left ? a : b, set_on_left ? b : a))
+						return true;
+				} else if (CompareStrings(op, item, other.strings[0], true)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		if (is_equality) {
+			if (left.kind == Value::Boolean || right.kind == Value::Boolean)
+				return CompareAtoms(op, ToBoolean(left), ToBoolean(right));
+			if (left.kind == Value::Number || right.kind == Value::Number)
+				return CompareAtoms(op, ToNumber(left), ToNumber(right));
+			return (ToString(left) == ToString(right)) == (op == "=");
+		}
+		return CompareAtoms(op, ToNumber(left), ToNumber(right));
+	}
+
+	static
+	bool CompareStrings(const std::string& op, const std::string& a, const std::string& b, bool is_equality) {
+		if (is_equality)
+			return (a == b) == (op == "=");
+		return CompareAtoms(op, ToNumber(a), ToNumber(b));
+	}
+
+	Value Evaluate(const Context& context, const Expression& expression) const {
+		const DomTree& tree = context.tree;
+		switch (expression.kind) {
+		case Expression::Number:
+			return Value::MakeNumber(expression.number);
+		case Expression::Literal:
+			return Value::MakeString(expression.text);
+		case Expression::AttributeValue: {
+			std::vector<std::string> values;
+			const std::string* value = context.node == kNoDomNode ?
+				nullptr : tree.FindAttribute(context.node, expression.text);
+			if (value)
+				values.push_back(*value);
+			return Value::MakeStrings(values);
+		}
+		case Expression::Texts:
+			return Value::MakeStrings(tree.GetChildTexts(context.node));
+		case Expression::Path: {
+			std::vector<std::string> values;
+			for (const size_t node : EvaluatePath(tree, context.node, expression.steps))
+				values.push_back(tree.GetStringValue(node));
+			return Value::MakeStrings(values);
+		}
+		case Expression::Negative:
+			return Value::MakeNumber(-ToNumber(Evaluate(context, *expression.operands[0])));
+		case Expression::Binary: {
+			const std::string& op = expression.text;
+			if (op == "and")
+				return Value::MakeBoolean(ToBoolean(Evaluate(context, *expression.operands[0]))
+					&& ToBoolean(Evaluate(context, *expression.operands[1])));
+			if (op == "or")
+				return Value::MakeBoolean(ToBoolean(Evaluate(context, *expression.operands[0]))
+					|| ToBoolean(Evaluate(context, *expression.operands[1])));
+			return Value::MakeBoolean(Compare(op,
+				Evaluate(context, *expression.operands[0]),
+				Evaluate(context, *expression.operands[1])));
+		}
+		case Expression::Function:
+			return EvaluateFunction(context, expression);
+		}
+		return Value();
+	}
+
+	Value EvaluateFunction(const Context& context, const Expression& function) const {
+		const std::string& name = function.text;
+		std::vector<Value> args;
+		for (const auto& operand : function.operands)
+			args.push_back(Evaluate(context, *operand));
+		const auto string_arg = [&](size_t index) {
+			return index < args.size() ? ToString(args[index]) : context.tree.GetStringValue(context.node);
+		};
+		if (name == "last") return Value::MakeNumber(static_cast<double>(context.size));
+		if (name == "position") return Value::MakeNumber(static_cast<double>(context.position));
+		if (name == "true") return Value::MakeBoolean(true);
+		if (name == "false") return Value::MakeBoolean(false);
+		if (name == "not") return Value::MakeBoolean(!ToBoolean(args[0]));
+		if (name == "string") return Value::MakeString(string_arg(0));
+		if (name == "normalize-space") return Value::MakeString(NormalizeSpace(string_arg(0)));
+		if (name == "string-length") return Value::MakeNumber(static_cast<double>(string_arg(0).size()));
+		if (name == "contains") return Value::MakeBoolean(string_arg(0).find(string_arg(1)) != std::string::npos);
+		if (name == "starts-with") return Value::MakeBoolean(string_arg(0).compare(0, string_arg(1).size(), string_arg(1)) == 0);
+		std::string result; // concat
+		for (size_t i = 0; i < args.size(); ++i)
+			result += string_arg(i);
+		return Value::MakeString(result);
+	}
+
+private:
+	std::string text_;
+	size_t position_;
+	std::vector<Step> steps_;
+};
+
+// Elements inside the context node (or the whole document)
+// matching the locator, in document order.
+inline
+std::vector<size_t> QueryDom(const DomTree& tree, size_t context, const By& by) {
+	const std::string& strategy = by.GetStrategy();
+	const std::string& value = by.GetValue();
+	if (strategy == "xpath")
+		return XPathQuery(value).Evaluate(tree, context);
+	std::unique_ptr<CssQuery> css;
+	if (strategy == "css selector")
+		css.reset(new CssQuery(value));
+	const std::string tag = ToLowerAscii(value);
+	std::vector<size_t> result;
+	for (const size_t node : tree.GetDescendants(context)) {
+		bool matches = false;
+		if (css) {
+			matches = css->Matches(tree, node);
+		} else if (strategy == "id" || strategy == "name") {
+			const std::string* attribute = tree.FindAttribute(node, strategy);
+			matches = attribute && *attribute == value;
+		} else if (strategy == "class name") {
+			matches = tree.HasClass(node, value);
+		} else if (strategy == "tag name") {
+			matches = tree.nodes[node].name == tag;
+		} else if (strategy == "link text" || strategy == "partial link text") {
+			if (tree.nodes[node].name == "a") {
+				const std::string text = tree.GetText(node);
+				matches = strategy == "link text" ? text == value : text.find(value) != std::string::npos;
+			}
+		} else {
+			WEBDRIVERXX_THROW(Fmt() << "Unsupported locator strategy (strategy: " << strategy << ")");
+		}
+		if (matches)
+			result.push_back(node);
+	}
+	return result;
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -29,6 +29,13 @@ bool BoolCast(T value) {
 	return !!value;
 }
 
+// Keeps the server status when an exception is rethrown with context.
+inline
+response_status_code::Value GetStatusCode(const std::exception& e) {
+	const WebDriverException* const error = dynamic_cast<const WebDriverException*>(&e);
+	return error ? error->GetStatusCode() : response_status_code::kSuccess;
+}
+
 } // namespace detail
 } // namespace webdriverxx
 
@@ -44,23 +51,29 @@ bool BoolCast(T value) {
 #define WEBDRIVERXX_FUNCTION_CONTEXT_END() \
 	} catch (const std::exception& e) { \
 		throw ::webdriverxx::WebDriverException(std::string(e.what()) \
-			+ " called from " + WEBDRIVERXX_CURRENT_FUNCTION); \
+			+ " called from " + WEBDRIVERXX_CURRENT_FUNCTION, \
+			::webdriverxx::detail::GetStatusCode(e)); \
 	}
 
 #define WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(details) \
 	} catch (const std::exception& e) { \
 		throw ::webdriverxx::WebDriverException(std::string(e.what()) \
 			+ " called from " + WEBDRIVERXX_CURRENT_FUNCTION \
-			+ " (" + std::string(details) + ")"); \
+			+ " (" + std::string(details) + ")", \
+			::webdriverxx::detail::GetStatusCode(e)); \
 	}
 
-#define WEBDRIVERXX_THROW(message) \
+#define WEBDRIVERXX_THROW_STATUS(message, status_code) \
 	throw ::webdriverxx::WebDriverException(::webdriverxx::detail::Fmt() \
 		<< std::string(message) \
 		<< " at line " << __LINE__ \
-		<< ", file " << __FILE__ \
+		<< ", file " << __FILE__, \
+		status_code \
 		)
 
+#define WEBDRIVERXX_THROW(message) \
+	WEBDRIVERXX_THROW_STATUS(message, ::webdriverxx::response_status_code::kSuccess)
+
 #define WEBDRIVERXX_CHECK(pred, message) \
 	for (;!detail::BoolCast(pred);) \
 		WEBDRIVERXX_THROW(message)
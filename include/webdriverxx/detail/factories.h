@@ -15,6 +15,8 @@ class Resource;
 
 struct IFinderFactory {
 	virtual Finder MakeFinder(const Shared<Resource>& context) = 0;
+	// Returns false if the element didn't come from the element cache.
+	virtual bool FindElementAgain(const std::string& stale_ref, Element& element) = 0;
 	virtual ~IFinderFactory() {}
 
 };
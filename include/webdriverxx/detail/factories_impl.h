@@ -4,6 +4,8 @@
 #include "factories.h"
 #include "resource.h"
 #include "finder.h"
+#include "focus_state.h"
+#include "../element_cache.h"
 #include "shared.h"
 #include "../element.h"
 
@@ -16,24 +18,41 @@ class SessionFactory // noncopyable
 	, public SharedObjectBase
 {
 public:
-	explicit SessionFactory(const Shared<Resource>& session_resource)
+	SessionFactory(
+		const Shared<Resource>& session_resource,
+		const Shared<FocusState>& focus,
+		const Shared<ElementCache>& element_cache
+		)
 		: session_resource_(session_resource)
+		, focus_(focus)
+		, element_cache_(element_cache)
 	{}
 
 	virtual Element MakeElement(const std::string& id) {
 		return Element(
 			id,
 			detail::MakeSubResource(session_resource_, "element", id),
-			Shared<IFinderFactory>(this)
+			Shared<IFinderFactory>(this),
+			focus_
 			);
 	}
 
 	virtual Finder MakeFinder(const Shared<Resource>& context) {
-		return Finder(context, Shared<IElementFactory>(this));
+		return Finder(context, session_resource_, Shared<IElementFactory>(this), element_cache_);
+	}
+
+	virtual bool FindElementAgain(const std::string& stale_ref, Element& element) {
+		std::string ref;
+		if (!element_cache_->FindAgain(stale_ref, ref))
+			return false;
+		element = MakeElement(ref);
+		return true;
 	}
 
 private:
 	const Shared<Resource> session_resource_;
+	const Shared<FocusState> focus_;
+	const Shared<ElementCache> element_cache_;
 };
 
 } // namespace detail
@@ -0,0 +1,260 @@
+#ifndef WEBDRIVERXX_DETAIL_FILE_UPLOAD_H
+#define WEBDRIVERXX_DETAIL_FILE_UPLOAD_H
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+#include "base64.h"
+#include "error_handling.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace webdriverxx {
+namespace detail {
+
+// Raw deflate stream that passes its output to a function piece by piece.
+class Deflater { // noncopyable
+public:
+	Deflater() : stream_() {
+		// Negative window bits select raw deflate, as stored in zip files
+		WEBDRIVERXX_CHECK(deflateInit2(&stream_, Z_DEFAULT_COMPRESSION,
+			Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK,
+			"Cannot initialize zlib");
+	}
+
+	~Deflater() {
+		deflateEnd(&stream_);
+	}
+
+	template<typename Output>
+	void Feed(const char* data, size_t size, bool finish, Output output) {
+		stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+		stream_.avail_in = static_cast<uInt>(size);
+		int status = Z_OK;
+		do {
+			char buffer[16384];
+			stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+			stream_.avail_out = sizeof(buffer);
+			status = deflate(&stream_, finish ? Z_FINISH : Z_NO_FLUSH);
+			WEBDRIVERXX_CHECK(status == Z_OK || status == Z_STREAM_END || status == Z_BUF_ERROR,
+				"Cannot compress data");
+			output(buffer, sizeof(buffer) - stream_.avail_out);
+		} while (finish ? status != Z_STREAM_END : stream_.avail_out == 0);
+	}
+
+	size_t GetTotalOut() const {
+		return static_cast<size_t>(stream_.total_out);
+	}
+
+private:
+	Deflater(Deflater&);
+	Deflater& operator = (Deflater&);
+
+private:
+	z_stream stream_;
+};
+
+const char *const kFileUploadPrefix = "{\"file\":\"";
+const char *const kFileUploadSuffix = "\"}";
+
+// The body of the WebDriver file command, {"file":"<base64 zip>"}, for
+// one file. It is produced piece by piece while being sent, so memory use
+// does not depend on the size of the file. The file is read twice: first
+// to measure the compressed size and the checksum, which go before the data
+// in a zip file and make the length of the body known in advance, then
+// while sending.
+class FileUploadBody { // noncopyable
+public:
+	explicit FileUploadBody(const std::string& path)
+		: name_(path.substr(path.find_last_of("/\\") + 1))
+		, file_(path.c_str(), std::ios::binary)
+		, crc_(crc32(0, nullptr, 0))
+		, file_size_(0)
+		, compressed_size_(0)
+		, stage_(Prefix)
+		, sent_crc_(0)
+		, sent_size_(0)
+		, carry_size_(0)
+	{
+		WEBDRIVERXX_CHECK(file_.is_open(), "Cannot open file");
+		WEBDRIVERXX_CHECK(!name_.empty(), "Path has no file name");
+		Deflater deflater;
+		ForEachChunk([this, &deflater](const char* data, size_t size, bool last) {
+			crc_ = crc32(crc_, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size));
+			file_size_ += size;
+			deflater.Feed(data, size, last, [](const char*, size_t) {});
+		});
+		compressed_size_ = deflater.GetTotalOut();
+		WEBDRIVERXX_CHECK(file_size_ < 0xFFFFFFFFu && compressed_size_ < 0xFFFFFFFFu,
+			"File is too big for a zip file without 64-bit extensions");
+		file_.clear();
+		file_.seekg(0);
+	}
+
+	// Of the whole JSON body.
+	size_t GetSize() const {
+		const size_t zip_size = kLocalHeaderSize + kCentralHeaderSize + kEndOfDirectorySize
+			+ 2 * name_.size() + compressed_size_;
+		return std::string(kFileUploadPrefix).size() + (zip_size + 2) / 3 * 4
+			+ std::string(kFileUploadSuffix).size();
+	}
+
+	// Fills the buffer with the next piece of the body, returns 0 at the end.
+	size_t Read(char* buffer, size_t size) {
+		while (pending_.size() < size && stage_ != Done)
+			Produce();
+		const size_t result = std::min(size, pending_.size());
+		std::copy(pending_.begin(), pending_.begin() + result, buffer);
+		pending_.erase(0, result);
+		return result;
+	}
+
+private:
+	enum Stage { Prefix, Data, Done };
+
+	static const size_t kChunkSize = 65536;
+	static const size_t kLocalHeaderSize = 30;
+	static const size_t kCentralHeaderSize = 46;
+	static const size_t kEndOfDirectorySize = 22;
+
+	template<typename Function>
+	void ForEachChunk(Function function) {
+		std::string chunk(kChunkSize, '\0');
+		bool last = false;
+		while (!last) {
+			file_.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+			const size_t size = static_cast<size_t>(file_.gcount());
+			last = size < chunk.size();
+			WEBDRIVERXX_CHECK(!file_.bad(), "Cannot read file");
+			function(chunk.data(), size, last);
+		}
+	}
+
+	void Produce() {
+		if (stage_ == Prefix) {
+			pending_ += kFileUploadPrefix;
+			AppendZip(MakeHeader(0x04034b50));
+			stage_ = Data;
+			deflater_.reset(new Deflater);
+			sent_crc_ = crc32(0, nullptr, 0);
+			sent_size_ = 0;
+			return;
+		}
+		std::string chunk(kChunkSize, '\0');
+		file_.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+		const size_t size = static_cast<size_t>(file_.gcount());
+		WEBDRIVERXX_CHECK(!file_.bad(), "Cannot read file");
+		const bool last = size < chunk.size();
+		sent_crc_ = crc32(sent_crc_, reinterpret_cast<const Bytef*>(chunk.data()), static_cast<uInt>(size));
+		sent_size_ += size;
+		deflater_->Feed(chunk.data(), size, last, [this](const char* data, size_t size) {
+			AppendZip(data, size);
+		});
+		if (!last)
+			return;
+		// The local header already went out with the first pass' values
+		WEBDRIVERXX_CHECK(sent_size_ == file_size_ && sent_crc_ == crc_
+			&& deflater_->GetTotalOut() == compressed_size_, "File has changed while uploading");
+		AppendZip(MakeHeader(0x02014b50));
+		std::string end;
+		Put32(end, 0x06054b50);
+		Put16(end, 0); // This disk
+		Put16(end, 0); // Disk with the central directory
+		Put16(end, 1); // Entries on this disk
+		Put16(end, 1); // All entries
+		Put32(end, kCentralHeaderSize + name_.size());
+		Put32(end, kLocalHeaderSize + name_.size() + compressed_size_);
+		Put16(end, 0); // Comment length
+		AppendZip(end);
+		FlushBase64();
+		pending_ += kFileUploadSuffix;
+		stage_ = Done;
+		deflater_.reset();
+	}
+
+	// A local file header or a central directory header.
+	std::string MakeHeader(unsigned signature) const {
+		const bool central = signature == 0x02014b50;
+		std::string result;
+		Put32(result, signature);
+		if (central)
+			Put16(result, 20); // Version made by
+		Put16(result, 20); // Version needed to extract
+		Put16(result, 0x0800); // Name is UTF-8
+		Put16(result, 8); // Deflate
+		Put16(result, 0); // Modification time
+		Put16(result, 0x21); // Modification date, 1980-01-01
+		Put32(result, crc_);
+		Put32(result, compressed_size_);
+		Put32(result, file_size_);
+		Put16(result, name_.size());
+		Put16(result, 0); // Extra field length
+		if (central) {
+			Put16(result, 0); // Comment length
+			Put16(result, 0); // Disk
+			Put16(result, 0); // Internal attributes
+			Put32(result, 0); // External attributes
+			Put32(result, 0); // Offset of the local header
+		}
+		return result + name_;
+	}
+
+	static
+	void Put16(std::string& out, size_t value) {
+		out += static_cast<char>(value & 0xFF);
+		out += static_cast<char>((value >> 8) & 0xFF);
+	}
+
+	static
+	void Put32(std::string& out, size_t value) {
+		Put16(out, value & 0xFFFF);
+		Put16(out, (value >> 16) & 0xFFFF);
+	}
+
+	void AppendZip(const std::string& data) {
+		AppendZip(data.data(), data.size());
+	}
+
+	void AppendZip(const char* data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			carry_[carry_size_++] = static_cast<unsigned char>(data[i]);
+			if (carry_size_ == 3)
+				FlushBase64();
+		}
+	}
+
+	void FlushBase64() {
+		if (!carry_size_)
+			return;
+		EncodeBase64Group(carry_, carry_size_, pending_);
+		carry_size_ = 0;
+	}
+
+private:
+	FileUploadBody(FileUploadBody&);
+	FileUploadBody& operator = (FileUploadBody&);
+
+private:
+	const std::string name_;
+	std::ifstream file_;
+	uLong crc_;
+	size_t file_size_;
+	size_t compressed_size_;
+	Stage stage_;
+	uLong sent_crc_; // Of the data read while sending
+	size_t sent_size_;
+	std::unique_ptr<Deflater> deflater_;
+	std::string pending_; // Encoded, not sent yet
+	unsigned char carry_[3]; // Zip bytes not encoded yet
+	size_t carry_size_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif // WEBDRIVERXX_ENABLE_ZLIB
+
+#endif
@@ -5,6 +5,8 @@
 #include "resource.h"
 #include "factories.h"
 #include "../by.h"
+#include "../element_cache.h"
+#include <string>
 #include <vector>
 
 namespace webdriverxx {
@@ -17,15 +19,28 @@ class Finder { // copyable
 public:
 	Finder(
 		const Shared<Resource>& context,
-		const Shared<IElementFactory>& factory
+		const Shared<Resource>& session,
+		const Shared<IElementFactory>& factory,
+		const Shared<ElementCache>& cache = Shared<ElementCache>()
 		);
 
 	Element FindElement(const By& by) const;
 	std::vector<Element> FindElements(const By& by) const;
+	// Searches inside the root or the whole document if it is null.
+	std::vector<std::vector<Element>> FindAll(
+		const std::vector<By>& locators,
+		const Element* root
+		) const;
+
+private:
+	static
+	std::string LookUp(const Shared<Resource>& context, const By& by);
 
 private:
 	Shared<Resource> context_;
+	Shared<Resource> session_;
 	Shared<IElementFactory> factory_;
+	Shared<ElementCache> cache_;
 };
 
 } // namespace detail
@@ -6,25 +6,85 @@
 namespace webdriverxx {
 namespace detail {
 
+// Resolves locators the way WebDriver does. Takes the root element
+// (or null) and an array of [strategy, value] pairs, returns an array
+// of element arrays.
+const char *const kFindAllScript =
+	"var root = arguments[0] || document;"
+	"function quote(value) {"
+		"return '\"' + value.replace(/([\"\\\\])/g, '\\\\$1') + '\"';"
+	"}"
+	"function byXPath(value) {"
+		"var nodes = document.evaluate(value, root, null,"
+			"XPathResult.ORDERED_NODE_SNAPSHOT_TYPE, null);"
+		"var result = [];"
+		"for (var i = 0; i < nodes.snapshotLength; ++i)"
+			"result.push(nodes.snapshotItem(i));"
+		"return result;"
+	"}"
+	"function byLinkText(value, partial) {"
+		"return Array.prototype.filter.call(root.querySelectorAll('a'), function(link) {"
+			"var text = (link.innerText || link.textContent || '').trim();"
+			"return partial ? text.indexOf(value) >= 0 : text === value;"
+		"});"
+	"}"
+	"function find(strategy, value) {"
+		"switch (strategy) {"
+		"case 'css selector': return root.querySelectorAll(value);"
+		"case 'id': return root.querySelectorAll('[id=' + quote(value) + ']');"
+		"case 'name': return root.querySelectorAll('[name=' + quote(value) + ']');"
+		"case 'class name': return root.getElementsByClassName(value);"
+		"case 'tag name': return root.getElementsByTagName(value);"
+		"case 'xpath': return byXPath(value);"
+		"case 'link text': return byLinkText(value, false);"
+		"case 'partial link text': return byLinkText(value, true);"
+		"}"
+		"throw new Error('Unsupported locator strategy: ' + strategy);"
+	"}"
+	"return arguments[1].map(function(locator) {"
+		"return Array.prototype.slice.call(find(locator[0], locator[1]));"
+	"});"
+	;
+
 inline
 Finder::Finder(
 	const Shared<Resource>& context,
-	const Shared<IElementFactory>& factory
+	const Shared<Resource>& session,
+	const Shared<IElementFactory>& factory,
+	const Shared<ElementCache>& cache
 	)
 	: context_(context)
+	, session_(session)
 	, factory_(factory)
+	, cache_(cache)
 {}
 
 inline
 Element Finder::FindElement(const By& by) const {
+	if (!cache_ || !cache_->IsEnabled())
+		return factory_->MakeElement(LookUp(context_, by));
+	const std::string key = context_->GetUrl() + '\n' + by.GetStrategy() + '\n' + by.GetValue();
+	std::string ref;
+	if (cache_->Find(key, ref))
+		return factory_->MakeElement(ref);
+	cache_->CountLookup();
+	ref = LookUp(context_, by);
+	// Holds the context only, the cache must not own itself through the factory
+	const Shared<Resource> context = context_;
+	cache_->Store(key, ref, [context, by] { return LookUp(context, by); });
+	return factory_->MakeElement(ref);
+}
+
+inline
+std::string Finder::LookUp(const Shared<Resource>& context, const By& by) {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
-	return factory_->MakeElement(FromJson<ElementRef>(
-		context_->Post("element", JsonObject()
+	return FromJson<ElementRef>(
+		context->Post("element", JsonObject()
 			.Set("using", by.GetStrategy())
 			.Set("value", by.GetValue())
-		)).ref);
+		)).ref;
 	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(Fmt()
-		<< "context: " << context_->GetUrl()
+		<< "context: " << context->GetUrl()
 		<< ", strategy: " << by.GetStrategy()
 		<< ", value: " << by.GetValue()
 		)
@@ -53,5 +113,36 @@ std::vector<Element> Finder::FindElements(const By& by) const {
 		)
 }
 
+inline
+std::vector<std::vector<Element>> Finder::FindAll(
+	const std::vector<By>& locators,
+	const Element* root
+	) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	picojson::array pairs;
+	for (const auto& by : locators)
+		pairs.push_back(ToJson(std::vector<std::string>{ by.GetStrategy(), by.GetValue() }));
+	picojson::array args;
+	args.push_back(root ? ToJson(*root) : picojson::value());
+	args.push_back(picojson::value(pairs));
+	const auto refs = FromJson<std::vector<std::vector<ElementRef>>>(
+		session_->Post("execute", JsonObject()
+			.Set("script", kFindAllScript)
+			.Set("args", picojson::value(args))
+		));
+	WEBDRIVERXX_CHECK(refs.size() == locators.size(), "Script returned wrong number of results");
+	std::vector<std::vector<Element>> result(refs.size());
+	for (size_t i = 0; i < refs.size(); ++i) {
+		result[i].reserve(refs[i].size());
+		for (const auto& element_ref : refs[i])
+			result[i].push_back(factory_->MakeElement(element_ref.ref));
+	}
+	return result;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(Fmt()
+		<< "context: " << context_->GetUrl()
+		<< ", locators: " << locators.size()
+		)
+}
+
 } // namespace detail
 } // namespace webdriverxx
@@ -0,0 +1,90 @@
+#ifndef WEBDRIVERXX_DETAIL_FOCUS_STATE_H
+#define WEBDRIVERXX_DETAIL_FOCUS_STATE_H
+
+#include "shared.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+// Last known window and frame the session is focused on, shared by
+// copies of a session and its elements. Commands that may load another
+// document make a nested frame unknown; closing a window makes the whole
+// focus unknown. The next switch is then sent to the server even if it
+// looks redundant.
+class FocusState : public SharedObjectBase { // noncopyable
+public:
+	typedef std::vector<std::string> FramePath; // Serialized frame IDs from the top frame
+
+	FocusState()
+		: window_known_(false)
+		, frame_known_(false)
+	{}
+
+	bool IsOnWindow(const std::string& window) const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return window_known_ && window_ == window
+			&& frame_known_ && frame_path_.empty();
+	}
+
+	// Returns false if the frame is unknown.
+	bool GetFramePath(FramePath& path) const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (frame_known_)
+			path = frame_path_;
+		return frame_known_;
+	}
+
+	// Switching to a window focuses its top frame.
+	void SetWindow(const std::string& window) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		window_known_ = true;
+		window_ = window;
+		frame_known_ = true;
+		frame_path_.clear();
+	}
+
+	void SetFramePath(const FramePath& path) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		frame_known_ = true;
+		frame_path_ = path;
+	}
+
+	void ForgetFrame() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		frame_known_ = false;
+		frame_path_.clear();
+	}
+
+	// The top frame stays focused when another document is loaded,
+	// a nested one may be gone.
+	void ForgetNestedFrame() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!frame_path_.empty()) {
+			frame_known_ = false;
+			frame_path_.clear();
+		}
+	}
+
+	void Forget() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		window_known_ = false;
+		window_.clear();
+		frame_known_ = false;
+		frame_path_.clear();
+	}
+
+private:
+	mutable std::mutex mutex_;
+	bool window_known_;
+	std::string window_; // Name or handle it was switched by
+	bool frame_known_;
+	FramePath frame_path_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef WEBDRIVERXX_DETAIL_GZIP_H
+#define WEBDRIVERXX_DETAIL_GZIP_H
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+#include "error_handling.h"
+#include <zlib.h>
+#include <string>
+
+namespace webdriverxx {
+namespace detail {
+
+inline
+std::string Gzip(const std::string& data) {
+	z_stream stream = {};
+	// 16 selects the gzip wrapper instead of the zlib one
+	WEBDRIVERXX_CHECK(deflateInit2(&stream, Z_DEFAULT_COMPRESSION,
+		Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK,
+		"Cannot initialize zlib");
+	std::string result(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	stream.avail_in = static_cast<uInt>(data.size());
+	stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+	stream.avail_out = static_cast<uInt>(result.size());
+	const int status = deflate(&stream, Z_FINISH);
+	result.resize(stream.total_out);
+	deflateEnd(&stream);
+	WEBDRIVERXX_CHECK(status == Z_STREAM_END, "Cannot compress data");
+	return result;
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif // WEBDRIVERXX_ENABLE_ZLIB
+
+#endif
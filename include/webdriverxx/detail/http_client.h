@@ -1,6 +1,8 @@
 #ifndef WEBDRIVERXX_DETAIL_HTTP_CLIENT_H
 #define WEBDRIVERXX_DETAIL_HTTP_CLIENT_H
 
+#include <cstddef>
+#include <functional>
 #include <string>
 
 namespace webdriverxx {
@@ -9,16 +11,53 @@ namespace detail {
 struct HttpResponse {
 	long http_code;
 	std::string body;
+	// Body sizes as transferred, which differ from the decoded ones
+	// when compression is on. 0 if the client doesn't track them.
+	size_t bytes_sent_on_wire;
+	size_t bytes_received_on_wire;
+	// Size of the body passed to a sink instead of the body member.
+	size_t bytes_streamed;
 
 	HttpResponse()
 		: http_code(0)
+		, bytes_sent_on_wire(0)
+		, bytes_received_on_wire(0)
+		, bytes_streamed(0)
 	{}
 };
 
+// Takes the body piece by piece, returns false to stop the transfer.
+typedef std::function<bool(const char* data, size_t size)> HttpBodySink;
+
+// Fills the buffer with the next piece of the body, returns its size, 0 at the end.
+typedef std::function<size_t(char* buffer, size_t size)> HttpBodySource;
+
 struct IHttpClient {
 	virtual HttpResponse Get(const std::string& url) const = 0;
+	// Passes the body of a successful (200) response to the sink as it
+	// is received. Bodies of other responses are returned as usual.
+	// Clients that can't stream pass the whole body at once.
+	virtual HttpResponse GetStreamed(const std::string& url, const HttpBodySink& sink) const {
+		HttpResponse response = Get(url);
+		if (response.http_code == 200) {
+			sink(response.body.data(), response.body.size());
+			response.bytes_streamed = response.body.size();
+			response.body.clear();
+		}
+		return response;
+	}
 	virtual HttpResponse Delete(const std::string& url) const = 0;
 	virtual HttpResponse Post(const std::string& url, const std::string& data) const = 0;
+	// Sends a JSON body of the given size taken from the source as it is
+	// sent. Clients that can't stream collect the whole body first.
+	virtual HttpResponse PostStreamed(const std::string& url, size_t size, const HttpBodySource& source) const {
+		std::string data;
+		data.reserve(size);
+		char buffer[16384];
+		for (size_t read; (read = source(buffer, sizeof(buffer))) > 0;)
+			data.append(buffer, read);
+		return Post(url, data);
+	}
 	virtual ~IHttpClient() {}
 };
 
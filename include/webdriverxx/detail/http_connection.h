@@ -5,49 +5,168 @@
 #include "http_request.h"
 #include "error_handling.h"
 #include "shared.h"
+#include "../connection_options.h"
 #include <curl/curl.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace webdriverxx {
 namespace detail {
 
+inline
+const ConnectionOptions& CheckConnectionOptions(const ConnectionOptions& options) {
+#ifndef WEBDRIVERXX_ENABLE_ZLIB
+	WEBDRIVERXX_CHECK(!options.request_compression_threshold,
+		"Request compression requires zlib, define WEBDRIVERXX_ENABLE_ZLIB to enable it");
+#endif
+#if LIBCURL_VERSION_NUM < 0x072800 // 7.40.0
+	WEBDRIVERXX_CHECK(options.unix_socket_path.empty(),
+		"Unix domain sockets require libcurl 7.40.0 or newer");
+#endif
+	return options;
+}
+
+// Should be called after HttpRequest::Prepare(), which resets the handle.
+inline
+void SetConnectionOptions(CURL* handle, const ConnectionOptions& options) {
+#if LIBCURL_VERSION_NUM >= 0x072800
+	if (!options.unix_socket_path.empty())
+		SetCurlOption(handle, CURLOPT_UNIX_SOCKET_PATH, options.unix_socket_path.c_str());
+#endif
+	if (options.accept_compressed_responses)
+		// Empty string means all encodings libcurl is built with
+		SetCurlOption(handle, CURLOPT_ACCEPT_ENCODING, "");
+}
+
+// Thread safe. Idle handles keep their connections alive
+// for subsequent requests.
+class CurlHandlePool { // noncopyable
+public:
+	CurlHandlePool() {}
+
+	~CurlHandlePool() {
+		std::for_each(idle_handles_.begin(), idle_handles_.end(), curl_easy_cleanup);
+	}
+
+	// Borrows a handle for the lifetime of the object.
+	class Handle { // noncopyable
+	public:
+		explicit Handle(CurlHandlePool& pool)
+			: pool_(pool)
+			, handle_(pool.Acquire())
+		{}
+
+		~Handle() {
+			pool_.Release(handle_);
+		}
+
+		operator CURL* () const {
+			return handle_;
+		}
+
+	private:
+		Handle(Handle&);
+		Handle& operator = (Handle&);
+
+	private:
+		CurlHandlePool& pool_;
+		CURL *const handle_;
+	};
+
+private:
+	CURL* Acquire() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!idle_handles_.empty()) {
+				CURL *const result = idle_handles_.back();
+				idle_handles_.pop_back();
+				return result;
+			}
+		}
+		CURL *const result = curl_easy_init();
+		WEBDRIVERXX_CHECK(result, "Cannot initialize CURL");
+		return result;
+	}
+
+	void Release(CURL* handle) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		idle_handles_.push_back(handle);
+	}
+
+	CurlHandlePool(CurlHandlePool&);
+	CurlHandlePool& operator = (CurlHandlePool&);
+
+private:
+	std::mutex mutex_;
+	std::vector<CURL*> idle_handles_;
+};
+
+// Thread safe. Every request borrows a CURL handle from a pool, so
+// concurrent requests don't wait for each other and idle handles
+// keep their connections alive for subsequent requests.
 class HttpConnection // noncopyable
 	: public IHttpClient
 	, public SharedObjectBase
 {
 public:
-	HttpConnection()
-		: connection_(InitCurl())
+	explicit HttpConnection(const ConnectionOptions& options = ConnectionOptions())
+		: options_(CheckConnectionOptions(options))
 	{}
 
-	~HttpConnection() {
-		curl_easy_cleanup(connection_);
+	HttpResponse Get(const std::string& url) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpGetRequest request(connection, url);
+		return Perform(request, connection);
 	}
 
-	HttpResponse Get(const std::string& url) const {
-		return HttpGetRequest(connection_, url).Execute();
+	HttpResponse GetStreamed(const std::string& url, const HttpBodySink& sink) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpGetRequest request(connection, url);
+		request.SetBodySink(sink);
+		return Perform(request, connection);
 	}
-	
+
 	HttpResponse Delete(const std::string& url) const {
-		return HttpDeleteRequest(connection_, url).Execute();
+		const CurlHandlePool::Handle connection(handles_);
+		HttpDeleteRequest request(connection, url);
+		return Perform(request, connection);
 	}
-	
+
 	HttpResponse Post(
 		const std::string& url,
 		const std::string& upload_data
 		) const {
-		return HttpPostRequest(connection_, url, upload_data).Execute();
+		const CurlHandlePool::Handle connection(handles_);
+		HttpPostRequest request(connection, url, upload_data,
+			options_.request_compression_threshold);
+		return Perform(request, connection);
+	}
+
+	// Never compressed, the size is known only before compression.
+	HttpResponse PostStreamed(
+		const std::string& url,
+		size_t size,
+		const HttpBodySource& source
+		) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpStreamedPostRequest request(connection, url, size, source);
+		return Perform(request, connection);
 	}
 
 private:
-	static
-	CURL* InitCurl() {
-		CURL *const result = curl_easy_init();
-		WEBDRIVERXX_CHECK(result, "Cannot initialize CURL");
-		return result;
+	HttpResponse Perform(HttpRequest& request, CURL* handle) const {
+		HttpResponse response;
+		request.Prepare(response);
+		SetConnectionOptions(handle, options_);
+		request.Complete(curl_easy_perform(handle), response);
+		return response;
 	}
 
 private:
-	CURL *const connection_;
+	const ConnectionOptions options_;
+	mutable CurlHandlePool handles_;
 };
 
 } // namespace detail
@@ -0,0 +1,241 @@
+#ifndef WEBDRIVERXX_DETAIL_HTTP_MULTIPLEXER_H
+#define WEBDRIVERXX_DETAIL_HTTP_MULTIPLEXER_H
+
+#include "http_client.h"
+#include "http_connection.h"
+#include "http_request.h"
+#include "error_handling.h"
+#include "shared.h"
+#include "../connection_options.h"
+#include <curl/curl.h>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE appeared in libcurl 7.49.0
+#if LIBCURL_VERSION_NUM >= 0x073100
+	#define WEBDRIVERXX_HAS_HTTP_MULTIPLEXER 1
+#else
+	#define WEBDRIVERXX_HAS_HTTP_MULTIPLEXER 0
+#endif
+
+#if WEBDRIVERXX_HAS_HTTP_MULTIPLEXER
+
+namespace webdriverxx {
+namespace detail {
+
+// Thread safe. Sends concurrent requests as HTTP/2 streams of a single
+// connection per host. Requests are performed by a background thread
+// running a curl multi handle, callers block until their request is done.
+class HttpMultiplexer // noncopyable
+	: public IHttpClient
+	, public SharedObjectBase
+{
+public:
+	HttpMultiplexer()
+		: HttpMultiplexer(ConnectionOptions().SetHttpVersion(http_version::Http2))
+	{}
+
+	explicit HttpMultiplexer(const ConnectionOptions& options)
+		: http_version_(GetCurlHttpVersion(options.http_version))
+		, options_(CheckConnectionOptions(options))
+		, state_(std::make_shared<State>())
+		, thread_(&HttpMultiplexer::Run, state_)
+	{}
+
+	~HttpMultiplexer() {
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			state_->stopping = true;
+		}
+		WakeUp();
+		thread_.join();
+	}
+
+	HttpResponse Get(const std::string& url) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpGetRequest request(connection, url);
+		return Perform(request, connection);
+	}
+
+	// The sink is called from the background thread.
+	HttpResponse GetStreamed(const std::string& url, const HttpBodySink& sink) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpGetRequest request(connection, url);
+		request.SetBodySink(sink);
+		return Perform(request, connection);
+	}
+
+	HttpResponse Delete(const std::string& url) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpDeleteRequest request(connection, url);
+		return Perform(request, connection);
+	}
+
+	HttpResponse Post(
+		const std::string& url,
+		const std::string& upload_data
+		) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpPostRequest request(connection, url, upload_data,
+			options_.request_compression_threshold);
+		return Perform(request, connection);
+	}
+
+	HttpResponse PostStreamed(
+		const std::string& url,
+		size_t size,
+		const HttpBodySource& source
+		) const {
+		const CurlHandlePool::Handle connection(handles_);
+		HttpStreamedPostRequest request(connection, url, size, source);
+		return Perform(request, connection);
+	}
+
+private:
+	// Lives on the stack of the requesting thread until it's done.
+	struct Transfer {
+		CURL* handle;
+		CURLcode result;
+		bool done;
+		std::condition_variable completed;
+	};
+
+	// Owned by the thread too, so it outlives the thread.
+	struct State {
+		std::mutex mutex;
+		std::vector<Transfer*> pending;
+		bool stopping;
+		CURLM *const multi;
+
+		State()
+			: stopping(false)
+			, multi(curl_multi_init())
+		{
+			WEBDRIVERXX_CHECK(multi, "Cannot initialize CURL multi handle");
+			#ifdef CURLPIPE_MULTIPLEX
+				curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+			#endif
+		}
+
+		~State() {
+			curl_multi_cleanup(multi);
+		}
+	};
+
+	static
+	long GetCurlHttpVersion(http_version::Value version) {
+		const bool has_http2 = (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2) != 0;
+		switch (version) {
+		case http_version::Http2:
+			// Falls back to HTTP/1.1, still with the shared connection pool
+			return has_http2 ? CURL_HTTP_VERSION_2_0 : CURL_HTTP_VERSION_1_1;
+		case http_version::Http2PriorKnowledge:
+			WEBDRIVERXX_CHECK(has_http2, "libcurl is built without HTTP/2 support");
+			return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+		default:
+			return CURL_HTTP_VERSION_1_1;
+		}
+	}
+
+	HttpResponse Perform(HttpRequest& request, CURL* handle) const {
+		HttpResponse response;
+		request.Prepare(response);
+		SetCurlOption(handle, CURLOPT_HTTP_VERSION, http_version_);
+		// Wait for a connection that can be multiplexed instead of opening a new one
+		SetCurlOption(handle, CURLOPT_PIPEWAIT, 1L);
+		SetConnectionOptions(handle, options_);
+		request.Complete(Execute(handle), response);
+		return response;
+	}
+
+	CURLcode Execute(CURL* handle) const {
+		Transfer transfer;
+		transfer.handle = handle;
+		transfer.result = CURLE_OK;
+		transfer.done = false;
+		std::unique_lock<std::mutex> lock(state_->mutex);
+		state_->pending.push_back(&transfer);
+		WakeUp();
+		transfer.completed.wait(lock, [&transfer]{ return transfer.done; });
+		return transfer.result;
+	}
+
+	void WakeUp() const {
+		#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+			curl_multi_wakeup(state_->multi);
+		#endif
+	}
+
+	static
+	void Finish(State& state, Transfer* transfer, CURLcode result) {
+		std::lock_guard<std::mutex> lock(state.mutex);
+		transfer->result = result;
+		transfer->done = true;
+		// Under the lock, the transfer is gone as soon as it's released
+		transfer->completed.notify_one();
+	}
+
+	static
+	void Run(std::shared_ptr<State> state) {
+		std::map<CURL*, Transfer*> active;
+		for (;;) {
+			std::vector<Transfer*> added;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (state->stopping && state->pending.empty() && active.empty())
+					return;
+				added.swap(state->pending);
+			}
+			for (const auto transfer : added) {
+				const CURLMcode result = curl_multi_add_handle(state->multi, transfer->handle);
+				if (result == CURLM_OK)
+					active[transfer->handle] = transfer;
+				else
+					Finish(*state, transfer, CURLE_FAILED_INIT);
+			}
+
+			int running = 0;
+			curl_multi_perform(state->multi, &running);
+
+			int left = 0;
+			while (CURLMsg *const message = curl_multi_info_read(state->multi, &left)) {
+				if (message->msg != CURLMSG_DONE)
+					continue;
+				CURL *const handle = message->easy_handle;
+				const CURLcode result = message->data.result;
+				curl_multi_remove_handle(state->multi, handle);
+				const auto it = active.find(handle);
+				if (it != active.end()) {
+					Transfer *const transfer = it->second;
+					active.erase(it);
+					Finish(*state, transfer, result);
+				}
+			}
+
+			#if LIBCURL_VERSION_NUM >= 0x074400
+				curl_multi_poll(state->multi, nullptr, 0, 1000, nullptr);
+			#else
+				curl_multi_wait(state->multi, nullptr, 0, 10, nullptr);
+			#endif
+		}
+	}
+
+private:
+	const long http_version_;
+	const ConnectionOptions options_;
+	mutable CurlHandlePool handles_;
+	const std::shared_ptr<State> state_;
+	std::thread thread_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif // WEBDRIVERXX_HAS_HTTP_MULTIPLEXER
+
+#endif
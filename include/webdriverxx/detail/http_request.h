@@ -2,7 +2,12 @@
 #define WEBDRIVERXX_DETAIL_HTTP_REQUEST_H
 
 #include "error_handling.h"
+#include "gzip.h"
+#include "http_client.h"
+#include "time.h"
+#include "../cancellation.h"
 #include <curl/curl.h>
+#include <exception>
 #include <string>
 #include <algorithm>
 
@@ -32,6 +37,17 @@ private:
 	curl_slist* head_;
 };
 
+template<typename T>
+void SetCurlOption(CURL* handle, CURLoption option, const T& value) {
+	const auto result = curl_easy_setopt(handle, option, value);
+	WEBDRIVERXX_CHECK(result == CURLE_OK, Fmt()
+		<< "Cannot set HTTP session option ("
+		<< "option: " << option
+		<< ", message: \"" << curl_easy_strerror(result) << "\""
+		<< ")"
+		);
+}
+
 class HttpRequest {
 public:
 	HttpRequest(
@@ -40,48 +56,93 @@ public:
 		)
 		: http_connection_(http_connection)
 		, url_(url)
+		, response_(nullptr)
+		, http_code_(0)
+		, is_sink_stopped_(false)
 	{}
 
 	virtual ~HttpRequest() {}
 
+	// Should be called before Prepare(). The sink is called
+	// from the thread that performs the request.
+	void SetBodySink(const HttpBodySink& sink) {
+		sink_ = sink;
+	}
+
 	HttpResponse Execute() {
+		HttpResponse response;
+		Prepare(response);
+		Complete(curl_easy_perform(http_connection_), response);
+		return response;
+	}
+
+	// Execute() split in two for callers that perform requests
+	// themselves. Both should be called from the requesting thread.
+	void Prepare(HttpResponse& response) {
+		cancellation_ = CancellationContext::Capture();
+		cancellation_.ThrowIfCancelled();
 		curl_easy_reset(http_connection_);
 		SetOption(CURLOPT_URL, url_.c_str());
-		HttpResponse response;
-		SetOption(CURLOPT_WRITEFUNCTION, &WriteCallback);
-		SetOption(CURLOPT_WRITEDATA, &response.body);
-		char error_message[CURL_ERROR_SIZE];
-  		SetOption(CURLOPT_ERRORBUFFER, &error_message);
+		if (sink_) {
+			response_ = &response;
+			http_code_ = 0;
+			is_sink_stopped_ = false;
+			sink_error_ = std::exception_ptr();
+			SetOption(CURLOPT_WRITEFUNCTION, &SinkCallback);
+			SetOption(CURLOPT_WRITEDATA, this);
+		} else {
+			SetOption(CURLOPT_WRITEFUNCTION, &WriteCallback);
+			SetOption(CURLOPT_WRITEDATA, &response.body);
+		}
+		error_message_[0] = 0;
+		SetOption(CURLOPT_ERRORBUFFER, error_message_);
 		AddHeader("Accept", kContentTypeJson);
 		
 		SetCustomRequestOptions();
 		
 		SetOption(CURLOPT_HTTPHEADER, headers_.Get());
 
-		const CURLcode result = curl_easy_perform(http_connection_);
+		if (!cancellation_.IsEmpty())
+			SetCancellationOptions(cancellation_);
+	}
+
+	void Complete(CURLcode result, HttpResponse& response) const {
+		if (sink_error_)
+			std::rethrow_exception(sink_error_);
+		if (result == CURLE_WRITE_ERROR && is_sink_stopped_)
+			result = CURLE_OK;
+		WEBDRIVERXX_CHECK(result != CURLE_ABORTED_BY_CALLBACK, "HTTP request is cancelled");
+		WEBDRIVERXX_CHECK(result != CURLE_OPERATION_TIMEDOUT || !cancellation_.IsCancelled(),
+			"HTTP request deadline is exceeded");
 		WEBDRIVERXX_CHECK(result == CURLE_OK, Fmt()
 			<< "Cannot perform HTTP request ("
 			<< "result: " << result
-			<< ", message: " << error_message
+			<< ", message: " << error_message_
 			<< ")"
 			);
 
 		response.http_code = GetHttpCode();
-		return response;
+	#if LIBCURL_VERSION_NUM >= 0x073700 // 7.55.0
+		response.bytes_sent_on_wire = GetInfo<curl_off_t>(CURLINFO_SIZE_UPLOAD_T);
+		response.bytes_received_on_wire = GetInfo<curl_off_t>(CURLINFO_SIZE_DOWNLOAD_T);
+	#else
+		response.bytes_sent_on_wire = GetInfo<double>(CURLINFO_SIZE_UPLOAD);
+		response.bytes_received_on_wire = GetInfo<double>(CURLINFO_SIZE_DOWNLOAD);
+	#endif
 	}
 
 protected:
 	virtual void SetCustomRequestOptions() {}
 
+	// Exceptions can't pass through libcurl, so callbacks keep
+	// them until Complete().
+	void SetCallbackError(std::exception_ptr error) {
+		sink_error_ = error;
+	}
+
 	template<typename T>
 	void SetOption(CURLoption option, const T& value) const {
-		const auto result = curl_easy_setopt(http_connection_, option, value);
-		WEBDRIVERXX_CHECK(result == CURLE_OK, Fmt()
-			<< "Cannot set HTTP session option ("
-			<< "option: " << option
-			<< ", message: \"" << curl_easy_strerror(result) << "\""
-			<< ")"
-			);
+		SetCurlOption(http_connection_, option, value);
 	}
 
 	void AddHeader(const std::string& name, const std::string& value) {
@@ -98,6 +159,45 @@ private:
 		return http_code;
 	}
 
+	// Counts bodies as they were transferred, before decoding.
+	template<typename T>
+	size_t GetInfo(CURLINFO info) const {
+		T value = 0;
+		return curl_easy_getinfo(http_connection_, info, &value) == CURLE_OK ?
+			static_cast<size_t>(value) : 0;
+	}
+
+	// Deadline becomes a transfer timeout, Cancel() is noticed by the progress
+	// callback, which libcurl calls at least once per second.
+	void SetCancellationOptions(const CancellationContext& cancellation) {
+		SetOption(CURLOPT_NOSIGNAL, 1L);
+		const TimePoint deadline = cancellation.GetDeadline();
+		if (deadline) {
+			const TimePoint now = Now();
+			SetOption(CURLOPT_TIMEOUT_MS, deadline > now ? static_cast<long>(deadline - now) : 1L);
+		}
+		SetOption(CURLOPT_NOPROGRESS, 0L);
+	#if LIBCURL_VERSION_NUM >= 0x072000 // 7.32.0
+		SetOption(CURLOPT_XFERINFOFUNCTION, &TransferInfoCallback);
+		SetOption(CURLOPT_XFERINFODATA, &cancellation);
+	#else
+		SetOption(CURLOPT_PROGRESSFUNCTION, &ProgressCallback);
+		SetOption(CURLOPT_PROGRESSDATA, &cancellation);
+	#endif
+	}
+
+	#if LIBCURL_VERSION_NUM >= 0x072000
+	static
+	int TransferInfoCallback(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+		return reinterpret_cast<const CancellationContext*>(userdata)->IsCancelled() ? 1 : 0;
+	}
+	#else
+	static
+	int ProgressCallback(void* userdata, double, double, double, double) {
+		return reinterpret_cast<const CancellationContext*>(userdata)->IsCancelled() ? 1 : 0;
+	}
+	#endif
+
 	static
 	size_t WriteCallback(void* buffer, size_t size, size_t nmemb, void* userdata) {
 		std::string* data_received = reinterpret_cast<std::string*>(userdata);
@@ -106,6 +206,30 @@ private:
 		return buffer_size;
 	}
 
+	static
+	size_t SinkCallback(void* buffer, size_t size, size_t nmemb, void* userdata) {
+		HttpRequest* that = reinterpret_cast<HttpRequest*>(userdata);
+		const char* data = reinterpret_cast<const char*>(buffer);
+		const auto buffer_size = size * nmemb;
+		try {
+			if (!that->http_code_)
+				that->http_code_ = that->GetHttpCode();
+			if (that->http_code_ != 200) {
+				that->response_->body.append(data, buffer_size);
+				return buffer_size;
+			}
+			that->response_->bytes_streamed += buffer_size;
+			if (!that->sink_(data, buffer_size)) {
+				that->is_sink_stopped_ = true;
+				return 0;
+			}
+		} catch (...) {
+			that->SetCallbackError(std::current_exception());
+			return 0;
+		}
+		return buffer_size;
+	}
+
 private:
 	HttpRequest(HttpRequest&);
 	HttpRequest& operator=(HttpRequest&);
@@ -114,6 +238,13 @@ private:
 	CURL *const http_connection_;
 	const std::string url_;
 	HttpHeaders headers_;
+	CancellationContext cancellation_;
+	char error_message_[CURL_ERROR_SIZE];
+	HttpBodySink sink_;
+	HttpResponse* response_;
+	long http_code_;
+	bool is_sink_stopped_;
+	std::exception_ptr sink_error_;
 };
 
 typedef HttpRequest HttpGetRequest;
@@ -132,15 +263,19 @@ private:
 
 class HttpPostRequest : public HttpRequest {
 public:
+	// Bodies of at least compression_threshold bytes are sent gzipped.
 	HttpPostRequest(
 		CURL* http_connection,
 		const std::string& url,
-		const std::string& upload_data
+		const std::string& upload_data,
+		size_t compression_threshold = 0
 		)
 		: HttpRequest(http_connection, url)
-		, upload_data_(upload_data)
-		, unsent_ptr_(upload_data.c_str())
-		, unsent_length_(upload_data.size())
+		, is_compressed_(compression_threshold && upload_data.size() >= compression_threshold)
+		, compressed_data_(is_compressed_ ? Compress(upload_data) : std::string())
+		, upload_data_(is_compressed_ ? compressed_data_ : upload_data)
+		, unsent_ptr_(upload_data_.c_str())
+		, unsent_length_(upload_data_.size())
 	{}
 
 protected:
@@ -148,11 +283,23 @@ protected:
 		SetOption(CURLOPT_POST, 1L);
 		SetOption(CURLOPT_POSTFIELDSIZE, upload_data_.length());
 		AddHeader("Content-Type", kContentTypeJson);
+		if (is_compressed_)
+			AddHeader("Content-Encoding", "gzip");
 		SetOption(CURLOPT_READFUNCTION, ReadCallback);
 		SetOption(CURLOPT_READDATA, this);
 	}
 
 private:
+	static
+	std::string Compress(const std::string& data) {
+	#ifdef WEBDRIVERXX_ENABLE_ZLIB
+		return Gzip(data);
+	#else
+		WEBDRIVERXX_THROW(Fmt() << "Request compression requires zlib, "
+			<< "define WEBDRIVERXX_ENABLE_ZLIB to enable it (data size: " << data.size() << ")");
+	#endif
+	}
+
 	static
 	size_t ReadCallback(void* buffer, size_t size, size_t nmemb, void* userdata) {
 		HttpPostRequest* that = reinterpret_cast<HttpPostRequest*>(userdata);
@@ -166,11 +313,56 @@ private:
 	}
 
 private:
+	const bool is_compressed_;
+	const std::string compressed_data_;
 	const std::string& upload_data_;
 	const char* unsent_ptr_;
 	size_t unsent_length_;
 };
 
+// Sends a body of known size that is produced while being sent.
+class HttpStreamedPostRequest : public HttpRequest {
+public:
+	HttpStreamedPostRequest(
+		CURL* http_connection,
+		const std::string& url,
+		size_t size,
+		const HttpBodySource& source
+		)
+		: HttpRequest(http_connection, url)
+		, size_(size)
+		, source_(source)
+	{}
+
+protected:
+	void SetCustomRequestOptions() {
+		SetOption(CURLOPT_POST, 1L);
+		SetOption(CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(size_));
+		AddHeader("Content-Type", kContentTypeJson);
+		// Streamed bodies are large, without this curl waits for
+		// "100 Continue" before sending, which drivers do not send
+		AddHeader("Expect", "");
+		SetOption(CURLOPT_READFUNCTION, ReadCallback);
+		SetOption(CURLOPT_READDATA, this);
+	}
+
+private:
+	static
+	size_t ReadCallback(void* buffer, size_t size, size_t nmemb, void* userdata) {
+		HttpStreamedPostRequest* that = reinterpret_cast<HttpStreamedPostRequest*>(userdata);
+		try {
+			return that->source_(reinterpret_cast<char*>(buffer), size * nmemb);
+		} catch (...) {
+			that->SetCallbackError(std::current_exception());
+			return CURL_READFUNC_ABORT;
+		}
+	}
+
+private:
+	const size_t size_;
+	const HttpBodySource source_;
+};
+
 } // namespace detail
 } // namespace webdriverxx
 
@@ -0,0 +1,223 @@
+#ifndef WEBDRIVERXX_DETAIL_JSON_STREAM_H
+#define WEBDRIVERXX_DETAIL_JSON_STREAM_H
+
+#include "error_handling.h"
+#include <cctype>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace webdriverxx {
+namespace detail {
+
+inline
+void AppendUtf8(std::string& out, unsigned code_point) {
+	if (code_point < 0x80) {
+		out += static_cast<char>(code_point);
+	} else if (code_point < 0x800) {
+		out += static_cast<char>(0xC0 | (code_point >> 6));
+		out += static_cast<char>(0x80 | (code_point & 0x3F));
+	} else if (code_point < 0x10000) {
+		out += static_cast<char>(0xE0 | (code_point >> 12));
+		out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (code_point & 0x3F));
+	} else {
+		out += static_cast<char>(0xF0 | (code_point >> 18));
+		out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+		out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (code_point & 0x3F));
+	}
+}
+
+// Takes a JSON object piece by piece and passes the unescaped contents
+// of its top level string member to the handler as they arrive. Other
+// members are kept, so the rest of the object can be parsed as usual
+// when the document ends. Pieces may split escape sequences anywhere.
+class JsonStringStreamer { // noncopyable
+public:
+	// Returns false to stop reading.
+	typedef std::function<bool(const std::string& chunk)> ChunkHandler;
+
+	explicit JsonStringStreamer(const ChunkHandler& handler, const std::string& member = "value")
+		: handler_(handler)
+		, member_(member)
+		, depth_(0)
+		, in_string_(false)
+		, escaped_(false)
+		, expect_key_(false)
+		, is_key_(false)
+		, after_colon_(false)
+		, streaming_(false)
+		, streamed_(false)
+		, stopped_(false)
+		, high_surrogate_(0)
+	{}
+
+	// Returns false if the handler asked to stop.
+	bool Feed(const char* data, size_t size) {
+		if (stopped_)
+			return false;
+		for (const char* const end = data + size; data != end; ++data) {
+			if (streaming_) {
+				StreamChar(*data);
+				if (!streaming_ && !Flush())
+					return false;
+			} else {
+				ScanChar(*data);
+			}
+		}
+		return Flush();
+	}
+
+	// Whether the member was a string and was passed to the handler.
+	bool IsStreamed() const {
+		return streamed_;
+	}
+
+	bool IsStopped() const {
+		return stopped_;
+	}
+
+	// The document with the streamed string replaced by an empty one.
+	const std::string& GetRest() const {
+		return rest_;
+	}
+
+private:
+	void ScanChar(char c) {
+		rest_ += c;
+		if (in_string_) {
+			if (escaped_)
+				escaped_ = false;
+			else if (c == '\\')
+				escaped_ = true;
+			else if (c == '"') {
+				in_string_ = false;
+				return;
+			}
+			if (is_key_)
+				key_ += c;
+			return;
+		}
+		if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			return;
+		if (after_colon_) {
+			after_colon_ = false;
+			if (c == '"' && key_ == member_ && !streamed_) {
+				rest_ += '"';
+				streaming_ = true;
+				return;
+			}
+		}
+		switch (c) {
+		case '"':
+			in_string_ = true;
+			is_key_ = expect_key_;
+			expect_key_ = false;
+			if (is_key_)
+				key_.clear();
+			break;
+		case '{':
+		case '[':
+			expect_key_ = ++depth_ == 1 && c == '{';
+			break;
+		case '}':
+		case ']':
+			--depth_;
+			break;
+		case ',':
+			expect_key_ = depth_ == 1;
+			break;
+		case ':':
+			after_colon_ = depth_ == 1;
+			break;
+		}
+	}
+
+	void StreamChar(char c) {
+		if (!escape_.empty()) {
+			escape_ += c;
+			if (escape_.size() == 6 || (escape_.size() == 2 && c != 'u')) {
+				Unescape();
+				escape_.clear();
+			}
+		} else if (c == '\\') {
+			escape_ = c;
+		} else if (c == '"') {
+			streaming_ = false;
+			streamed_ = true;
+		} else {
+			chunk_ += c;
+		}
+	}
+
+	void Unescape() {
+		const char c = escape_[1];
+		if (c != 'u') {
+			high_surrogate_ = 0;
+			switch (c) {
+			case 'b': chunk_ += '\b'; break;
+			case 'f': chunk_ += '\f'; break;
+			case 'n': chunk_ += '\n'; break;
+			case 'r': chunk_ += '\r'; break;
+			case 't': chunk_ += '\t'; break;
+			case '"': case '\\': case '/': chunk_ += c; break;
+			default:
+				WEBDRIVERXX_THROW(Fmt() << "Invalid escape sequence in JSON string (" << escape_ << ")");
+			}
+			return;
+		}
+		unsigned code = 0;
+		for (size_t i = 2; i < escape_.size(); ++i) {
+			const char h = escape_[i];
+			WEBDRIVERXX_CHECK(std::isxdigit(static_cast<unsigned char>(h)), Fmt()
+				<< "Invalid escape sequence in JSON string (" << escape_ << ")");
+			code = code * 16 + (h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10);
+		}
+		if (code >= 0xD800 && code < 0xDC00) {
+			high_surrogate_ = code;
+		} else if (code >= 0xDC00 && code < 0xE000 && high_surrogate_) {
+			AppendUtf8(chunk_, 0x10000 + ((high_surrogate_ - 0xD800) << 10) + (code - 0xDC00));
+			high_surrogate_ = 0;
+		} else {
+			AppendUtf8(chunk_, code);
+			high_surrogate_ = 0;
+		}
+	}
+
+	bool Flush() {
+		if (chunk_.empty())
+			return true;
+		const bool proceed = handler_(chunk_);
+		chunk_.clear();
+		stopped_ = !proceed;
+		return proceed;
+	}
+
+private:
+	JsonStringStreamer(JsonStringStreamer&);
+	JsonStringStreamer& operator = (JsonStringStreamer&);
+
+private:
+	const ChunkHandler handler_;
+	const std::string member_;
+	std::string rest_;
+	std::string key_;
+	std::string chunk_;
+	std::string escape_;
+	int depth_;
+	bool in_string_;
+	bool escaped_;
+	bool expect_key_;
+	bool is_key_;
+	bool after_colon_;
+	bool streaming_;
+	bool streamed_;
+	bool stopped_;
+	unsigned high_surrogate_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef WEBDRIVERXX_DETAIL_PIXEL_DIFF_H
+#define WEBDRIVERXX_DETAIL_PIXEL_DIFF_H
+
+#include "../types.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+// Like in template_match.h, the kernels are plain loops over contiguous
+// bytes without branches, which compilers vectorize for the build target.
+
+// Marks pixels of a row whose channels differ by more than the tolerance.
+// Takes RGBA rows, writes 1 or 0 per pixel. channel_diffs is a scratch
+// buffer of width * 4 bytes.
+inline
+void DiffPixelRow(const unsigned char* a, const unsigned char* b, int width, int tolerance,
+	unsigned char* channel_diffs, unsigned char* mismatches) {
+	const int size = width * 4;
+	for (int i = 0; i < size; ++i)
+		channel_diffs[i] = static_cast<unsigned char>(std::max(a[i], b[i]) - std::min(a[i], b[i]));
+	const unsigned char limit = static_cast<unsigned char>(std::max(0, std::min(tolerance, 255)));
+	for (int x = 0; x < width; ++x) {
+		const unsigned char* d = channel_diffs + x * 4;
+		const unsigned char largest = std::max(std::max(d[0], d[1]), std::max(d[2], d[3]));
+		mismatches[x] = largest > limit ? 1 : 0;
+	}
+}
+
+// Marks pixels of row y that are inside any of the regions.
+inline
+void MarkIgnoredPixels(const std::vector<Rect>& regions, int y, int width, unsigned char* ignored) {
+	std::fill(ignored, ignored + width, 0);
+	for (const Rect& region : regions) {
+		if (y < region.y || y >= region.y + region.height)
+			continue;
+		const int begin = std::max(0, region.x);
+		const int end = std::min(width, region.x + region.width);
+		if (begin < end)
+			std::fill(ignored + begin, ignored + end, 1);
+	}
+}
+
+// Difference hash: the image is shrunk to 9x8 averages of grayscale
+// pixels, every bit tells whether a cell is brighter than its right
+// neighbour. Close images have hashes that differ in few bits.
+inline
+unsigned long long GetDifferenceHash(const unsigned char* rgba, int width, int height) {
+	const int kColumns = 9, kRows = 8;
+	double cells[kRows][kColumns] = {};
+	for (int row = 0; row < kRows; ++row) {
+		const int top = row * height / kRows;
+		const int bottom = std::max(top + 1, (row + 1) * height / kRows);
+		for (int y = top; y < bottom && y < height; ++y) {
+			const unsigned char* line = rgba + static_cast<size_t>(y) * width * 4;
+			for (int column = 0; column < kColumns; ++column) {
+				const int left = column * width / kColumns;
+				const int right = std::max(left + 1, (column + 1) * width / kColumns);
+				unsigned sum = 0;
+				for (int x = left; x < right && x < width; ++x)
+					sum += 299 * line[x * 4] + 587 * line[x * 4 + 1] + 114 * line[x * 4 + 2];
+				cells[row][column] += static_cast<double>(sum) / (right - left);
+			}
+		}
+	}
+	unsigned long long result = 0;
+	for (int row = 0; row < kRows; ++row)
+		for (int column = 0; column + 1 < kColumns; ++column)
+			result = (result << 1) | (cells[row][column] > cells[row][column + 1] ? 1 : 0);
+	return result;
+}
+
+inline
+int CountDifferentBits(unsigned long long a, unsigned long long b) {
+	int result = 0;
+	for (unsigned long long bits = a ^ b; bits; bits &= bits - 1)
+		++result;
+	return result;
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef WEBDRIVERXX_DETAIL_PNG_H
+#define WEBDRIVERXX_DETAIL_PNG_H
+
+#include "base64.h"
+#include "error_handling.h"
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+const char *const kPngSignature = "\x89PNG\r\n\x1a\n";
+
+inline
+unsigned ReadPngUint(const std::string& data, size_t offset) {
+	return (static_cast<unsigned>(static_cast<unsigned char>(data[offset])) << 24)
+		| (static_cast<unsigned>(static_cast<unsigned char>(data[offset + 1])) << 16)
+		| (static_cast<unsigned>(static_cast<unsigned char>(data[offset + 2])) << 8)
+		| static_cast<unsigned>(static_cast<unsigned char>(data[offset + 3]));
+}
+
+inline
+void WritePngUint(std::string& out, unsigned value) {
+	out += static_cast<char>((value >> 24) & 0xFF);
+	out += static_cast<char>((value >> 16) & 0xFF);
+	out += static_cast<char>((value >> 8) & 0xFF);
+	out += static_cast<char>(value & 0xFF);
+}
+
+inline
+unsigned char PaethPredictor(int a, int b, int c) {
+	const int p = a + b - c;
+	const int pa = std::abs(p - a);
+	const int pb = std::abs(p - b);
+	const int pc = std::abs(p - c);
+	return static_cast<unsigned char>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// Reverses the filter of a row in place. The previous row is unfiltered
+// already and is all zeros for the first row.
+inline
+void UnfilterPngRow(int filter, unsigned char* row, const unsigned char* previous,
+	size_t size, size_t step) {
+	switch (filter) {
+	case 0:
+		break;
+	case 1:
+		for (size_t i = step; i < size; ++i)
+			row[i] = static_cast<unsigned char>(row[i] + row[i - step]);
+		break;
+	case 2:
+		for (size_t i = 0; i < size; ++i)
+			row[i] = static_cast<unsigned char>(row[i] + previous[i]);
+		break;
+	case 3:
+		for (size_t i = 0; i < size; ++i)
+			row[i] = static_cast<unsigned char>(row[i]
+				+ (((i >= step ? row[i - step] : 0) + previous[i]) >> 1));
+		break;
+	case 4:
+		for (size_t i = 0; i < size; ++i)
+			row[i] = static_cast<unsigned char>(row[i] + PaethPredictor(
+				i >= step ? row[i - step] : 0, previous[i], i >= step ? previous[i - step] : 0));
+		break;
+	default:
+		WEBDRIVERXX_THROW("Unknown PNG filter");
+	}
+}
+
+// Decodes a non-interlaced PNG image of any color type and bit depth
+// to 8-bit RGBA rows.
+inline
+std::vector<unsigned char> DecodePngRgba(const std::string& png, int& width, int& height) {
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+	WEBDRIVERXX_CHECK(png.size() >= 8 && png.compare(0, 8, kPngSignature) == 0, "Not a PNG image");
+	unsigned depth = 0, color_type = 0;
+	std::string palette, transparency, compressed;
+	bool has_header = false;
+	for (size_t offset = 8;;) {
+		WEBDRIVERXX_CHECK(offset + 12 <= png.size(), "Truncated PNG image");
+		const size_t size = ReadPngUint(png, offset);
+		WEBDRIVERXX_CHECK(size <= png.size() - offset - 12, "Truncated PNG image");
+		const std::string type = png.substr(offset + 4, 4);
+		const char* data = png.data() + offset + 8;
+		WEBDRIVERXX_CHECK(crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef*>(png.data() + offset + 4),
+			static_cast<uInt>(size + 4)) == ReadPngUint(png, offset + 8 + size), "Corrupted PNG image");
+		offset += size + 12;
+		if (type == "IHDR") {
+			WEBDRIVERXX_CHECK(size == 13, "Invalid PNG header");
+			const std::string header(data, size);
+			width = static_cast<int>(ReadPngUint(header, 0));
+			height = static_cast<int>(ReadPngUint(header, 4));
+			depth = static_cast<unsigned char>(header[8]);
+			color_type = static_cast<unsigned char>(header[9]);
+			WEBDRIVERXX_CHECK(width > 0 && height > 0 && width <= 65536 && height <= 65536,
+				"Unsupported PNG image size");
+			WEBDRIVERXX_CHECK(header[12] == 0, "Interlaced PNG images are not supported");
+			WEBDRIVERXX_CHECK(
+				(color_type == 0 && (depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16))
+				|| (color_type == 3 && (depth == 1 || depth == 2 || depth == 4 || depth == 8))
+				|| ((color_type == 2 || color_type == 4 || color_type == 6) && (depth == 8 || depth == 16)),
+				"Invalid PNG color type or bit depth");
+			has_header = true;
+		} else if (type == "PLTE") {
+			palette.assign(data, size);
+		} else if (type == "tRNS") {
+			transparency.assign(data, size); // Palette alphas or one transparent color
+		} else if (type == "IDAT") {
+			compressed.append(data, size);
+		} else if (type == "IEND") {
+			break;
+		}
+	}
+	WEBDRIVERXX_CHECK(has_header, "PNG image has no header");
+	WEBDRIVERXX_CHECK(color_type != 3 || !palette.empty(), "PNG image has no palette");
+
+	const unsigned channels = color_type == 2 ? 3 : color_type == 4 ? 2 : color_type == 6 ? 4 : 1;
+	// Gray and RGB images may have a transparent color: a sample of
+	// two bytes per channel, compared at the full bit depth
+	const bool has_color_key = (color_type == 0 || color_type == 2) && !transparency.empty();
+	WEBDRIVERXX_CHECK(!has_color_key || transparency.size() == channels * 2,
+		"Invalid PNG transparency");
+	const auto color_key = [&transparency](unsigned channel) -> unsigned {
+		return static_cast<unsigned char>(transparency[channel * 2]) << 8
+			| static_cast<unsigned char>(transparency[channel * 2 + 1]);
+	};
+	const size_t bits = channels * depth;
+	const size_t row_size = (static_cast<size_t>(width) * bits + 7) / 8;
+	const size_t step = bits < 8 ? 1 : bits / 8;
+	std::vector<unsigned char> raw((row_size + 1) * static_cast<size_t>(height));
+	z_stream stream = {};
+	WEBDRIVERXX_CHECK(inflateInit(&stream) == Z_OK, "Cannot initialize zlib");
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	stream.next_out = raw.data();
+	stream.avail_out = static_cast<uInt>(raw.size());
+	const int status = inflate(&stream, Z_FINISH);
+	const size_t inflated = stream.total_out;
+	inflateEnd(&stream);
+	WEBDRIVERXX_CHECK((status == Z_STREAM_END || status == Z_BUF_ERROR) && inflated == raw.size(),
+		"Cannot decompress PNG image data");
+
+	std::vector<unsigned char> result(static_cast<size_t>(width) * height * 4);
+	const std::vector<unsigned char> zeros(row_size);
+	const unsigned max_sample = (1u << (depth < 8 ? depth : 8)) - 1;
+	for (int y = 0; y < height; ++y) {
+		unsigned char* row = &raw[y * (row_size + 1) + 1];
+		UnfilterPngRow(row[-1], row, y ? row - row_size - 1 : zeros.data(), row_size, step);
+		unsigned char* out = &result[static_cast<size_t>(y) * width * 4];
+		for (int x = 0; x < width; ++x, out += 4) {
+			// Samples of 16 bits keep the high byte
+			const auto sample = [&](unsigned channel) -> unsigned {
+				if (depth >= 8)
+					return row[(x * channels + channel) * (depth / 8)];
+				const size_t bit = static_cast<size_t>(x) * depth;
+				return (row[bit / 8] >> (8 - depth - bit % 8)) & max_sample;
+			};
+			const auto is_color_key = [&]() -> bool {
+				for (unsigned channel = 0; channel < channels; ++channel) {
+					const size_t i = (x * channels + channel) * 2;
+					const unsigned exact = depth == 16 ? (row[i] << 8 | row[i + 1]) : sample(channel);
+					if (exact != color_key(channel))
+						return false;
+				}
+				return true;
+			};
+			if (color_type == 3) {
+				const unsigned index = sample(0);
+				WEBDRIVERXX_CHECK(index * 3 + 2 < palette.size(), "PNG palette index is out of range");
+				out[0] = static_cast<unsigned char>(palette[index * 3]);
+				out[1] = static_cast<unsigned char>(palette[index * 3 + 1]);
+				out[2] = static_cast<unsigned char>(palette[index * 3 + 2]);
+				out[3] = index < transparency.size() ? static_cast<unsigned char>(transparency[index]) : 255;
+			} else if (channels <= 2) {
+				out[0] = out[1] = out[2] = static_cast<unsigned char>(sample(0) * 255 / max_sample);
+				out[3] = channels == 2 ? static_cast<unsigned char>(sample(1))
+					: has_color_key && is_color_key() ? 0 : 255;
+			} else {
+				out[0] = static_cast<unsigned char>(sample(0));
+				out[1] = static_cast<unsigned char>(sample(1));
+				out[2] = static_cast<unsigned char>(sample(2));
+				out[3] = channels == 4 ? static_cast<unsigned char>(sample(3))
+					: has_color_key && is_color_key() ? 0 : 255;
+			}
+		}
+	}
+	return result;
+#else
+	(void)png; (void)width; (void)height;
+	WEBDRIVERXX_THROW("PNG decoding requires zlib, define WEBDRIVERXX_ENABLE_ZLIB to enable it");
+#endif
+}
+
+// Encodes 8-bit RGBA rows. Every row gets the filter with the smallest
+// sum of absolute differences, as libpng does.
+inline
+std::string EncodePngRgba(const unsigned char* rgba, int width, int height) {
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+	const size_t row_size = static_cast<size_t>(width) * 4;
+	std::string raw;
+	raw.reserve((row_size + 1) * height);
+	std::vector<unsigned char> filtered(row_size), best(row_size);
+	const std::vector<unsigned char> zeros(row_size);
+	for (int y = 0; y < height; ++y) {
+		const unsigned char* row = rgba + y * row_size;
+		const unsigned char* previous = y ? row - row_size : zeros.data();
+		unsigned long best_cost = static_cast<unsigned long>(-1);
+		int best_filter = 0;
+		for (int filter = 0; filter < 5; ++filter) {
+			unsigned long cost = 0;
+			for (size_t i = 0; i < row_size; ++i) {
+				const int left = i >= 4 ? row[i - 4] : 0;
+				const int up_left = i >= 4 ? previous[i - 4] : 0;
+				const int predicted =
+					filter == 0 ? 0 :
+					filter == 1 ? left :
+					filter == 2 ? previous[i] :
+					filter == 3 ? (left + previous[i]) >> 1 :
+					PaethPredictor(left, previous[i], up_left);
+				filtered[i] = static_cast<unsigned char>(row[i] - predicted);
+				cost += static_cast<unsigned long>(std::abs(static_cast<signed char>(filtered[i])));
+			}
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_filter = filter;
+				best.swap(filtered);
+			}
+		}
+		raw += static_cast<char>(best_filter);
+		raw.append(best.begin(), best.end());
+	}
+	uLongf compressed_size = compressBound(static_cast<uLong>(raw.size()));
+	std::string compressed(compressed_size, '\0');
+	WEBDRIVERXX_CHECK(compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size,
+		reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()),
+		Z_DEFAULT_COMPRESSION) == Z_OK, "Cannot compress PNG image data");
+	compressed.resize(compressed_size);
+
+	std::string result(kPngSignature, 8);
+	const auto chunk = [&result](const char* type, const std::string& data) {
+		WritePngUint(result, static_cast<unsigned>(data.size()));
+		const size_t start = result.size();
+		result.append(type, 4);
+		result += data;
+		WritePngUint(result, static_cast<unsigned>(crc32(crc32(0, nullptr, 0),
+			reinterpret_cast<const Bytef*>(result.data() + start), static_cast<uInt>(result.size() - start))));
+	};
+	std::string header;
+	WritePngUint(header, static_cast<unsigned>(width));
+	WritePngUint(header, static_cast<unsigned>(height));
+	header += '\x08'; // Bit depth
+	header += '\x06'; // RGBA
+	header.append(3, '\0'); // Deflate, adaptive filters, no interlace
+	chunk("IHDR", header);
+	chunk("IDAT", compressed);
+	chunk("IEND", std::string());
+	return result;
+#else
+	(void)rgba;
+	WEBDRIVERXX_THROW(Fmt() << "PNG encoding requires zlib, define WEBDRIVERXX_ENABLE_ZLIB to enable it"
+		<< " (size: " << width << "x" << height << ")");
+#endif
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
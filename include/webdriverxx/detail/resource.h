@@ -3,14 +3,33 @@
 
 #include "error_handling.h"
 #include "http_client.h"
+#include "json_stream.h"
 #include "shared.h"
+#include "transport.h"
+#include "../cancellation.h"
 #include "../conversions.h"
 #include "../response_status_code.h"
 #include <picojson.h>
+#include <mutex>
 
 namespace webdriverxx {
 namespace detail {
 
+// Whether a request can be sent again if it fails without a response.
+// Only reads, deletions and commands that don't change the page.
+inline
+bool IsSafeToRepeat(const std::string& request_type, const std::string& command) {
+	if (request_type != "POST")
+		return true;
+	return command == "element"
+		|| command == "elements"
+		|| command == "element/active"
+		|| command == "timeouts"
+		|| command == "timeouts/implicit_wait"
+		|| command == "timeouts/async_script"
+		;
+}
+
 class Resource : public SharedObjectBase { // noncopyable
 public:
 	enum Ownership { IsOwner, IsObserver };
@@ -20,9 +39,10 @@ public:
 		const Shared<IHttpClient>& http_client,
 		Ownership mode = IsObserver
 		)
-		: http_client_(http_client)
+		: transport_(new Transport(http_client))
 		, url_(url)
 		, ownership_(mode)
+		, released_(false)
 	{}
 
 	Resource(
@@ -30,16 +50,26 @@ public:
 		const std::string& name,
 		Ownership mode = IsObserver
 		)
-		: http_client_(parent->http_client_)
+		: transport_(parent->transport_)
 		, parent_(parent)
 		, url_(ConcatUrl(parent->url_, name))
 		, ownership_(mode)
+		, released_(false)
 	{}
 
 	virtual ~Resource() {
 		try {
-			if (ownership_ == IsOwner)
-				DeleteResource();
+			// Resources should be released even after cancellation, so
+			// tokens of the thread, the resource and its parents are ignored
+			const CancellationMask mask;
+			released_ = true;
+			if (ownership_ == IsOwner) {
+				const Shared<SessionReaper> reaper = transport_->GetSessionReaper();
+				if (reaper)
+					reaper->Queue(transport_->GetSharedHttpClient(), url_);
+				else
+					DeleteResource();
+			}
 		} catch (const std::exception&) {}
 	}
 
@@ -47,6 +77,26 @@ public:
 		return url_;
 	}
 
+	const Shared<Transport>& GetTransport() const {
+		return transport_;
+	}
+
+	// Empty for a root resource.
+	const Shared<Resource>& GetParent() const {
+		return parent_;
+	}
+
+	// Applies to requests of this resource and its subresources.
+	void SetCancellationToken(const CancellationToken& token) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		cancellation_token_ = token;
+	}
+
+	CancellationToken GetCancellationToken() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return cancellation_token_;
+	}
+
 	picojson::value Get(const std::string& command = std::string()) const {
 		return Download(command, &IHttpClient::Get, "GET");
 	}
@@ -68,6 +118,34 @@ public:
 		return GetValue<bool>(command);
 	}
 
+	// Passes the string value of the response to the handler in unescaped
+	// chunks as they are received, without keeping the whole value.
+	// Stops reading when the handler returns false.
+	void GetStreamed(const std::string& command, const JsonStringStreamer::ChunkHandler& handler) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		const CancellationScope cancellation(GetCancellationContext());
+		const std::string url = ConcatUrl(url_, command);
+		const IHttpClient& http_client = transport_->GetHttpClient();
+		JsonStringStreamer streamer(handler);
+		// Sent once, the handler may have seen a part of the value already
+		HttpResponse response = transport_->Send(false, 0, [&]{
+			return http_client.GetStreamed(url, [&streamer](const char* data, size_t size) {
+				return streamer.Feed(data, size);
+			});
+		});
+		if (streamer.IsStopped())
+			return;
+		if (response.http_code == 200)
+			response.body = streamer.GetRest();
+		ProcessResponse(response);
+		WEBDRIVERXX_CHECK(streamer.IsStreamed(), "Response value is not a string");
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(Fmt()
+			<< "request: GET"
+			<< ", command: " << command
+			<< ", resource: " << url_
+			)
+	}
+
 	picojson::value Delete(const std::string& command = std::string()) const {
 		return Download(command, &IHttpClient::Delete, "DELETE");
 	}
@@ -79,6 +157,28 @@ public:
 		return Upload(command, upload_data, &IHttpClient::Post, "POST");
 	}
 
+	// Sends a JSON body of the given size taken from the source while
+	// it is being sent. Sent once, the source can't be read again.
+	picojson::value PostStreamed(
+		const std::string& command,
+		size_t size,
+		const HttpBodySource& source
+		) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		const CancellationScope cancellation(GetCancellationContext());
+		const std::string url = ConcatUrl(url_, command);
+		const IHttpClient& http_client = transport_->GetHttpClient();
+		return ProcessResponse(transport_->Send(false, size, [&]{
+			return http_client.PostStreamed(url, size, source);
+		}));
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(Fmt()
+			<< "request: POST"
+			<< ", command: " << command
+			<< ", resource: " << url_
+			<< ", data size: " << size
+			)
+	}
+
 	template<typename T>
 	void Post(
 		const std::string& command,
@@ -115,8 +215,13 @@ private:
 		const char* request_type
 		) const {
 		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
-		return ProcessResponse((http_client_->*member)(
-			ConcatUrl(url_, command)
+		const CancellationScope cancellation(GetCancellationContext());
+		const std::string url = ConcatUrl(url_, command);
+		const IHttpClient& http_client = transport_->GetHttpClient();
+		return ProcessResponse(transport_->Send(
+			IsSafeToRepeat(request_type, command),
+			0,
+			[&]{ return (http_client.*member)(url); }
 			));
 		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(Fmt()
 			<< "request: " << request_type
@@ -125,6 +230,15 @@ private:
 			)
 	}
 
+	CancellationContext GetCancellationContext() const {
+		CancellationContext result;
+		if (released_)
+			return result;
+		for (const Resource* resource = this; resource; resource = resource->parent_.Get())
+			result.Add(resource->GetCancellationToken());
+		return result;
+	}
+
 	static std::string ToUploadData(const picojson::value& upload_data)
 	{
 		return upload_data.is<picojson::null>() ?
@@ -138,9 +252,14 @@ private:
 		const char* request_type
 		) const {
 		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
-		return ProcessResponse((http_client_->*member)(
-			ConcatUrl(url_, command),
-			ToUploadData(upload_data)
+		const CancellationScope cancellation(GetCancellationContext());
+		const std::string url = ConcatUrl(url_, command);
+		const std::string data = ToUploadData(upload_data);
+		const IHttpClient& http_client = transport_->GetHttpClient();
+		return ProcessResponse(transport_->Send(
+			IsSafeToRepeat(request_type, command),
+			data.size(),
+			[&]{ return (http_client.*member)(url, data); }
 			));
 		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(Fmt()
 			<< "request: " << request_type
@@ -179,14 +298,16 @@ private:
 			WEBDRIVERXX_CHECK(value.is<picojson::object>(), "Server returned HTTP code 500 and \"response.value\" is not an object");
 			WEBDRIVERXX_CHECK(value.contains("message"), "Server response has no member \"value.message\"");
 			WEBDRIVERXX_CHECK(value.get("message").is<std::string>(), "\"value.message\" is not a string");
-			WEBDRIVERXX_THROW(Fmt() << "Server failed to execute command ("
+			WEBDRIVERXX_THROW_STATUS(Fmt() << "Server failed to execute command ("
 				<< "message: " << value.get("message").to_str()
 				<< ", status: " << response_status_code::ToString(status)
 				<< ", status_code: " << status
-				<< ")"
+				<< ")",
+				status
 				);
 		}
-		WEBDRIVERXX_CHECK(status == response_status_code::kSuccess, "Non-zero response status code");
+		if (status != response_status_code::kSuccess)
+			WEBDRIVERXX_THROW_STATUS("Non-zero response status code", status);
 		WEBDRIVERXX_CHECK(http_response.http_code == 200, "Unsupported HTTP code");
 
 		return TransformResponse(response);
@@ -208,10 +329,13 @@ private:
 	}
 
 private:
-	const Shared<IHttpClient> http_client_;
+	const Shared<Transport> transport_;
 	const Shared<Resource> parent_;
 	const std::string url_;
 	const Ownership ownership_;
+	mutable std::mutex mutex_;
+	CancellationToken cancellation_token_;
+	bool released_;
 };
 
 class RootResource : public Resource { // noncopyable
@@ -2,6 +2,7 @@
 #define WEBDRIVERXX_DETAIL_SHARED_H
 
 #include <algorithm>
+#include <atomic>
 
 namespace webdriverxx {
 namespace detail {
@@ -25,10 +26,10 @@ private:
 	SharedObjectBase& operator = (SharedObjectBase&);
 
 private:
-	unsigned ref_;
+	std::atomic<unsigned> ref_;
 };
 
-// Copyable, not thread safe
+// Copyable. Reference counting is thread safe, the pointee is not.
 template<typename T>
 class Shared {
 public:
@@ -0,0 +1,212 @@
+#ifndef WEBDRIVERXX_DETAIL_TASK_H
+#define WEBDRIVERXX_DETAIL_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace webdriverxx {
+
+template<typename T>
+class Task;
+
+namespace detail {
+
+// Either a value or an exception.
+template<typename T>
+class Outcome {
+public:
+	void SetValue(T value) {
+		value_.emplace(std::move(value));
+	}
+
+	void SetError(std::exception_ptr error) {
+		error_ = error;
+	}
+
+	T Get() {
+		if (error_)
+			std::rethrow_exception(error_);
+		return std::move(*value_);
+	}
+
+private:
+	std::optional<T> value_;
+	std::exception_ptr error_;
+};
+
+template<>
+class Outcome<void> {
+public:
+	void SetValue() {}
+
+	void SetError(std::exception_ptr error) {
+		error_ = error;
+	}
+
+	void Get() {
+		if (error_)
+			std::rethrow_exception(error_);
+	}
+
+private:
+	std::exception_ptr error_;
+};
+
+template<typename T, typename Function>
+void CallAndStore(Outcome<T>& outcome, Function& function) {
+	try {
+		if constexpr (std::is_void_v<T>) {
+			function();
+			outcome.SetValue();
+		} else {
+			outcome.SetValue(function());
+		}
+	} catch (...) {
+		outcome.SetError(std::current_exception());
+	}
+}
+
+// Resumes whoever awaits the finished task.
+struct FinalAwaiter {
+	bool await_ready() const noexcept { return false; }
+
+	template<typename Promise>
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+		const auto continuation = handle.promise().continuation;
+		return continuation ? continuation : std::noop_coroutine();
+	}
+
+	void await_resume() const noexcept {}
+};
+
+template<typename T>
+struct TaskPromiseBase {
+	Outcome<T> outcome;
+	std::coroutine_handle<> continuation;
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+
+	void unhandled_exception() {
+		outcome.SetError(std::current_exception());
+	}
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase<T> {
+	Task<T> get_return_object();
+
+	void return_value(T value) {
+		this->outcome.SetValue(std::move(value));
+	}
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase<void> {
+	Task<void> get_return_object();
+
+	void return_void() {
+		this->outcome.SetValue();
+	}
+};
+
+// Fire-and-forget coroutine, destroys itself when finished.
+struct Detached {
+	struct promise_type {
+		Detached get_return_object() const noexcept { return {}; }
+		std::suspend_never initial_suspend() const noexcept { return {}; }
+		std::suspend_never final_suspend() const noexcept { return {}; }
+		void return_void() const noexcept {}
+		void unhandled_exception() const noexcept { std::terminate(); }
+	};
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T. Starts when awaited.
+template<typename T = void>
+class Task { // movable
+public:
+	typedef detail::TaskPromise<T> promise_type;
+
+	Task(Task&& other) noexcept
+		: handle_(std::exchange(other.handle_, nullptr))
+	{}
+
+	Task& operator = (Task&& other) noexcept {
+		if (this != &other) {
+			if (handle_)
+				handle_.destroy();
+			handle_ = std::exchange(other.handle_, nullptr);
+		}
+		return *this;
+	}
+
+	~Task() {
+		if (handle_)
+			handle_.destroy();
+	}
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+		handle_.promise().continuation = continuation;
+		return handle_;
+	}
+
+	T await_resume() {
+		return handle_.promise().outcome.Get();
+	}
+
+private:
+	friend struct detail::TaskPromise<T>;
+
+	explicit Task(std::coroutine_handle<promise_type> handle)
+		: handle_(handle)
+	{}
+
+	Task(const Task&) = delete;
+	Task& operator = (const Task&) = delete;
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+	return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline
+Task<void> TaskPromise<void>::get_return_object() {
+	return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+template<typename T, typename Start>
+Detached RunDetached(Start start, Task<T> task, std::shared_ptr<std::promise<T>> result) {
+	co_await start;
+	try {
+		if constexpr (std::is_void_v<T>) {
+			co_await task;
+			result->set_value();
+		} else {
+			result->set_value(co_await task);
+		}
+	} catch (...) {
+		result->set_exception(std::current_exception());
+	}
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef WEBDRIVERXX_DETAIL_TEMPLATE_MATCH_H
+#define WEBDRIVERXX_DETAIL_TEMPLATE_MATCH_H
+
+#include "error_handling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+// Loops over pixels are kept simple and branch free, with the innermost
+// loop going along a row of contiguous floats, so that compilers turn
+// them into SIMD code for whatever instruction set the build targets.
+
+struct GrayImage { // copyable
+	int width;
+	int height;
+	std::vector<float> pixels;
+
+	GrayImage() : width(0), height(0) {}
+	GrayImage(int width, int height)
+		: width(width)
+		, height(height)
+		, pixels(static_cast<size_t>(width) * height)
+	{}
+
+	const float* GetRow(int y) const {
+		return pixels.data() + static_cast<size_t>(y) * width;
+	}
+};
+
+inline
+GrayImage ToGray(const unsigned char* rgba, int width, int height) {
+	GrayImage result(width, height);
+	const size_t size = result.pixels.size();
+	float* out = result.pixels.data();
+	for (size_t i = 0; i < size; ++i)
+		out[i] = 0.299f * rgba[i * 4] + 0.587f * rgba[i * 4 + 1] + 0.114f * rgba[i * 4 + 2];
+	return result;
+}
+
+// Halves both sides, averaging 2x2 blocks. An odd last row or column is dropped.
+inline
+GrayImage Downsample(const GrayImage& image) {
+	GrayImage result(image.width / 2, image.height / 2);
+	for (int y = 0; y < result.height; ++y) {
+		const float* top = image.GetRow(y * 2);
+		const float* bottom = image.GetRow(y * 2 + 1);
+		float* out = result.pixels.data() + static_cast<size_t>(y) * result.width;
+		for (int x = 0; x < result.width; ++x)
+			out[x] = 0.25f * (top[x * 2] + top[x * 2 + 1] + bottom[x * 2] + bottom[x * 2 + 1]);
+	}
+	return result;
+}
+
+// Sums and sums of squares of any rectangle in constant time.
+class IntegralImage { // copyable
+public:
+	explicit IntegralImage(const GrayImage& image)
+		: stride_(static_cast<size_t>(image.width) + 1)
+		, sums_(stride_ * (image.height + 1))
+		, squares_(sums_.size())
+	{
+		for (int y = 0; y < image.height; ++y) {
+			const float* row = image.GetRow(y);
+			double sum = 0, square = 0;
+			for (int x = 0; x < image.width; ++x) {
+				sum += row[x];
+				square += static_cast<double>(row[x]) * row[x];
+				const size_t i = (y + 1) * stride_ + x + 1;
+				sums_[i] = sums_[i - stride_] + sum;
+				squares_[i] = squares_[i - stride_] + square;
+			}
+		}
+	}
+
+	double GetSum(int x, int y, int width, int height) const {
+		return Get(sums_, x, y, width, height);
+	}
+
+	double GetSquareSum(int x, int y, int width, int height) const {
+		return Get(squares_, x, y, width, height);
+	}
+
+private:
+	double Get(const std::vector<double>& table, int x, int y, int width, int height) const {
+		const size_t top = y * stride_ + x;
+		const size_t bottom = (y + height) * stride_ + x;
+		return table[bottom + width] - table[bottom] - table[top + width] + table[top];
+	}
+
+private:
+	size_t stride_;
+	std::vector<double> sums_;
+	std::vector<double> squares_;
+};
+
+// A level of the pyramid: the screen, the pattern with its mean subtracted,
+// and what the normalized cross-correlation needs besides their product.
+struct MatchLevel { // copyable
+	GrayImage screen;
+	IntegralImage integral;
+	GrayImage pattern;
+	double pattern_norm; // Square root of the sum of squares of the pattern
+
+	MatchLevel(GrayImage source_screen, GrayImage source_pattern)
+		: integral(source_screen)
+		, pattern_norm(0)
+	{
+		screen.width = source_screen.width;
+		screen.height = source_screen.height;
+		screen.pixels.swap(source_screen.pixels);
+		pattern.width = source_pattern.width;
+		pattern.height = source_pattern.height;
+		pattern.pixels.swap(source_pattern.pixels);
+		double sum = 0;
+		for (const float value : pattern.pixels)
+			sum += value;
+		const float mean = static_cast<float>(sum / pattern.pixels.size());
+		double square = 0;
+		for (float& value : pattern.pixels) {
+			value -= mean;
+			square += static_cast<double>(value) * value;
+		}
+		pattern_norm = std::sqrt(square);
+	}
+
+	int GetMaxX() const { return screen.width - pattern.width; }
+	int GetMaxY() const { return screen.height - pattern.height; }
+
+	// Turns the product of the zero mean pattern and the screen at (x, y)
+	// into the correlation coefficient, from -1 to 1. Flat areas of the
+	// screen have no correlation with anything.
+	double Normalize(double product, int x, int y) const {
+		const double n = static_cast<double>(pattern.pixels.size());
+		const double sum = integral.GetSum(x, y, pattern.width, pattern.height);
+		const double variance = integral.GetSquareSum(x, y, pattern.width, pattern.height) - sum * sum / n;
+		if (variance <= n * 1e-2)
+			return 0;
+		return product / (pattern_norm * std::sqrt(variance));
+	}
+
+	double GetScore(int x, int y) const {
+		double product = 0;
+		for (int row = 0; row < pattern.height; ++row) {
+			const float* s = screen.GetRow(y + row) + x;
+			const float* p = pattern.GetRow(row);
+			float sum = 0;
+			for (int i = 0; i < pattern.width; ++i)
+				sum += s[i] * p[i];
+			product += sum;
+		}
+		return Normalize(product, x, y);
+	}
+
+	// Scores of all positions, row by row. The products are accumulated for
+	// a whole row of positions at once, one pattern pixel at a time, which
+	// is a multiply-add over contiguous floats.
+	std::vector<float> GetScoreMap() const {
+		const int columns = GetMaxX() + 1;
+		std::vector<float> result(static_cast<size_t>(columns) * (GetMaxY() + 1));
+		std::vector<float> products(columns);
+		for (int y = 0; y <= GetMaxY(); ++y) {
+			std::fill(products.begin(), products.end(), 0.0f);
+			float* out = products.data();
+			for (int row = 0; row < pattern.height; ++row) {
+				const float* s = screen.GetRow(y + row);
+				const float* p = pattern.GetRow(row);
+				for (int i = 0; i < pattern.width; ++i) {
+					const float weight = p[i];
+					const float* in = s + i;
+					for (int x = 0; x < columns; ++x)
+						out[x] += weight * in[x];
+				}
+			}
+			for (int x = 0; x < columns; ++x)
+				result[static_cast<size_t>(y) * columns + x] = static_cast<float>(Normalize(products[x], x, y));
+		}
+		return result;
+	}
+};
+
+struct TemplateMatch { // copyable
+	int x; // Top left corner
+	int y;
+	double score;
+
+	TemplateMatch(int x, int y, double score) : x(x), y(y), score(score) {}
+};
+
+// Finds up to max_matches places where the pattern correlates with the
+// screen at least as much as the threshold, best first. Matches overlapping
+// a better one by more than half of the pattern are dropped.
+//
+// The screen and the pattern are halved up to max_levels times, while the
+// pattern stays at least min_pattern_size pixels on each side. The smallest
+// level is searched fully, the best local maxima there are followed down
+// the pyramid and only searched around at every larger level.
+inline
+std::vector<TemplateMatch> MatchTemplate(
+	const GrayImage& screen,
+	const GrayImage& pattern,
+	double threshold,
+	size_t max_matches,
+	int max_levels,
+	int min_pattern_size = 8
+	) {
+	WEBDRIVERXX_CHECK(pattern.width > 0 && pattern.height > 0, "Pattern is empty");
+	std::vector<TemplateMatch> result;
+	if (pattern.width > screen.width || pattern.height > screen.height || !max_matches)
+		return result;
+	std::vector<MatchLevel> levels;
+	levels.push_back(MatchLevel(screen, pattern));
+	WEBDRIVERXX_CHECK(levels[0].pattern_norm > 1e-3, "Pattern has no contrast");
+	while (static_cast<int>(levels.size()) <= max_levels
+		&& levels.back().pattern.width / 2 >= min_pattern_size
+		&& levels.back().pattern.height / 2 >= min_pattern_size) {
+		levels.push_back(MatchLevel(Downsample(levels.back().screen), Downsample(levels.back().pattern)));
+		if (levels.back().pattern_norm <= 1e-3) {
+			levels.pop_back();
+			break;
+		}
+	}
+
+	// Local maxima of the smallest level. Below the full size, scores of
+	// the right place drop with detail lost to averaging and with the match
+	// being between the pixels of the level, hence the wider margin.
+	const MatchLevel& top = levels.back();
+	const int columns = top.GetMaxX() + 1;
+	const int rows = top.GetMaxY() + 1;
+	const std::vector<float> scores = top.GetScoreMap();
+	const double margin = levels.size() > 1 ? 0.5 : 0;
+	std::vector<TemplateMatch> candidates;
+	for (int y = 0; y < rows; ++y) {
+		for (int x = 0; x < columns; ++x) {
+			const float score = scores[static_cast<size_t>(y) * columns + x];
+			if (score < threshold - margin)
+				continue;
+			bool is_maximum = true;
+			for (int dy = -1; dy <= 1 && is_maximum; ++dy)
+				for (int dx = -1; dx <= 1 && is_maximum; ++dx)
+					if (y + dy >= 0 && y + dy < rows && x + dx >= 0 && x + dx < columns
+						&& scores[static_cast<size_t>(y + dy) * columns + x + dx] > score)
+						is_maximum = false;
+			if (is_maximum)
+				candidates.push_back(TemplateMatch(x, y, score));
+		}
+	}
+	const auto is_better = [](const TemplateMatch& a, const TemplateMatch& b) {
+		return a.score > b.score || (a.score == b.score && (a.y < b.y || (a.y == b.y && a.x < b.x)));
+	};
+	std::sort(candidates.begin(), candidates.end(), is_better);
+	// Saturates, callers pass the largest size_t for "all matches"
+	const size_t kept = max_matches > (std::numeric_limits<size_t>::max() - 16) / 8
+		? std::numeric_limits<size_t>::max() : 16 + 8 * max_matches;
+	if (levels.size() > 1 && candidates.size() > kept)
+		candidates.erase(candidates.begin() + kept, candidates.end());
+
+	// Twice the position at the smaller level is within a pixel of the
+	// best one, plus a pixel for the error of the smaller level itself.
+	for (size_t level = levels.size() - 1; level-- > 0;) {
+		const MatchLevel& current = levels[level];
+		for (TemplateMatch& candidate : candidates) {
+			const int center_x = candidate.x * 2;
+			const int center_y = candidate.y * 2;
+			candidate.score = -2;
+			for (int y = std::max(0, center_y - 2); y <= std::min(current.GetMaxY(), center_y + 2); ++y)
+				for (int x = std::max(0, center_x - 2); x <= std::min(current.GetMaxX(), center_x + 2); ++x) {
+					const double score = current.GetScore(x, y);
+					if (score > candidate.score)
+						candidate = TemplateMatch(x, y, score);
+				}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), is_better);
+
+	for (const TemplateMatch& candidate : candidates) {
+		if (result.size() == max_matches || candidate.score < threshold)
+			break;
+		bool overlaps = false;
+		for (const TemplateMatch& match : result)
+			if (std::abs(match.x - candidate.x) * 2 < pattern.width
+				&& std::abs(match.y - candidate.y) * 2 < pattern.height)
+				overlaps = true;
+		if (!overlaps)
+			result.push_back(candidate);
+	}
+	return result;
+}
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef WEBDRIVERXX_DETAIL_THREAD_POOL_H
+#define WEBDRIVERXX_DETAIL_THREAD_POOL_H
+
+#include "error_handling.h"
+#include "shared.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+// Fixed number of worker threads serving a FIFO queue of tasks.
+// Tasks that are queued before destruction are still executed.
+class ThreadPool : public SharedObjectBase { // noncopyable
+public:
+	explicit ThreadPool(size_t size)
+		: state_(std::make_shared<State>())
+	{
+		WEBDRIVERXX_CHECK(size > 0, "Thread pool should have at least one thread");
+		try {
+			threads_.reserve(size);
+			for (size_t i = 0; i < size; ++i)
+				threads_.push_back(std::thread(&ThreadPool::Run, state_));
+		} catch (...) {
+			Stop();
+			throw;
+		}
+	}
+
+	~ThreadPool() {
+		Stop();
+	}
+
+	size_t GetSize() const {
+		return threads_.size();
+	}
+
+	void Post(const std::function<void()>& task) {
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			state_->tasks.push_back(task);
+		}
+		state_->condition.notify_one();
+	}
+
+	template<typename Function>
+	auto Async(Function function) -> std::future<decltype(function())> {
+		typedef decltype(function()) Result;
+		const auto task = std::make_shared<std::packaged_task<Result()>>(function);
+		Post([task]{ (*task)(); });
+		return task->get_future();
+	}
+
+private:
+	// Owned by workers too, so the pool can be released from its own task.
+	struct State {
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<std::function<void()>> tasks;
+		bool stopping;
+
+		State() : stopping(false) {}
+	};
+
+	static
+	void Run(std::shared_ptr<State> state) {
+		for (;;) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(state->mutex);
+				state->condition.wait(lock, [&state]{
+					return state->stopping || !state->tasks.empty();
+				});
+				if (state->tasks.empty())
+					return;
+				task.swap(state->tasks.front());
+				state->tasks.pop_front();
+			}
+			try {
+				task();
+			} catch (const std::exception&) {} // Use Async to get errors
+		}
+	}
+
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			state_->stopping = true;
+		}
+		state_->condition.notify_all();
+		for (auto& thread : threads_) {
+			if (thread.get_id() == std::this_thread::get_id())
+				thread.detach();
+			else
+				thread.join();
+		}
+	}
+
+private:
+	const std::shared_ptr<State> state_;
+	std::vector<std::thread> threads_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
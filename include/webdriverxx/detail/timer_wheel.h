@@ -0,0 +1,181 @@
+#ifndef WEBDRIVERXX_DETAIL_TIMER_WHEEL_H
+#define WEBDRIVERXX_DETAIL_TIMER_WHEEL_H
+
+#include "error_handling.h"
+#include "shared.h"
+#include "../types.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+const Duration kDefaultTimerTickMs = 5;
+const size_t kDefaultTimerSlots = 1024;
+
+// Hashed timer wheel: calls functions after a delay from a single
+// background thread. Scheduling and cancelling are O(1), a timer fires
+// within one tick after its delay. Callbacks should be short, they delay
+// each other. The thread sleeps while there are no timers.
+class TimerWheel : public SharedObjectBase { // noncopyable
+public:
+	typedef std::chrono::steady_clock Clock;
+	typedef unsigned long long TimerId; // Never 0
+
+	explicit TimerWheel(
+		Duration tick_ms = kDefaultTimerTickMs,
+		size_t slots = kDefaultTimerSlots
+		)
+		: state_(std::make_shared<State>(tick_ms, slots))
+		, thread_(&TimerWheel::Run, state_)
+	{}
+
+	~TimerWheel() {
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			state_->stopping = true;
+		}
+		state_->condition.notify_all();
+		if (thread_.get_id() == std::this_thread::get_id())
+			thread_.detach();
+		else
+			thread_.join();
+	}
+
+	// Zero delay means "as soon as possible", without waiting for a tick.
+	TimerId Schedule(Duration delay_ms, const std::function<void()>& callback) {
+		State& state = *state_;
+		std::lock_guard<std::mutex> lock(state.mutex);
+		const TimerId id = ++state.last_id;
+		bool wake_up = false;
+		if (state.timers.empty()) {
+			// Idle wheel doesn't tick, start counting from now
+			state.next_tick = Clock::now() + state.tick;
+			wake_up = true;
+		}
+		// One extra tick because the current one is partially elapsed
+		const size_t ticks = delay_ms > 0
+			? static_cast<size_t>(delay_ms / state.tick_ms) + 1 : 0;
+		Timers& timers = ticks == 0 ? state.due
+			: state.slots[(state.cursor + ticks) % state.slots.size()];
+		const Timer timer = { id, ticks == 0 ? 0 : (ticks - 1) / state.slots.size(), callback };
+		timers.push_back(timer);
+		state.timers[id] = std::make_pair(&timers, std::prev(timers.end()));
+		// Notified under the lock: once the callback runs, its owner
+		// may release the wheel before this function returns.
+		if (wake_up || ticks == 0)
+			state.condition.notify_all();
+		return id;
+	}
+
+	// Returns false if the timer has already fired or is firing now.
+	bool Cancel(TimerId id) {
+		std::function<void()> callback; // Release captured state without the lock
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		const auto it = state_->timers.find(id);
+		if (it == state_->timers.end())
+			return false;
+		callback.swap(it->second.second->callback);
+		it->second.first->erase(it->second.second);
+		state_->timers.erase(it);
+		return true;
+	}
+
+	size_t GetPendingCount() const {
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		return state_->timers.size();
+	}
+
+private:
+	struct Timer {
+		TimerId id;
+		size_t rounds; // Full turns of the wheel left
+		std::function<void()> callback;
+	};
+
+	typedef std::list<Timer> Timers;
+
+	// Owned by the thread too, so the wheel can be released from its own callback.
+	struct State {
+		std::mutex mutex;
+		std::condition_variable condition;
+		const Duration tick_ms;
+		const Clock::duration tick;
+		std::vector<Timers> slots;
+		Timers due;
+		std::unordered_map<TimerId, std::pair<Timers*, Timers::iterator>> timers;
+		size_t cursor;
+		Clock::time_point next_tick;
+		TimerId last_id;
+		bool stopping;
+
+		State(Duration tick_ms, size_t slots)
+			: tick_ms(tick_ms)
+			, tick(std::chrono::milliseconds(tick_ms))
+			, slots(slots)
+			, cursor(0)
+			, last_id(0)
+			, stopping(false)
+		{
+			WEBDRIVERXX_CHECK(tick_ms > 0, "Timer tick should be positive");
+			WEBDRIVERXX_CHECK(slots > 0, "Timer wheel should have at least one slot");
+		}
+	};
+
+	static
+	void Run(std::shared_ptr<State> state) {
+		std::unique_lock<std::mutex> lock(state->mutex);
+		while (!state->stopping) {
+			Timers expired;
+			expired.swap(state->due);
+			if (expired.empty()) {
+				if (state->timers.empty()) {
+					state->condition.wait(lock);
+					continue;
+				}
+				if (Clock::now() < state->next_tick) {
+					state->condition.wait_until(lock, state->next_tick);
+					continue;
+				}
+				state->next_tick += state->tick;
+				state->cursor = (state->cursor + 1) % state->slots.size();
+				Timers& slot = state->slots[state->cursor];
+				for (auto it = slot.begin(); it != slot.end();) {
+					const auto next = std::next(it);
+					if (it->rounds == 0)
+						expired.splice(expired.end(), slot, it);
+					else
+						--it->rounds;
+					it = next;
+				}
+			}
+			for (const auto& timer : expired)
+				state->timers.erase(timer.id);
+			lock.unlock();
+			for (auto& timer : expired) {
+				try {
+					timer.callback();
+				} catch (const std::exception&) {}
+			}
+			expired.clear(); // Release captured state without the lock
+			lock.lock();
+		}
+	}
+
+private:
+	const std::shared_ptr<State> state_;
+	std::thread thread_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
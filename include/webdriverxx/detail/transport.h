@@ -0,0 +1,103 @@
+#ifndef WEBDRIVERXX_DETAIL_TRANSPORT_H
+#define WEBDRIVERXX_DETAIL_TRANSPORT_H
+
+#include "http_client.h"
+#include "shared.h"
+#include "time.h"
+#include "../cancellation.h"
+#include "../metrics.h"
+#include "../retry.h"
+#include "../session_reaper.h"
+#include <exception>
+#include <mutex>
+
+namespace webdriverxx {
+namespace detail {
+
+inline
+bool IsTransientFailure(const HttpResponse& response) {
+	return response.http_code == 502 // Bad gateway, e.g. a grid node is gone
+		|| response.http_code == 503 // Service unavailable
+		|| response.http_code == 504; // Gateway timeout
+}
+
+// HTTP client, retry policy, metrics and session reaper shared
+// by a Client and all its resources.
+class Transport : public SharedObjectBase { // noncopyable
+public:
+	explicit Transport(const Shared<IHttpClient>& http_client)
+		: http_client_(http_client)
+		, metrics_(new MetricsCounters)
+	{}
+
+	const IHttpClient& GetHttpClient() const {
+		return *http_client_;
+	}
+
+	const Shared<IHttpClient>& GetSharedHttpClient() const {
+		return http_client_;
+	}
+
+	const Shared<MetricsCounters>& GetMetrics() const {
+		return metrics_;
+	}
+
+	void SetRetryPolicy(const RetryPolicy& policy) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		retry_policy_ = policy;
+	}
+
+	RetryPolicy GetRetryPolicy() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return retry_policy_;
+	}
+
+	void SetSessionReaper(const Shared<SessionReaper>& reaper) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		session_reaper_ = reaper;
+	}
+
+	Shared<SessionReaper> GetSessionReaper() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return session_reaper_;
+	}
+
+	// Calls request() until it succeeds or attempts are exhausted.
+	// Requests that are not safe to repeat are sent once.
+	template<typename Request>
+	HttpResponse Send(bool safe_to_repeat, size_t upload_size, Request request) const {
+		const RetryPolicy policy = GetRetryPolicy();
+		const unsigned max_attempts = safe_to_repeat ? policy.max_attempts : 1;
+		Duration backoff_ms = policy.backoff_ms;
+		for (unsigned attempt = 1;; ++attempt) {
+			++metrics_->requests;
+			try {
+				HttpResponse response = request();
+				metrics_->bytes_sent += upload_size;
+				metrics_->bytes_sent_on_wire += response.bytes_sent_on_wire;
+				metrics_->bytes_received += response.body.size() + response.bytes_streamed;
+				metrics_->bytes_received_on_wire += response.bytes_received_on_wire;
+				if (attempt >= max_attempts || !IsTransientFailure(response))
+					return response;
+			} catch (const std::exception&) {
+				if (attempt >= max_attempts || CancellationContext::Capture().IsCancelled())
+					throw;
+			}
+			++metrics_->retries;
+			Sleep(LimitToDeadline(backoff_ms, CancellationContext::Capture().GetDeadline()));
+			backoff_ms = backoff_ms < policy.max_backoff_ms / 2 ? backoff_ms * 2 : policy.max_backoff_ms;
+		}
+	}
+
+private:
+	const Shared<IHttpClient> http_client_;
+	const Shared<MetricsCounters> metrics_;
+	mutable std::mutex mutex_;
+	RetryPolicy retry_policy_;
+	Shared<SessionReaper> session_reaper_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
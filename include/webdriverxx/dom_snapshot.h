@@ -0,0 +1,226 @@
+#ifndef WEBDRIVERXX_DOM_SNAPSHOT_H
+#define WEBDRIVERXX_DOM_SNAPSHOT_H
+
+#include "session.h"
+#include "element.h"
+#include "by.h"
+#include "conversions.h"
+#include "detail/dom_query.h"
+#include "detail/error_handling.h"
+#include "detail/shared.h"
+#include <picojson.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+// Makes a live element of the snapshot element with the ordinal and tag name.
+typedef std::function<Element(size_t ordinal, const std::string& tag)> DomElementPromoter;
+
+struct DomSnapshotData : SharedObjectBase { // noncopyable
+	DomTree tree;
+	DomElementPromoter promote;
+};
+
+// Returns the document as [parent, tag, [name, value, ...], visible]
+// elements and [parent, text] text nodes in document order, where parent
+// is the index of the parent element or -1 and visible is 0 for hidden,
+// 1 for inline and 2 for other elements. Form controls report their
+// current value as the value attribute. Elements are in the same order
+// as in document.getElementsByTagName('*').
+const char *const kCaptureDomScript =
+	"function visible(e) {"
+		"if (!(e.offsetWidth || e.offsetHeight || e.getClientRects().length)) return 0;"
+		"var s = window.getComputedStyle(e);"
+		"if (s.visibility === 'hidden' || s.visibility === 'collapse') return 0;"
+		"return /^(inline|contents)/.test(s.display) ? 1 : 2;"
+	"}"
+	"var result = [], stack = document.documentElement ? [[document.documentElement, -1]] : [];"
+	"while (stack.length) {"
+		"var item = stack.pop(), node = item[0];"
+		"if (node.nodeType === 3) {"
+			"result.push([item[1], node.nodeValue]);"
+			"continue;"
+		"}"
+		"var index = result.length, attributes = [];"
+		"var live = /^(input|textarea|select)$/i.test(node.tagName) && typeof node.value === 'string';"
+		"if (live) attributes.push('value', node.value);"
+		"for (var i = 0; i < node.attributes.length; ++i) {"
+			"var a = node.attributes[i];"
+			"if (!live || a.name !== 'value') attributes.push(a.name, a.value);"
+		"}"
+		"result.push([item[1], node.tagName.toLowerCase(), attributes, visible(node)]);"
+		"for (var child = node.lastChild; child; child = child.previousSibling)"
+			"if (child.nodeType === 1 || child.nodeType === 3) stack.push([child, index]);"
+	"}"
+	"return result;"
+	;
+
+// Takes the ordinal and the tag name of an element from the snapshot,
+// returns null if the document has changed since.
+const char *const kPromoteDomElementScript =
+	"var e = document.getElementsByTagName('*')[arguments[0]];"
+	"return e && e.tagName.toLowerCase() === arguments[1] ? e : null;"
+	;
+
+inline
+DomTree DomTreeFromJson(const picojson::value& nodes) {
+	WEBDRIVERXX_CHECK(nodes.is<picojson::array>(), "DOM snapshot is not an array");
+	DomTree result;
+	result.nodes.reserve(nodes.get<picojson::array>().size());
+	for (const auto& item : nodes.get<picojson::array>()) {
+		WEBDRIVERXX_CHECK(item.is<picojson::array>(), "DOM node is not an array");
+		const picojson::array& fields = item.get<picojson::array>();
+		WEBDRIVERXX_CHECK(fields.size() == 2 || fields.size() == 4, "DOM node has wrong number of fields");
+		DomNode node;
+		const int parent = FromJson<int>(fields[0]);
+		WEBDRIVERXX_CHECK(parent < static_cast<int>(result.nodes.size()), "DOM node goes before its parent");
+		node.parent = parent < 0 ? kNoDomNode : static_cast<size_t>(parent);
+		node.name = FromJson<std::string>(fields[1]);
+		if (fields.size() == 2) {
+			WEBDRIVERXX_CHECK(node.parent != kNoDomNode, "Text node has no parent");
+			node.is_text = true;
+		} else {
+			const std::vector<std::string> attributes = FromJson<std::vector<std::string>>(fields[2]);
+			for (size_t i = 0; i + 1 < attributes.size(); i += 2)
+				node.attributes.push_back(std::make_pair(ToLowerAscii(attributes[i]), attributes[i + 1]));
+			const int visible = FromJson<int>(fields[3]);
+			node.visible = visible != 0;
+			node.block = visible == 2;
+		}
+		result.nodes.push_back(node);
+	}
+	result.Link();
+	return result;
+}
+
+} // namespace detail
+
+// An element of a DomSnapshot. Reads come from the snapshot and
+// cost no commands, ToElement makes a live element with one command.
+class DomElement { // copyable
+public:
+	DomElement(const detail::Shared<detail::DomSnapshotData>& data, size_t node)
+		: data_(data)
+		, node_(node)
+	{}
+
+	std::string GetTagName() const {
+		return GetNode().name;
+	}
+
+	// Text of visible text nodes inside the element with collapsed
+	// whitespace, blocks and br elements start new lines. Close to
+	// Element::GetText, which also handles tables, pre and CSS text
+	// transforms.
+	std::string GetText() const {
+		return data_->tree.GetText(node_);
+	}
+
+	// Empty if there is no attribute. Inputs, textareas and selects
+	// report the value they had when the snapshot was made.
+	std::string GetAttribute(const std::string& name) const {
+		const std::string* value = data_->tree.FindAttribute(node_, detail::ToLowerAscii(name));
+		return value ? *value : std::string();
+	}
+
+	bool HasAttribute(const std::string& name) const {
+		return data_->tree.FindAttribute(node_, detail::ToLowerAscii(name)) != nullptr;
+	}
+
+	bool IsDisplayed() const {
+		return GetNode().visible;
+	}
+
+	DomElement FindElement(const By& by) const {
+		return Find(data_, node_, by);
+	}
+
+	std::vector<DomElement> FindElements(const By& by) const {
+		return FindAll(data_, node_, by);
+	}
+
+	// Finds the element in the page by its position in the document, so
+	// the current frame should be the one the snapshot was made in. Throws
+	// if the page no longer has such an element there.
+	Element ToElement() const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		return data_->promote(GetNode().ordinal, GetNode().name);
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "tag: " << GetNode().name
+			<< ", ordinal: " << GetNode().ordinal
+			)
+	}
+
+private:
+	friend class DomSnapshot;
+
+	const detail::DomNode& GetNode() const {
+		return data_->tree.nodes[node_];
+	}
+
+	static
+	std::vector<DomElement> FindAll(const detail::Shared<detail::DomSnapshotData>& data,
+		size_t context, const By& by) {
+		std::vector<DomElement> result;
+		for (const size_t node : detail::QueryDom(data->tree, context, by))
+			result.push_back(DomElement(data, node));
+		return result;
+	}
+
+	static
+	DomElement Find(const detail::Shared<detail::DomSnapshotData>& data,
+		size_t context, const By& by) {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		const std::vector<size_t> nodes = detail::QueryDom(data->tree, context, by);
+		WEBDRIVERXX_CHECK(!nodes.empty(), "No element in the snapshot matches the locator");
+		return DomElement(data, nodes.front());
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "strategy: " << by.GetStrategy()
+			<< ", value: " << by.GetValue()
+			)
+	}
+
+private:
+	detail::Shared<detail::DomSnapshotData> data_;
+	size_t node_;
+};
+
+// The document of the current frame as it was when Session::CaptureDom was
+// called. Queries with any locator run locally: id, name, class name, tag
+// name, link text and partial link text fully, CSS selectors and XPath
+// expressions in the subsets described in detail/dom_query.h. Unsupported
+// selectors throw instead of matching differently than the browser would.
+class DomSnapshot { // copyable
+public:
+	DomSnapshot(detail::DomTree tree, const detail::DomElementPromoter& promote)
+		: data_(new detail::DomSnapshotData)
+	{
+		data_->tree.nodes.swap(tree.nodes);
+		data_->promote = promote;
+	}
+
+	DomElement FindElement(const By& by) const {
+		return DomElement::Find(data_, detail::kNoDomNode, by);
+	}
+
+	std::vector<DomElement> FindElements(const By& by) const {
+		return DomElement::FindAll(data_, detail::kNoDomNode, by);
+	}
+
+	size_t GetNodeCount() const {
+		return data_->tree.nodes.size();
+	}
+
+private:
+	detail::Shared<detail::DomSnapshotData> data_;
+};
+
+} // namespace webdriverxx
+
+#include "dom_snapshot.inl"
+
+#endif
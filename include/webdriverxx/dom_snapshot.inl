@@ -0,0 +1,28 @@
+#include "conversions.h"
+#include "detail/error_handling.h"
+#include "detail/types.h"
+
+namespace webdriverxx {
+
+inline
+DomSnapshot Session::CaptureDom() const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	const Session session = *this;
+	return DomSnapshot(
+		detail::DomTreeFromJson(InternalEvalJsonValue("execute", detail::kCaptureDomScript, JsArgs())),
+		[session](size_t ordinal, const std::string& tag) {
+			return session.InternalPromoteDomElement(ordinal, tag);
+		});
+	WEBDRIVERXX_FUNCTION_CONTEXT_END()
+}
+
+inline
+Element Session::InternalPromoteDomElement(size_t ordinal, const std::string& tag) const {
+	const picojson::value element = InternalEvalJsonValue("execute",
+		detail::kPromoteDomElementScript,
+		JsArgs() << static_cast<int>(ordinal) << tag);
+	WEBDRIVERXX_CHECK(!element.is<picojson::null>(), "Document has changed since the snapshot");
+	return factory_->MakeElement(FromJson<detail::ElementRef>(element).ref);
+}
+
+} // namespace webdriverxx
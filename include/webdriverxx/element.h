@@ -4,10 +4,12 @@
 #include "by.h"
 #include "types.h"
 #include "keys.h"
+#include "form.h"
 #include "detail/shared.h"
 #include "detail/keyboard.h"
 #include "detail/resource.h"
 #include "detail/factories.h"
+#include "detail/focus_state.h"
 #include <string>
 #include <vector>
 
@@ -21,7 +23,8 @@ public:
 	Element(
 		const std::string& ref,
 		const detail::Shared<detail::Resource>& resource,
-		const detail::Shared<detail::IFinderFactory>& factory
+		const detail::Shared<detail::IFinderFactory>& factory,
+		const detail::Shared<detail::FocusState>& focus = detail::Shared<detail::FocusState>()
 		);
 
 	std::string GetRef() const; // Returns ID that is used by Webdriver to identify elements
@@ -39,6 +42,8 @@ public:
 
 	Element FindElement(const By& by) const;
 	std::vector<Element> FindElements(const By& by) const;
+	// Same as Session::FindAll, searches inside the element.
+	std::vector<std::vector<Element>> FindAll(const std::vector<By>& locators) const;
 
 	const Element& Clear() const;
 	const Element& Click() const;
@@ -46,6 +51,9 @@ public:
 
 	const Element& SendKeys(const std::string& keys) const;
 	const Element& SendKeys(const Shortcut& shortcut) const;
+	// Replaces the value with a text that takes a single SendKeys too long.
+	// See TextEntry.
+	const Element& EnterText(const std::string& text, const TextEntry& entry = TextEntry()) const;
 
 	bool Equals(const Element& other) const;
 	bool operator != (const Element& other) const;
@@ -53,13 +61,20 @@ public:
 	bool operator < (const Element& other) const;
 
 private:
+	// Runs the command on the element. An element handed out by the
+	// element cache that went stale is looked up again, and the command
+	// is repeated on the element found.
+	template<typename Command>
+	auto Run(const Command& command) const -> decltype(command(*this));
 	detail::Resource& GetResource() const;
 	detail::Keyboard GetKeyboard() const;
+	void ForgetFrameFocus() const; // The command may load another document
 
 private:
 	std::string ref_;
 	detail::Shared<detail::Resource> resource_;
 	detail::Shared<detail::IFinderFactory> factory_;
+	detail::Shared<detail::FocusState> focus_;
 };
 
 } // namespace webdriverxx
@@ -17,11 +17,13 @@ inline
 Element::Element(
 	const std::string& ref,
 	const detail::Shared<detail::Resource>& resource,
-	const detail::Shared<detail::IFinderFactory>& factory
+	const detail::Shared<detail::IFinderFactory>& factory,
+	const detail::Shared<detail::FocusState>& focus
 	)
 	: ref_(ref)
 	, resource_(resource)
 	, factory_(factory)
+	, focus_(focus)
 {}
 
 inline
@@ -31,96 +33,179 @@ std::string Element::GetRef() const {
 
 inline
 bool Element::IsDisplayed() const {
-	return GetResource().GetBool("displayed");
+	return Run([](const Element& element) {
+		return element.GetResource().GetBool("displayed");
+	});
 }
 
 inline
 bool Element::IsEnabled() const {
-	return GetResource().GetBool("enabled");
+	return Run([](const Element& element) {
+		return element.GetResource().GetBool("enabled");
+	});
 }
 
 inline
 bool Element::IsSelected() const {
-	return GetResource().GetBool("selected");
+	return Run([](const Element& element) {
+		return element.GetResource().GetBool("selected");
+	});
 }
 
 inline
 Point Element::GetLocation() const {
-	return GetResource().GetValue<Point>("location");
+	return Run([](const Element& element) {
+		return element.GetResource().GetValue<Point>("location");
+	});
 }
 
 inline
 Point Element::GetLocationInView() const {
-	return GetResource().GetValue<Point>("location_in_view");
+	return Run([](const Element& element) {
+		return element.GetResource().GetValue<Point>("location_in_view");
+	});
 }
 
 inline
 Size Element::GetSize() const {
-	return GetResource().GetValue<Size>("size");
+	return Run([](const Element& element) {
+		return element.GetResource().GetValue<Size>("size");
+	});
 }
 
 inline
 std::string Element::GetAttribute(const std::string& name) const {
-	return GetResource().GetString(std::string("attribute/") + name);
+	return Run([&name](const Element& element) {
+		return element.GetResource().GetString(std::string("attribute/") + name);
+	});
 }
 
 inline
 std::string Element::GetCssProperty(const std::string& name) const {
-	return GetResource().GetString(std::string("css/") + name);
+	return Run([&name](const Element& element) {
+		return element.GetResource().GetString(std::string("css/") + name);
+	});
 }
 
 inline
 std::string Element::GetTagName() const {
-	return GetResource().GetString("name");
+	return Run([](const Element& element) {
+		return element.GetResource().GetString("name");
+	});
 }
 inline
 std::string Element::GetText() const {
-	return GetResource().GetString("text");
+	return Run([](const Element& element) {
+		return element.GetResource().GetString("text");
+	});
 }
 
 inline
 Element Element::FindElement(const By& by) const {
-	return factory_->MakeFinder(&GetResource()).FindElement(by);
+	return Run([this, &by](const Element& element) {
+		return factory_->MakeFinder(&element.GetResource()).FindElement(by);
+	});
 }
 
 inline
 std::vector<Element> Element::FindElements(const By& by) const {
-	return factory_->MakeFinder(&GetResource()).FindElements(by);
+	return Run([this, &by](const Element& element) {
+		return factory_->MakeFinder(&element.GetResource()).FindElements(by);
+	});
+}
+
+inline
+std::vector<std::vector<Element>> Element::FindAll(const std::vector<By>& locators) const {
+	return Run([this, &locators](const Element& element) {
+		return factory_->MakeFinder(&element.GetResource()).FindAll(locators, &element);
+	});
 }
 
 inline
 const Element& Element::Clear() const {
-	GetResource().Post("clear");
+	ForgetFrameFocus();
+	Run([](const Element& element) {
+		element.GetResource().Post("clear");
+	});
 	return *this;
 }
 
 inline
 const Element& Element::Click() const {
-	GetResource().Post("click");
+	ForgetFrameFocus();
+	Run([](const Element& element) {
+		element.GetResource().Post("click");
+	});
 	return *this;
 }
 
 inline
 const Element& Element::Submit() const {
-	GetResource().Post("submit");
+	ForgetFrameFocus();
+	Run([](const Element& element) {
+		element.GetResource().Post("submit");
+	});
 	return *this;
 }
 
 inline
 const Element& Element::SendKeys(const std::string& keys) const {
-	GetKeyboard().SendKeys(keys);
+	ForgetFrameFocus();
+	Run([&keys](const Element& element) {
+		element.GetKeyboard().SendKeys(keys);
+	});
 	return *this;
 }
 
 inline
 const Element& Element::SendKeys(const Shortcut& shortcut) const {
-	GetKeyboard().SendKeys(shortcut);
+	ForgetFrameFocus();
+	Run([&shortcut](const Element& element) {
+		element.GetKeyboard().SendKeys(shortcut);
+	});
+	return *this;
+}
+
+inline
+const Element& Element::EnterText(const std::string& text, const TextEntry& entry) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	ForgetFrameFocus();
+	Run([&text, &entry](const Element& element) {
+		if (entry.method == TextEntry::SetValue) {
+			// Element resources are subresources of their session
+			const detail::Shared<detail::Resource>& session = element.GetResource().GetParent();
+			WEBDRIVERXX_CHECK(session, "Element has no session");
+			picojson::array args;
+			args.push_back(ToJson(element));
+			args.push_back(ToJson(std::vector<std::string>(1, text)));
+			const picojson::value statuses = session->Post("execute", JsonObject()
+				.Set("script", std::string("var found = [[arguments[0]]];") + detail::kFillFormScript)
+				.Set("args", picojson::value(args))
+				);
+			WEBDRIVERXX_CHECK(statuses.is<picojson::array>() &&
+				statuses.get<picojson::array>().size() == 1, "Script returned wrong number of fields");
+			const std::string error = FromJson<std::string>(statuses.get(0).get(1));
+			WEBDRIVERXX_CHECK(error.empty(), error);
+			return;
+		}
+		WEBDRIVERXX_CHECK(entry.chunk_size > 0, "Chunk size is zero");
+		element.GetResource().Post("clear"); // Like SetValue, replaces the value
+		const detail::Keyboard keyboard = element.GetKeyboard();
+		for (const auto& chunk : detail::SplitUtf8(text, entry.chunk_size))
+			keyboard.SendKeys(chunk);
+	});
 	return *this;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "method: " << entry.method
+		<< ", text size: " << text.size()
+		)
 }
 
 inline
 bool Element::Equals(const Element& other) const {
-	return GetResource().GetBool(std::string("equals/") + other.ref_);
+	return Run([&other](const Element& element) {
+		return element.GetResource().GetBool(std::string("equals/") + other.ref_);
+	});
 }
 
 inline
@@ -138,6 +223,19 @@ bool Element::operator < (const Element& other) const {
 	return ref_ < other.ref_;
 }
 
+template<typename Command>
+auto Element::Run(const Command& command) const -> decltype(command(*this)) {
+	try {
+		return command(*this);
+	} catch (const WebDriverException& e) {
+		Element found_again;
+		if (e.GetStatusCode() != response_status_code::kStaleElementReference
+			|| !factory_ || !factory_->FindElementAgain(ref_, found_again))
+			throw;
+		return command(found_again);
+	}
+}
+
 inline
 detail::Resource& Element::GetResource() const {
 	WEBDRIVERXX_CHECK(resource_, "Attempt to use empty element");
@@ -150,4 +248,10 @@ detail::Keyboard Element::GetKeyboard() const
 	return detail::Keyboard(&GetResource(), "value");
 }
 
+inline
+void Element::ForgetFrameFocus() const {
+	if (focus_)
+		focus_->ForgetNestedFrame();
+}
+
 } // namespace webdriverxx
@@ -0,0 +1,132 @@
+#ifndef WEBDRIVERXX_ELEMENT_CACHE_H
+#define WEBDRIVERXX_ELEMENT_CACHE_H
+
+#include "detail/shared.h"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace webdriverxx {
+
+// Counters of Session::FindElement calls made while the cache is on.
+struct ElementCacheStats {
+	unsigned long long lookups; // Sent to the server
+	unsigned long long lookups_saved; // Answered with a cached element without a request
+	unsigned long long stale; // Cached elements that failed a command as stale and were looked up again
+
+	ElementCacheStats()
+		: lookups(0)
+		, lookups_saved(0)
+		, stale(0)
+	{}
+};
+
+namespace detail {
+
+// Element references by search context and locator, shared
+// by copies of a session and its elements. Cached elements are not
+// checked before they are returned; an element command that fails
+// as stale asks the cache to look the element up again.
+class ElementCache : public SharedObjectBase { // noncopyable
+public:
+	typedef std::function<std::string()> LookUp; // Returns the ref of a new search
+
+	ElementCache() : enabled_(false) {}
+
+	void SetEnabled(bool enabled) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		enabled_ = enabled;
+		if (!enabled)
+			ClearLocked();
+	}
+
+	bool IsEnabled() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return enabled_;
+	}
+
+	bool Find(const std::string& key, std::string& ref) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		const auto it = entries_.find(key);
+		if (it == entries_.end())
+			return false;
+		ref = it->second.ref;
+		++stats_.lookups_saved;
+		return true;
+	}
+
+	void Store(const std::string& key, const std::string& ref, const LookUp& look_up) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!enabled_)
+			return;
+		const Entry entry = { ref, look_up };
+		const auto it = entries_.find(key);
+		if (it != entries_.end()) {
+			keys_.erase(it->second.ref); // Refreshed, the old ref is not handed out again
+			it->second = entry;
+		} else {
+			entries_[key] = entry;
+		}
+		keys_[ref] = key;
+	}
+
+	// For a ref handed out by the cache that went stale: returns the ref
+	// the locator has now, searching again. Returns false for other refs,
+	// including stale refs whose entry was refreshed since.
+	bool FindAgain(const std::string& stale_ref, std::string& ref) {
+		LookUp look_up;
+		std::string key;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			const auto key_it = keys_.find(stale_ref);
+			if (key_it == keys_.end())
+				return false;
+			key = key_it->second;
+			look_up = entries_[key].look_up;
+			++stats_.stale;
+			++stats_.lookups;
+		}
+		ref = look_up(); // Not under the lock, it is a request
+		Store(key, ref, look_up);
+		return true;
+	}
+
+	void Clear() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		ClearLocked();
+	}
+
+	void CountLookup() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		++stats_.lookups;
+	}
+
+	ElementCacheStats GetStats() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return stats_;
+	}
+
+private:
+	struct Entry {
+		std::string ref;
+		LookUp look_up;
+	};
+
+	void ClearLocked() {
+		entries_.clear();
+		keys_.clear();
+	}
+
+private:
+	mutable std::mutex mutex_;
+	bool enabled_;
+	std::map<std::string, Entry> entries_; // By context and locator
+	std::map<std::string, std::string> keys_; // Keys of the refs in entries_
+	ElementCacheStats stats_;
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -1,14 +1,26 @@
 #ifndef WEBDRIVERXX_ERRORS_H
 #define WEBDRIVERXX_ERRORS_H
 
+#include "response_status_code.h"
 #include <stdexcept>
 #include <string>
 
 namespace webdriverxx {
 
 struct WebDriverException : std::runtime_error {
-	explicit WebDriverException(const std::string& message)
-		: std::runtime_error(message) {}
+	explicit WebDriverException(
+		const std::string& message,
+		response_status_code::Value status_code = response_status_code::kSuccess
+		)
+		: std::runtime_error(message)
+		, status_code_(status_code) {}
+
+	// Status the server failed the command with (e.g. kStaleElementReference),
+	// or kSuccess if the failure was not reported by the server.
+	response_status_code::Value GetStatusCode() const { return status_code_; }
+
+private:
+	response_status_code::Value status_code_;
 };
 
 } // namespace webdriverxx
@@ -0,0 +1,36 @@
+#ifndef WEBDRIVERXX_FILE_UPLOAD_H
+#define WEBDRIVERXX_FILE_UPLOAD_H
+
+#include "session.h"
+#include "conversions.h"
+#include "detail/error_handling.h"
+#include "detail/file_upload.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace webdriverxx {
+
+// Sends a local file to the machine of a remote browser and returns
+// its path there, for SendKeys to a file input. The file is zipped and
+// encoded while it is sent, so memory use does not depend on its size.
+// Requires zlib, define WEBDRIVERXX_ENABLE_ZLIB to enable it.
+inline
+std::string UploadFile(const Session& session, const std::string& path) {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+	const auto body = std::make_shared<detail::FileUploadBody>(path);
+	return FromJson<std::string>(session.PostCommandStreamed("file", body->GetSize(),
+		[body](char* buffer, size_t size) { return body->Read(buffer, size); }));
+#else
+	(void)session;
+	WEBDRIVERXX_THROW("File upload requires zlib, define WEBDRIVERXX_ENABLE_ZLIB to enable it");
+#endif
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "path: " << path
+		)
+}
+
+} // namespace webdriverxx
+
+#endif
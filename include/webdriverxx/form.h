@@ -0,0 +1,147 @@
+#ifndef WEBDRIVERXX_FORM_H
+#define WEBDRIVERXX_FORM_H
+
+#include "by.h"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace webdriverxx {
+
+typedef std::vector<std::pair<By, std::string>> FormFields; // Locators and values
+
+// How Session::FillForm puts values into fields.
+enum FormFillMode {
+	// Clear and SendKeys for every field, the browser sees real key
+	// presses. Costs a request for all locators plus two per field.
+	// Not pipelined: the requests are sent one after another, because
+	// waiting for each response is the only way to keep their order.
+	// libcurl dropped HTTP/1.1 pipelining, and concurrent HTTP/2 streams
+	// (or CommandBatch lanes) are not ordered, so the server could type
+	// into a field before clearing it or fill the fields out of order.
+	TypeValues,
+	// One script sets all values and dispatches input and change events,
+	// as a page script would. Costs one request for the whole form.
+	SetValues
+};
+
+// How Element::EnterText delivers a long text. Both methods replace
+// the value the element had.
+struct TextEntry { // copyable
+	enum Method {
+		// Clears the element, then types the text with a command per
+		// chunk_size characters, so every command finishes in a reasonable
+		// time. Chunks are sent one after another because the order of
+		// keys matters.
+		TypeInChunks,
+		// One script replaces the value and dispatches one input and one
+		// change event, like FillForm with SetValues.
+		SetValue
+	};
+
+	Method method;
+	size_t chunk_size;
+
+	TextEntry(Method method = TypeInChunks, size_t chunk_size = 1000)
+		: method(method)
+		, chunk_size(chunk_size)
+	{}
+
+	TextEntry& SetMethod(Method value) {
+		method = value;
+		return *this;
+	}
+
+	TextEntry& SetChunkSize(size_t value) {
+		chunk_size = value;
+		return *this;
+	}
+};
+
+// What happened to a field of Session::FillForm, in the order of fields.
+struct FormFieldResult {
+	enum Status {
+		Filled,
+		NotFound, // The locator found no element
+		Failed
+	};
+
+	Status status;
+	std::string error;
+
+	FormFieldResult() : status(Filled) {}
+};
+
+namespace detail {
+
+// Splits UTF-8 text into pieces of at most max_chars code points.
+inline
+std::vector<std::string> SplitUtf8(const std::string& text, size_t max_chars) {
+	std::vector<std::string> result;
+	size_t begin = 0;
+	size_t chars = 0;
+	for (size_t i = 0; i < text.size(); ++i) {
+		if ((static_cast<unsigned char>(text[i]) & 0xC0) == 0x80)
+			continue; // Continuation byte
+		if (chars == max_chars) {
+			result.push_back(text.substr(begin, i - begin));
+			begin = i;
+			chars = 0;
+		}
+		++chars;
+	}
+	if (begin < text.size())
+		result.push_back(text.substr(begin));
+	return result;
+}
+
+// Expects found[i][0] to be the element of the i-th field or undefined,
+// takes values in arguments[1]. Returns [status, error] for every field,
+// an exception fails only its field.
+// Selects take the value or the text of an option. Inputs and textareas
+// get the value through the prototype's setter, so frameworks that
+// override the element's value property notice the change.
+const char *const kFillFormScript =
+	"function fire(e, type) {"
+		"var event = document.createEvent('HTMLEvents');"
+		"event.initEvent(type, true, false);"
+		"e.dispatchEvent(event);"
+	"}"
+	"function set(e, value) {"
+		"var tag = e.tagName.toLowerCase(), type = (e.type || '').toLowerCase();"
+		"if (e.disabled) return 'Element is disabled';"
+		"if (e.readOnly) return 'Element is read-only';"
+		"if (tag === 'select') {"
+			"for (var i = 0; i < e.options.length; ++i)"
+				"if (e.options[i].value === value || e.options[i].text === value) break;"
+			"if (i === e.options.length) return 'Select has no such option';"
+			"e.selectedIndex = i;"
+		"} else if (tag === 'textarea' || (tag === 'input' && type !== 'checkbox' && type !== 'radio' && type !== 'file')) {"
+			"var property = Object.getOwnPropertyDescriptor(Object.getPrototypeOf(e), 'value');"
+			"if (property && property.set) property.set.call(e, value); else e.value = value;"
+		"} else if (e.isContentEditable) {"
+			"e.textContent = value;"
+		"} else {"
+			"return 'Element does not take text';"
+		"}"
+		"fire(e, 'input');"
+		"fire(e, 'change');"
+		"return '';"
+	"}"
+	"return arguments[1].map(function(value, i) {"
+		"var e = found[i][0];"
+		"if (!e) return [1, ''];"
+		"try {"
+			"var error = set(e, value);"
+			"return [error ? 2 : 0, error];"
+		"} catch (exception) {"
+			"return [2, String(exception)];" // A page handler threw, other fields go on
+		"}"
+	"});"
+	;
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef WEBDRIVERXX_IMAGE_H
+#define WEBDRIVERXX_IMAGE_H
+
+#include "session.h"
+#include "types.h"
+#include "detail/error_handling.h"
+#include "detail/png.h"
+#include "detail/template_match.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+// 8-bit RGBA pixels, rows from top to bottom.
+struct Image { // copyable
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+
+	Image() : width(0), height(0) {}
+	Image(int width, int height)
+		: width(width)
+		, height(height)
+		, pixels(static_cast<size_t>(width) * height * 4)
+	{}
+
+	unsigned char* GetPixel(int x, int y) {
+		return &pixels[(static_cast<size_t>(y) * width + x) * 4];
+	}
+
+	const unsigned char* GetPixel(int x, int y) const {
+		return &pixels[(static_cast<size_t>(y) * width + x) * 4];
+	}
+
+	// The rectangle must be inside the image.
+	Image Crop(int x, int y, int crop_width, int crop_height) const {
+		WEBDRIVERXX_CHECK(x >= 0 && y >= 0 && crop_width >= 0 && crop_height >= 0
+			&& x + crop_width <= width && y + crop_height <= height,
+			"Crop rectangle is outside of the image");
+		Image result(crop_width, crop_height);
+		for (int row = 0; row < crop_height; ++row)
+			std::copy(GetPixel(x, y + row), GetPixel(x, y + row) + crop_width * 4,
+				result.GetPixel(0, row));
+		return result;
+	}
+};
+
+// PNG decoding and encoding require zlib, define WEBDRIVERXX_ENABLE_ZLIB
+// to enable them. Interlaced images are not supported.
+inline
+Image DecodePng(const std::string& png) {
+	Image result;
+	result.pixels = detail::DecodePngRgba(png, result.width, result.height);
+	return result;
+}
+
+inline
+std::string EncodePng(const Image& image) {
+	return detail::EncodePngRgba(image.pixels.data(), image.width, image.height);
+}
+
+// Takes the result of Session::GetScreenshot.
+inline
+Image DecodeScreenshot(const std::string& base64_png) {
+	return DecodePng(detail::DecodeBase64(base64_png));
+}
+
+struct ImageSearch { // copyable
+	// Normalized cross-correlation of grayscale pixels, from -1 to 1.
+	// Antialiasing and scaling of the same picture usually stay above 0.9.
+	double threshold;
+	size_t max_matches;
+	// Times to halve the screen and the pattern before the full search, as
+	// long as the pattern stays at least 8 pixels on each side. 0 searches
+	// at full size, which is exact but slow for big patterns.
+	int max_levels;
+
+	ImageSearch()
+		: threshold(0.9)
+		, max_matches(1)
+		, max_levels(4)
+	{}
+
+	ImageSearch& SetThreshold(double value) {
+		threshold = value;
+		return *this;
+	}
+
+	ImageSearch& SetMaxMatches(size_t value) {
+		max_matches = value;
+		return *this;
+	}
+
+	ImageSearch& SetMaxLevels(int value) {
+		max_levels = value;
+		return *this;
+	}
+};
+
+struct ImageMatch { // copyable
+	Point top_left;
+	Point center; // Where a click goes
+	double score;
+
+	ImageMatch() : score(0) {}
+};
+
+// Finds the pattern in the image, best matches first. Positions are in
+// pixels of the image.
+inline
+std::vector<ImageMatch> FindImage(const Image& image, const Image& pattern,
+	const ImageSearch& search = ImageSearch()) {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	std::vector<ImageMatch> result;
+	for (const auto& match : detail::MatchTemplate(
+			detail::ToGray(image.pixels.data(), image.width, image.height),
+			detail::ToGray(pattern.pixels.data(), pattern.width, pattern.height),
+			search.threshold, search.max_matches, search.max_levels)) {
+		ImageMatch item;
+		item.top_left = Point(match.x, match.y);
+		item.center = Point(match.x + pattern.width / 2, match.y + pattern.height / 2);
+		item.score = match.score;
+		result.push_back(item);
+	}
+	return result;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "image: " << image.width << "x" << image.height
+		<< ", pattern: " << pattern.width << "x" << pattern.height
+		)
+}
+
+} // namespace webdriverxx
+
+#include "image.inl"
+
+#endif
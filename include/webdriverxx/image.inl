@@ -0,0 +1,30 @@
+#include "detail/error_handling.h"
+
+namespace webdriverxx {
+
+inline
+std::vector<ImageMatch> Session::FindImage(const Image& pattern) const {
+	return FindImage(pattern, ImageSearch());
+}
+
+inline
+std::vector<ImageMatch> Session::FindImage(const Image& pattern, const ImageSearch& search) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	const Image screen = DecodeScreenshot(GetScreenshot());
+	double ratio = 1;
+	InternalEval("execute", "return window.devicePixelRatio || 1;", JsArgs(), ratio);
+	WEBDRIVERXX_CHECK(ratio > 0, "Invalid device pixel ratio");
+	std::vector<ImageMatch> result = webdriverxx::FindImage(screen, pattern, search);
+	for (auto& match : result) {
+		match.top_left = Point(static_cast<int>(match.top_left.x / ratio),
+			static_cast<int>(match.top_left.y / ratio));
+		match.center = Point(static_cast<int>(match.center.x / ratio),
+			static_cast<int>(match.center.y / ratio));
+	}
+	return result;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "pattern: " << pattern.width << "x" << pattern.height
+		)
+}
+
+} // namespace webdriverxx
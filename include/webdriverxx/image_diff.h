@@ -0,0 +1,210 @@
+#ifndef WEBDRIVERXX_IMAGE_DIFF_H
+#define WEBDRIVERXX_IMAGE_DIFF_H
+
+#include "image.h"
+#include "types.h"
+#include "detail/error_handling.h"
+#include "detail/pixel_diff.h"
+#include "detail/png.h"
+#include "detail/shared.h"
+#include "detail/thread_pool.h"
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace webdriverxx {
+
+struct ImageDiffOptions { // copyable
+	// Largest difference of a channel, 0 to 255, that still counts as equal.
+	int tolerance;
+	// Pixels inside these rectangles, such as clocks and ads, are skipped.
+	std::vector<Rect> ignored_regions;
+	// Images of the same size whose perceptual hashes differ in more
+	// than this many of 64 bits are reported different without comparing
+	// pixels. Close hashes never skip the comparison: a small change
+	// need not change the hash. -1 disables the prefilter. Ignored
+	// regions are blanked in both images before hashing.
+	int max_hash_distance;
+	bool make_mask;
+
+	ImageDiffOptions()
+		: tolerance(0)
+		, max_hash_distance(-1)
+		, make_mask(true)
+	{}
+
+	ImageDiffOptions& SetTolerance(int value) {
+		tolerance = value;
+		return *this;
+	}
+
+	ImageDiffOptions& Ignore(const Rect& region) {
+		ignored_regions.push_back(region);
+		return *this;
+	}
+
+	ImageDiffOptions& SetMaxHashDistance(int value) {
+		max_hash_distance = value;
+		return *this;
+	}
+
+	ImageDiffOptions& SetMakeMask(bool value) {
+		make_mask = value;
+		return *this;
+	}
+};
+
+struct ImageDiff { // copyable
+	bool same_size; // Images of different sizes differ entirely
+	bool pixels_compared; // False for identical files and too different sizes or hashes
+	size_t compared_pixels; // Not in ignored regions
+	size_t mismatched_pixels;
+	// Of compared pixels. 1 if pixels were not compared because the
+	// sizes or the hashes differ, 0 for identical PNG files.
+	double mismatch_ratio;
+	int hash_distance; // -1 if the hashes were not computed
+	// Opaque red where pixels differ and transparent elsewhere, the size
+	// of the images. Empty if not asked for or if pixels were not compared.
+	Image mask;
+
+	ImageDiff()
+		: same_size(true)
+		, pixels_compared(false)
+		, compared_pixels(0)
+		, mismatched_pixels(0)
+		, mismatch_ratio(0)
+		, hash_distance(-1)
+	{}
+};
+
+inline
+unsigned long long GetPerceptualHash(const Image& image) {
+	return detail::GetDifferenceHash(image.pixels.data(), image.width, image.height);
+}
+
+namespace detail {
+
+// With the regions blanked, so what changes there can't move the hash.
+inline
+unsigned long long GetPerceptualHash(const Image& image, const std::vector<Rect>& ignored_regions) {
+	if (ignored_regions.empty())
+		return webdriverxx::GetPerceptualHash(image);
+	Image blanked = image;
+	std::vector<unsigned char> ignored(image.width);
+	for (int y = 0; y < image.height; ++y) {
+		MarkIgnoredPixels(ignored_regions, y, image.width, ignored.data());
+		for (int x = 0; x < image.width; ++x)
+			if (ignored[x])
+				std::fill(blanked.GetPixel(x, y), blanked.GetPixel(x, y) + 4, 0);
+	}
+	return webdriverxx::GetPerceptualHash(blanked);
+}
+
+} // namespace detail
+
+inline
+ImageDiff DiffImages(const Image& expected, const Image& actual,
+	const ImageDiffOptions& options = ImageDiffOptions()) {
+	ImageDiff result;
+	if (expected.width != actual.width || expected.height != actual.height) {
+		result.same_size = false;
+		result.mismatch_ratio = 1;
+		return result;
+	}
+	if (options.max_hash_distance >= 0) {
+		result.hash_distance = detail::CountDifferentBits(
+			detail::GetPerceptualHash(expected, options.ignored_regions),
+			detail::GetPerceptualHash(actual, options.ignored_regions));
+		if (result.hash_distance > options.max_hash_distance) {
+			result.mismatch_ratio = 1; // Clearly different
+			return result;
+		}
+	}
+	const int width = expected.width;
+	if (options.make_mask)
+		result.mask = Image(width, expected.height);
+	std::vector<unsigned char> channel_diffs(static_cast<size_t>(width) * 4);
+	std::vector<unsigned char> mismatches(width), ignored(width);
+	for (int y = 0; y < expected.height; ++y) {
+		detail::DiffPixelRow(expected.GetPixel(0, y), actual.GetPixel(0, y), width,
+			options.tolerance, channel_diffs.data(), mismatches.data());
+		size_t row_ignored = 0;
+		if (!options.ignored_regions.empty()) {
+			detail::MarkIgnoredPixels(options.ignored_regions, y, width, ignored.data());
+			for (int x = 0; x < width; ++x) {
+				mismatches[x] &= static_cast<unsigned char>(ignored[x] ^ 1);
+				row_ignored += ignored[x];
+			}
+		}
+		size_t row_mismatched = 0;
+		for (int x = 0; x < width; ++x)
+			row_mismatched += mismatches[x];
+		result.compared_pixels += width - row_ignored;
+		result.mismatched_pixels += row_mismatched;
+		if (options.make_mask && row_mismatched) {
+			unsigned char* mask = result.mask.GetPixel(0, y);
+			for (int x = 0; x < width; ++x) {
+				mask[x * 4] = static_cast<unsigned char>(mismatches[x] * 255);
+				mask[x * 4 + 3] = static_cast<unsigned char>(mismatches[x] * 255);
+			}
+		}
+	}
+	result.pixels_compared = true;
+	result.mismatch_ratio = result.compared_pixels
+		? static_cast<double>(result.mismatched_pixels) / result.compared_pixels : 0;
+	return result;
+}
+
+// Same for PNG images. Identical files are reported equal without
+// decoding them, which is the common case for a stable page.
+inline
+ImageDiff DiffPngs(const std::string& expected_png, const std::string& actual_png,
+	const ImageDiffOptions& options = ImageDiffOptions()) {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	if (expected_png == actual_png)
+		return ImageDiff();
+	return DiffImages(DecodePng(expected_png), DecodePng(actual_png), options);
+	WEBDRIVERXX_FUNCTION_CONTEXT_END()
+}
+
+// Compares images on a thread pool, decoding included. Copies share the pool.
+class ImageComparer { // copyable
+public:
+	explicit ImageComparer(size_t threads = GetDefaultThreadCount())
+		: pool_(new detail::ThreadPool(threads))
+	{}
+
+	std::future<ImageDiff> Compare(const std::string& expected_png, const std::string& actual_png,
+		const ImageDiffOptions& options = ImageDiffOptions()) const {
+		const auto images = std::make_shared<std::pair<std::string, std::string>>(expected_png, actual_png);
+		return pool_->Async([images, options] {
+			return DiffPngs(images->first, images->second, options);
+		});
+	}
+
+	// Takes the result of Session::GetScreenshot as the actual image.
+	std::future<ImageDiff> CompareScreenshot(const std::string& baseline_png, const std::string& screenshot,
+		const ImageDiffOptions& options = ImageDiffOptions()) const {
+		const auto images = std::make_shared<std::pair<std::string, std::string>>(baseline_png, screenshot);
+		return pool_->Async([images, options] {
+			return DiffPngs(images->first, detail::DecodeBase64(images->second), options);
+		});
+	}
+
+	static
+	size_t GetDefaultThreadCount() {
+		const unsigned cores = std::thread::hardware_concurrency();
+		return cores ? cores : 1;
+	}
+
+private:
+	detail::Shared<detail::ThreadPool> pool_;
+};
+
+} // namespace webdriverxx
+
+#endif
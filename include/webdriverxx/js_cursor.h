@@ -0,0 +1,188 @@
+#ifndef WEBDRIVERXX_JS_CURSOR_H
+#define WEBDRIVERXX_JS_CURSOR_H
+
+#include "session.h"
+#include "js_args.h"
+#include "conversions.h"
+#include "detail/error_handling.h"
+#include <picojson.h>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+const size_t kDefaultJsCursorPageItems = 1000;
+const size_t kDefaultJsCursorPageBytes = 1024 * 1024;
+
+namespace detail {
+
+// The result array is kept in the page until the cursor is closed.
+const char *const kOpenJsCursorScript =
+	"var cursors = window.__webdriverxx_cursors = window.__webdriverxx_cursors || { next_id: 1 };"
+	"var items = (function() {\n%SCRIPT%\n}).apply(this, arguments);"
+	"if (!Array.isArray(items))"
+		"throw new Error('Script should return an array');"
+	"var id = String(cursors.next_id++);"
+	"cursors[id] = { items: items, next: 0 };"
+	"return { id: id, size: items.length };"
+	;
+
+// Returns at least one item and stops before exceeding max bytes
+// of JSON, unless a single item is larger than that.
+const char *const kReadJsCursorScript =
+	"var cursor = (window.__webdriverxx_cursors || {})[arguments[0]];"
+	"if (!cursor)"
+		"throw new Error('Cursor is gone, the page was probably reloaded');"
+	"var page = [], bytes = 0;"
+	"while (cursor.next < cursor.items.length && page.length < arguments[1]) {"
+		"var item = cursor.items[cursor.next];"
+		"var size = typeof item === 'string' ? item.length : (JSON.stringify(item) || '').length;"
+		"if (page.length && bytes + size > arguments[2])"
+			"break;"
+		"page.push(item);"
+		"bytes += size;"
+		"cursor.next++;"
+	"}"
+	"return page;"
+	;
+
+const char *const kCloseJsCursorScript =
+	"if (window.__webdriverxx_cursors)"
+		"delete window.__webdriverxx_cursors[arguments[0]];"
+	;
+
+struct JsCursorState { // noncopyable
+	const Session session;
+	std::string id;
+	size_t size;
+	size_t read;
+	bool closed;
+
+	explicit JsCursorState(const Session& session)
+		: session(session)
+		, size(0)
+		, read(0)
+		, closed(false)
+	{}
+
+	void Close() {
+		if (closed)
+			return;
+		closed = true;
+		session.Execute(kCloseJsCursorScript, JsArgs() << id);
+	}
+
+	~JsCursorState() {
+		try {
+			Close();
+		} catch (const std::exception&) {}
+	}
+
+private:
+	JsCursorState(JsCursorState&);
+	JsCursorState& operator = (JsCursorState&);
+};
+
+} // namespace detail
+
+// Reads a huge array returned by a script in pages of bounded size.
+// The array stays in the browser, only one page at a time is transferred
+// and parsed. Items should be convertible by FromJson<T>, elements are
+// not supported. Copies share the position, the array is released
+// when it is read to the end or when the last copy is destroyed.
+template<typename T>
+class JsCursor { // copyable
+public:
+	JsCursor(
+		const Session& session,
+		const std::string& script,
+		const JsArgs& args = JsArgs(),
+		size_t page_items = kDefaultJsCursorPageItems,
+		size_t page_bytes = kDefaultJsCursorPageBytes
+		)
+		: state_(std::make_shared<detail::JsCursorState>(session))
+		, page_items_(page_items)
+		, page_bytes_(page_bytes)
+	{
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		WEBDRIVERXX_CHECK(page_items > 0, "Page size is zero");
+		std::string open_script = detail::kOpenJsCursorScript;
+		const std::string kPlaceholder = "%SCRIPT%";
+		open_script.replace(open_script.find(kPlaceholder), kPlaceholder.size(), script);
+		const auto info = session.Eval<picojson::value>(open_script, args);
+		WEBDRIVERXX_CHECK(info.is<picojson::object>(), "Cursor info is not an object");
+		state_->id = FromJson<std::string>(info.get("id"));
+		state_->size = FromJson<unsigned>(info.get("size"));
+		if (!state_->size)
+			state_->Close();
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "script: " << script
+			)
+	}
+
+	// Total number of items.
+	size_t GetSize() const {
+		return state_->size;
+	}
+
+	bool IsAtEnd() const {
+		return state_->closed || state_->read >= state_->size;
+	}
+
+	// Replaces contents of the page with the next items.
+	// Returns false if there are no more items or the cursor is closed.
+	bool Next(std::vector<T>& page) const {
+		page.clear();
+		if (IsAtEnd())
+			return false;
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		const auto items = state_->session.template Eval<picojson::value>(
+			detail::kReadJsCursorScript,
+			JsArgs()
+				<< state_->id
+				<< static_cast<int>(page_items_)
+				<< static_cast<int>(page_bytes_)
+			);
+		WEBDRIVERXX_CHECK(items.is<picojson::array>() && !items.get<picojson::array>().empty(),
+			"Page is not a non-empty array");
+		const auto& array = items.get<picojson::array>();
+		page.reserve(array.size());
+		for (const auto& item : array)
+			page.push_back(FromJson<T>(item));
+		state_->read += array.size();
+		if (state_->read >= state_->size)
+			state_->Close();
+		return true;
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "cursor: " << state_->id
+			<< ", read: " << state_->read
+			<< ", size: " << state_->size
+			)
+	}
+
+	// Passes remaining items to the handler one by one.
+	void ForEach(const std::function<void(const T& item)>& handler) const {
+		std::vector<T> page;
+		while (Next(page))
+			for (const auto& item : page)
+				handler(item);
+	}
+
+	// Releases the array in the browser before reading it to the end.
+	void Close() const {
+		state_->Close();
+	}
+
+private:
+	std::shared_ptr<detail::JsCursorState> state_;
+	size_t page_items_;
+	size_t page_bytes_;
+};
+
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef WEBDRIVERXX_METRICS_H
+#define WEBDRIVERXX_METRICS_H
+
+#include "detail/shared.h"
+#include <atomic>
+
+namespace webdriverxx {
+
+// Counters shared by a Client and all its sessions and elements.
+struct Metrics {
+	unsigned long long requests; // Sent HTTP requests, including retries
+	unsigned long long retries;
+	// Request and response bodies. Sizes on the wire are smaller
+	// than the decoded ones when compression is on.
+	unsigned long long bytes_sent;
+	unsigned long long bytes_sent_on_wire;
+	unsigned long long bytes_received;
+	unsigned long long bytes_received_on_wire;
+
+	Metrics()
+		: requests(0)
+		, retries(0)
+		, bytes_sent(0)
+		, bytes_sent_on_wire(0)
+		, bytes_received(0)
+		, bytes_received_on_wire(0)
+	{}
+};
+
+namespace detail {
+
+class MetricsCounters : public SharedObjectBase { // noncopyable
+public:
+	std::atomic<unsigned long long> requests;
+	std::atomic<unsigned long long> retries;
+	std::atomic<unsigned long long> bytes_sent;
+	std::atomic<unsigned long long> bytes_sent_on_wire;
+	std::atomic<unsigned long long> bytes_received;
+	std::atomic<unsigned long long> bytes_received_on_wire;
+
+	MetricsCounters()
+		: requests(0)
+		, retries(0)
+		, bytes_sent(0)
+		, bytes_sent_on_wire(0)
+		, bytes_received(0)
+		, bytes_received_on_wire(0)
+	{}
+
+	Metrics GetSnapshot() const {
+		Metrics result;
+		result.requests = requests;
+		result.retries = retries;
+		result.bytes_sent = bytes_sent;
+		result.bytes_sent_on_wire = bytes_sent_on_wire;
+		result.bytes_received = bytes_received;
+		result.bytes_received_on_wire = bytes_received_on_wire;
+		return result;
+	}
+};
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
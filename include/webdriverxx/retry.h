@@ -0,0 +1,32 @@
+#ifndef WEBDRIVERXX_RETRY_H
+#define WEBDRIVERXX_RETRY_H
+
+#include "types.h"
+
+namespace webdriverxx {
+
+// Controls automatic retries of commands that are safe to repeat:
+// GET and DELETE requests, element lookups and timeouts. Commands with
+// side effects (clicks, input, navigation, scripts) are never repeated.
+// Transport errors and HTTP codes 502, 503 and 504 are retried,
+// cancelled commands are not (see CancellationToken).
+// Default policy doesn't retry.
+struct RetryPolicy {
+	unsigned max_attempts; // 1 means no retries
+	Duration backoff_ms; // Before the first retry, doubles for every next one
+	Duration max_backoff_ms;
+
+	explicit RetryPolicy(
+		unsigned max_attempts = 1,
+		Duration backoff_ms = 100,
+		Duration max_backoff_ms = 2000
+		)
+		: max_attempts(max_attempts)
+		, backoff_ms(backoff_ms)
+		, max_backoff_ms(max_backoff_ms)
+	{}
+};
+
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef WEBDRIVERXX_SCRIPT_REGISTRY_H
+#define WEBDRIVERXX_SCRIPT_REGISTRY_H
+
+#include "session.h"
+#include "js_args.h"
+#include "conversions.h"
+#include "detail/error_handling.h"
+#include <picojson.h>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+namespace detail {
+
+inline
+std::string HashScripts(const std::vector<std::string>& functions) {
+	unsigned long long hash = 14695981039346656037ULL; // 64-bit FNV-1a
+	for (const auto& function : functions) {
+		for (const char c : function) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ULL;
+		}
+		hash ^= 0xFF; // Separates functions, never occurs in UTF-8
+		hash *= 1099511628211ULL;
+	}
+	static const char digits[] = "0123456789abcdef";
+	std::string result(16, '0');
+	for (size_t i = 0; i < result.size(); ++i)
+		result[i] = digits[(hash >> (60 - 4 * i)) & 0xF];
+	return result;
+}
+
+} // namespace detail
+
+// Functions that are installed into a page once and then called by
+// a short script with only their index, so a big helper library is not
+// uploaded with every call. Each call checks the functions are still there;
+// after the page is reloaded or replaced, the missing functions are
+// reported by the call, then installed and called in one more command.
+// Works with any session, each document gets its own copy.
+class ScriptRegistry { // copyable
+public:
+	// The function is a JavaScript function expression,
+	// e.g. "function(a, b) { return a + b; }".
+	ScriptRegistry& Add(const std::string& name, const std::string& function) {
+		WEBDRIVERXX_CHECK(indices_.find(name) == indices_.end(), detail::Fmt()
+			<< "Script is already registered (name: " << name << ")");
+		indices_[name] = functions_.size();
+		functions_.push_back(function);
+		key_ = detail::HashScripts(functions_);
+		return *this;
+	}
+
+	bool Contains(const std::string& name) const {
+		return indices_.find(name) != indices_.end();
+	}
+
+	// Results are converted with FromJson, so elements can't be returned.
+	template<typename T>
+	T Eval(const Session& session, const std::string& name, const JsArgs& args = JsArgs()) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		return FromJson<T>(Call(session, name, args));
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "script: " << name
+			)
+	}
+
+	void Execute(const Session& session, const std::string& name, const JsArgs& args = JsArgs()) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		Call(session, name, args);
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "script: " << name
+			)
+	}
+
+private:
+	picojson::value Call(const Session& session, const std::string& name, const JsArgs& args) const {
+		const auto it = indices_.find(name);
+		WEBDRIVERXX_CHECK(it != indices_.end(), "Script is not registered");
+		// Returns [result], or 0 if the functions are not installed
+		const std::string call_script = detail::Fmt()
+			<< "var s=window." << GetGlobalName() << ";"
+			<< "return s?[s[" << it->second << "].apply(null,arguments)]:0";
+		picojson::value result = session.Eval<picojson::value>(call_script, args);
+		if (!result.is<picojson::array>())
+			result = session.Eval<picojson::value>(GetInstallScript(it->second), args);
+		WEBDRIVERXX_CHECK(result.is<picojson::array>() && result.get<picojson::array>().size() == 1,
+			"Unexpected script result");
+		return result.get<picojson::array>()[0];
+	}
+
+	std::string GetInstallScript(size_t index) const {
+		detail::Fmt result;
+		result << "var s=window." << GetGlobalName() << "=[\n";
+		for (size_t i = 0; i < functions_.size(); ++i)
+			result << (i ? ",\n" : "") << functions_[i];
+		result << "\n];return [s[" << index << "].apply(null,arguments)];";
+		return result;
+	}
+
+	// Depends on the functions, so another set of them is installed separately.
+	std::string GetGlobalName() const {
+		return "__webdriverxx_scripts_" + key_;
+	}
+
+private:
+	std::vector<std::string> functions_;
+	std::map<std::string, size_t> indices_;
+	std::string key_;
+};
+
+} // namespace webdriverxx
+
+#endif
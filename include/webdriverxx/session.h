@@ -7,24 +7,67 @@
 #include "capabilities.h"
 #include "keys.h"
 #include "js_args.h"
+#include "cancellation.h"
+#include "table.h"
+#include "form.h"
+#include "element_cache.h"
 #include "detail/resource.h"
 #include "detail/keyboard.h"
 #include "detail/shared.h"
 #include "detail/factories_impl.h"
+#include "detail/focus_state.h"
 #include <picojson.h>
+#include <functional>
 #include <string>
 
 namespace webdriverxx {
 
 class Client;
+class DomSnapshot;
+struct Image;
+struct ImageSearch;
+struct ImageMatch;
+struct SessionState;
+
+// Takes the next piece of a text, returns false to stop reading.
+typedef std::function<bool(const std::string& chunk)> TextChunkHandler;
+
+// A level of a frame path: a frame number, name or id, or an iframe element.
+class FrameId { // copyable
+public:
+	FrameId(int number) : id_(ToJson(number)) {}
+	FrameId(const std::string& name_or_id) : id_(ToJson(name_or_id)) {}
+	FrameId(const char* name_or_id) : id_(ToJson(std::string(name_or_id))) {}
+	FrameId(const Element& frame) : id_(ToJson(frame)) {}
+
+	const picojson::value& GetJson() const {
+		return id_;
+	}
 
+private:
+	picojson::value id_;
+};
+
+// Remembers the window and frame it is focused on, so switching to
+// them again costs nothing. Copies of a session share the focus,
+// sessions attached to the same ID separately don't.
 class Session { // copyable
 public:	
+	std::string GetId() const;
 	Capabilities GetCapabilities() const;
 	std::string GetSource() const;
+	// Passes the page source to the handler in chunks as the response
+	// is received, without keeping the whole source in memory.
+	const Session& StreamSource(const TextChunkHandler& handler) const;
 	std::string GetTitle() const;
 	std::string GetUrl() const;
 	std::string GetScreenshot() const; // Base64 PNG
+	// Finds the pattern on a screenshot of the viewport, for pages such as
+	// canvas apps that have no elements to locate. Positions are in CSS
+	// pixels of the viewport, so the pattern should be cut from a screenshot
+	// of a display with the same pixel ratio. Requires zlib and image.h.
+	std::vector<ImageMatch> FindImage(const Image& pattern) const;
+	std::vector<ImageMatch> FindImage(const Image& pattern, const ImageSearch& search) const;
 
 	const Session& Navigate(const std::string& url) const;
 	const Session& Get(const std::string& url) const; // Same as Navigate
@@ -44,6 +87,9 @@ public:
 	const Session& SetFocusToFrame(int number) const;
 	const Session& SetFocusToDefaultFrame() const;
 	const Session& SetFocusToParentFrame() const;
+	// Focuses a frame by its path from the top frame of the current window.
+	// Levels that are already focused are not switched again.
+	const Session& SetFocusToFramePath(const std::vector<FrameId>& path) const;
 
 	std::vector<Window> GetWindows() const;
 	Window GetCurrentWindow() const;
@@ -55,12 +101,50 @@ public:
 
 	Element FindElement(const By& by) const;
 	std::vector<Element> FindElements(const By& by) const;
+	// Resolves all locators in one request, returns
+	// matching elements in the order of locators.
+	std::vector<std::vector<Element>> FindAll(const std::vector<By>& locators) const;
+
+	// Off by default. FindElement of the session and its elements returns
+	// the element found earlier by the same locator in the same context if
+	// it is still attached, which is checked with a cheap command. Elements
+	// that are gone are looked up again. Navigation and window and frame
+	// switches clear the cache.
+	const Session& SetElementCacheEnabled(bool enabled) const;
+	const Session& ClearElementCache() const;
+	ElementCacheStats GetElementCacheStats() const;
+
+	// Copies the document of the current frame with one script evaluation,
+	// for pages that no longer change and are read a lot. Requires dom_snapshot.h.
+	DomSnapshot CaptureDom() const;
+
+	// Fills fields in their order. Fields whose locator finds nothing or
+	// whose value can't be set are reported and skipped, the rest are filled.
+	std::vector<FormFieldResult> FillForm(const FormFields& fields,
+		FormFillMode mode = TypeValues) const;
+
+	// Pulls columns of a table, thead, tbody or tfoot element with one
+	// script evaluation per chunk_rows rows.
+	Table ExtractTable(const By& table, const std::vector<TableColumn>& columns,
+		size_t chunk_rows = 1000) const;
+	// Same, but passes chunks to the handler as they arrive instead
+	// of keeping the whole table in memory.
+	const Session& ExtractTable(const By& table, const std::vector<TableColumn>& columns,
+		const TableChunkHandler& handler, size_t chunk_rows = 1000) const;
 
 	std::vector<Cookie> GetCookies() const;
 	const Session& SetCookie(const Cookie& cookie) const;
 	const Session& DeleteCookies() const;
 	const Session& DeleteCookie(const std::string& name) const;
 
+	// Cookies of the session and web storage of the current page's origin.
+	// Requires session_state.h, like ImportState.
+	SessionState ExportState() const;
+	// Restores the state with one script and one command per cookie the
+	// script can't set, e.g. an HttpOnly one. The current page should be
+	// of the state's origin. Existing storage items are kept.
+	const Session& ImportState(const SessionState& state) const;
+
 	std::string GetAlertText() const;
 	const Session& SendKeysToAlert(const std::string& text) const;
 	const Session& AcceptAlert() const;
@@ -72,6 +156,9 @@ public:
 	const Session& MoveToTopLeftOf(const Element&, const Offset& = Offset()) const;
 	const Session& MoveToCenterOf(const Element&) const;
 	const Session& MoveTo(const Offset&) const;
+	// Moves to a point of the viewport, such as ImageMatch::center, relative
+	// to the element there. The top level frame should be the current one.
+	const Session& MoveToPoint(const Point& point) const;
 	const Session& Click(mouse::Button = mouse::LeftButton) const;
 	const Session& DoubleClick() const;
 	const Session& ButtonDown(mouse::Button = mouse::LeftButton) const;
@@ -81,6 +168,20 @@ public:
 	const Session& SetImplicitTimeoutMs(int milliseconds);
 	const Session& SetAsyncScriptTimeoutMs(int milliseconds);
 
+	// Applies to all commands of the session and its elements, including
+	// commands in progress. Use CancellationScope to limit single calls.
+	const Session& SetCancellationToken(const CancellationToken& token) const;
+	CancellationToken GetCancellationToken() const;
+
+	// Low level access: POSTs the command relative to the session,
+	// e.g. "cookie", and returns the value of the response.
+	picojson::value PostCommand(const std::string& command,
+		const picojson::value& data = picojson::value()) const;
+	// Same, but reads the body of the given size from the source while
+	// it is sent, so a big body is not kept in memory.
+	picojson::value PostCommandStreamed(const std::string& command,
+		size_t size, const detail::HttpBodySource& source) const;
+
 	void DeleteSession() const; // No need to delete sessions created by WebDriver or Client
 	virtual ~Session() {}
 
@@ -100,12 +201,17 @@ private:
 		Element& result) const;
 	picojson::value InternalEvalJsonValue(const std::string& command,
 		const std::string& script, const JsArgs& args) const;
+	Table InternalMakeTableChunk(const picojson::value& columns_data,
+		const std::vector<TableColumn>& columns, size_t first_row, size_t row_count) const;
+	Element InternalPromoteDomElement(size_t ordinal, const std::string& tag) const;
 	const Session& InternalSetFocusToFrame(const picojson::value& id) const;
 	const Session& InternalMoveTo(const Element*, const Offset*) const;
 	const Session& InternalMouseButtonCommand(const char* command, mouse::Button button) const;
 
 private:
 	detail::Shared<detail::Resource> resource_;
+	detail::Shared<detail::FocusState> focus_;
+	detail::Shared<detail::ElementCache> element_cache_;
 	detail::Shared<detail::SessionFactory> factory_;
 };
 
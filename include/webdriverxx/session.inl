@@ -2,20 +2,31 @@
 #include "detail/error_handling.h"
 #include "detail/types.h"
 #include <algorithm>
+#include <memory>
 
 namespace webdriverxx {
 
 inline
 Session::Session(const detail::Shared<detail::Resource>& resource)
 	: resource_(resource)
-	, factory_(new detail::SessionFactory(resource))
+	, focus_(new detail::FocusState)
+	, element_cache_(new detail::ElementCache)
+	, factory_(new detail::SessionFactory(resource, focus_, element_cache_))
 {}
 
 inline
 void Session::DeleteSession() const {
+	focus_->Forget();
+	element_cache_->Clear();
 	resource_->Delete();
 }
 
+inline
+std::string Session::GetId() const {
+	const std::string& url = resource_->GetUrl();
+	return url.substr(url.rfind('/') + 1);
+}
+
 inline
 Capabilities Session::GetCapabilities() const {
 	return Capabilities(resource_->Get().get<picojson::object>());
@@ -26,6 +37,12 @@ std::string Session::GetSource() const {
 	return resource_->GetString("source");
 }
 
+inline
+const Session& Session::StreamSource(const TextChunkHandler& handler) const {
+	resource_->GetStreamed("source", handler);
+	return *this;
+}
+
 inline
 std::string Session::GetTitle() const {
 	return resource_->GetString("title");
@@ -65,6 +82,28 @@ const Session& Session::SetAsyncScriptTimeoutMs(int milliseconds) {
 	return *this;
 }
 
+inline
+const Session& Session::SetCancellationToken(const CancellationToken& token) const {
+	resource_->SetCancellationToken(token);
+	return *this;
+}
+
+inline
+CancellationToken Session::GetCancellationToken() const {
+	return resource_->GetCancellationToken();
+}
+
+inline
+picojson::value Session::PostCommand(const std::string& command, const picojson::value& data) const {
+	return resource_->Post(command, data);
+}
+
+inline
+picojson::value Session::PostCommandStreamed(const std::string& command,
+	size_t size, const detail::HttpBodySource& source) const {
+	return resource_->PostStreamed(command, size, source);
+}
+
 inline
 Window Session::GetCurrentWindow() const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
@@ -74,12 +113,16 @@ Window Session::GetCurrentWindow() const {
 
 inline
 const Session& Session::CloseCurrentWindow() const {
+	focus_->Forget();
+	element_cache_->Clear();
 	resource_->Delete("window");
 	return *this;
 }
 
 inline
 const Session& Session::Navigate(const std::string& url) const {
+	focus_->ForgetNestedFrame();
+	element_cache_->Clear();
 	resource_->Post("url", "url", url);
 	return *this;
 }
@@ -91,24 +134,31 @@ const Session& Session::Get(const std::string& url) const {
 
 inline
 const Session& Session::Forward() const {
+	focus_->ForgetNestedFrame();
+	element_cache_->Clear();
 	resource_->Post("forward");
 	return *this;
 }
 
 inline
 const Session& Session::Back() const {
+	focus_->ForgetNestedFrame();
+	element_cache_->Clear();
 	resource_->Post("back");
 	return *this;
 }
 
 inline
 const Session& Session::Refresh() const {
+	focus_->ForgetNestedFrame();
+	element_cache_->Clear();
 	resource_->Post("refresh");
 	return *this;
 }
 
 inline
 const Session& Session::Execute(const std::string& script, const JsArgs& args) const {
+	focus_->ForgetNestedFrame(); // Scripts may navigate
 	InternalEvalJsonValue("execute", script, args);
 	return *this;
 }
@@ -117,6 +167,7 @@ template<typename T>
 T Session::Eval(const std::string& script, const JsArgs& args) const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
 	T result = T();
+	focus_->ForgetNestedFrame();
 	InternalEval("execute", script, args, result);
 	return result;
 	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
@@ -126,6 +177,7 @@ T Session::Eval(const std::string& script, const JsArgs& args) const {
 
 inline
 const Session& Session::ExecuteAsync(const std::string& script, const JsArgs& args) const {
+	focus_->ForgetNestedFrame();
 	InternalEvalJsonValue("execute_async", script, args);
 	return *this;
 }
@@ -134,6 +186,7 @@ template<typename T>
 T Session::EvalAsync(const std::string& script, const JsArgs& args) const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
 	T result;
+	focus_->ForgetNestedFrame();
 	InternalEval("execute_async", script, args, result);
 	return result;
 	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
@@ -143,7 +196,12 @@ T Session::EvalAsync(const std::string& script, const JsArgs& args) const {
 
 inline
 const Session& Session::SetFocusToWindow(const std::string& window_name_or_handle) const {
+	if (focus_->IsOnWindow(window_name_or_handle))
+		return *this;
+	focus_->Forget();
+	element_cache_->Clear();
 	resource_->Post("window", "name", window_name_or_handle);
+	focus_->SetWindow(window_name_or_handle);
 	return *this;
 }
 
@@ -170,18 +228,66 @@ const Session& Session::SetFocusToFrame(int number) const {
 
 inline
 const Session& Session::SetFocusToDefaultFrame() const {
+	detail::FocusState::FramePath path;
+	if (focus_->GetFramePath(path) && path.empty())
+		return *this;
 	return InternalSetFocusToFrame(picojson::value());
 }
 
 inline
 const Session& Session::SetFocusToParentFrame() const {
+	detail::FocusState::FramePath path;
+	const bool known = focus_->GetFramePath(path);
+	if (known && path.empty())
+		return *this; // The top frame is its own parent
+	focus_->ForgetFrame();
+	element_cache_->Clear();
 	resource_->Post("frame/parent");
+	if (known) {
+		path.pop_back();
+		focus_->SetFramePath(path);
+	}
 	return *this;
 }
 
+inline
+const Session& Session::SetFocusToFramePath(const std::vector<FrameId>& path) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	detail::FocusState::FramePath target;
+	for (const auto& frame : path)
+		target.push_back(frame.GetJson().serialize());
+	detail::FocusState::FramePath current;
+	const bool continues_current = focus_->GetFramePath(current)
+		&& current.size() <= target.size()
+		&& std::equal(current.begin(), current.end(), target.begin());
+	if (continues_current && current.size() == target.size())
+		return *this;
+	focus_->ForgetFrame();
+	element_cache_->Clear();
+	if (!continues_current) {
+		resource_->Post("frame", JsonObject().Set("id", picojson::value()));
+		current.clear();
+	}
+	for (size_t i = current.size(); i < path.size(); ++i)
+		resource_->Post("frame", JsonObject().Set("id", path[i].GetJson()));
+	focus_->SetFramePath(target);
+	return *this;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END()
+}
+
 inline
 const Session& Session::InternalSetFocusToFrame(const picojson::value& id) const {
+	detail::FocusState::FramePath path;
+	const bool known = focus_->GetFramePath(path);
+	focus_->ForgetFrame();
+	element_cache_->Clear();
 	resource_->Post("frame", JsonObject().Set("id", id));
+	if (id.is<picojson::null>()) {
+		focus_->SetFramePath(detail::FocusState::FramePath());
+	} else if (known) {
+		path.push_back(id.serialize());
+		focus_->SetFramePath(path);
+	}
 	return *this;
 }
 
@@ -219,6 +325,175 @@ std::vector<Element> Session::FindElements(const By& by) const {
 	return factory_->MakeFinder(resource_).FindElements(by);
 }
 
+inline
+std::vector<std::vector<Element>> Session::FindAll(const std::vector<By>& locators) const {
+	return factory_->MakeFinder(resource_).FindAll(locators, nullptr);
+}
+
+inline
+const Session& Session::SetElementCacheEnabled(bool enabled) const {
+	element_cache_->SetEnabled(enabled);
+	return *this;
+}
+
+inline
+const Session& Session::ClearElementCache() const {
+	element_cache_->Clear();
+	return *this;
+}
+
+inline
+ElementCacheStats Session::GetElementCacheStats() const {
+	return element_cache_->GetStats();
+}
+
+inline
+std::vector<FormFieldResult> Session::FillForm(const FormFields& fields, FormFillMode mode) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	std::vector<By> locators;
+	std::vector<std::string> values;
+	for (const auto& field : fields) {
+		locators.push_back(field.first);
+		values.push_back(field.second);
+	}
+	std::vector<FormFieldResult> result(fields.size());
+	if (mode == SetValues) {
+		picojson::array pairs;
+		for (const auto& by : locators)
+			pairs.push_back(ToJson(std::vector<std::string>{ by.GetStrategy(), by.GetValue() }));
+		focus_->ForgetNestedFrame();
+		const picojson::value statuses = InternalEvalJsonValue("execute",
+			detail::Fmt()
+				<< "var found = (function() {" << detail::kFindAllScript << "}).apply(null, [null, arguments[0]]);"
+				<< detail::kFillFormScript,
+			JsArgs() << picojson::value(pairs) << values);
+		WEBDRIVERXX_CHECK(statuses.is<picojson::array>() &&
+			statuses.get<picojson::array>().size() == fields.size(),
+			"Script returned wrong number of fields");
+		for (size_t i = 0; i < fields.size(); ++i) {
+			const picojson::value& status = statuses.get(i);
+			result[i].status = static_cast<FormFieldResult::Status>(FromJson<int>(status.get(0)));
+			result[i].error = FromJson<std::string>(status.get(1));
+		}
+		return result;
+	}
+	const std::vector<std::vector<Element>> found = FindAll(locators);
+	// Serial on purpose, see TypeValues
+	for (size_t i = 0; i < fields.size(); ++i) {
+		if (found[i].empty()) {
+			result[i].status = FormFieldResult::NotFound;
+			continue;
+		}
+		try {
+			found[i].front().Clear().SendKeys(values[i]);
+		} catch (const std::exception& e) {
+			result[i].status = FormFieldResult::Failed;
+			result[i].error = e.what();
+		}
+	}
+	return result;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "fields: " << fields.size()
+		)
+}
+
+inline
+Table Session::ExtractTable(
+	const By& table,
+	const std::vector<TableColumn>& columns,
+	size_t chunk_rows
+	) const {
+	Table result;
+	result.values.resize(columns.size());
+	result.elements.resize(columns.size());
+	ExtractTable(table, columns, [&result](const Table& chunk) {
+		result.row_count += chunk.row_count;
+		for (size_t i = 0; i < chunk.values.size(); ++i) {
+			result.values[i].insert(result.values[i].end(),
+				chunk.values[i].begin(), chunk.values[i].end());
+			result.elements[i].insert(result.elements[i].end(),
+				chunk.elements[i].begin(), chunk.elements[i].end());
+		}
+	}, chunk_rows);
+	return result;
+}
+
+inline
+const Session& Session::ExtractTable(
+	const By& table,
+	const std::vector<TableColumn>& columns,
+	const TableChunkHandler& handler,
+	size_t chunk_rows
+	) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	WEBDRIVERXX_CHECK(chunk_rows > 0, "Chunk size is zero");
+	const Element table_element = FindElement(table);
+	picojson::array column_specs;
+	for (const auto& column : columns) {
+		picojson::array spec;
+		spec.push_back(ToJson(static_cast<int>(column.kind)));
+		spec.push_back(ToJson(static_cast<int>(column.cell)));
+		spec.push_back(ToJson(column.attribute));
+		column_specs.push_back(picojson::value(spec));
+	}
+	size_t first_row = 0;
+	size_t total_rows = 0;
+	do {
+		const picojson::value response = InternalEvalJsonValue("execute",
+			detail::kExtractTableScript,
+			JsArgs()
+				<< table_element
+				<< picojson::value(column_specs)
+				<< static_cast<int>(first_row)
+				<< static_cast<int>(chunk_rows)
+			);
+		WEBDRIVERXX_CHECK(response.is<picojson::object>(), "Table chunk is not an object");
+		total_rows = FromJson<unsigned>(response.get("total"));
+		const size_t row_count = first_row < total_rows ?
+			std::min(total_rows - first_row, chunk_rows) : 0;
+		if (row_count)
+			handler(InternalMakeTableChunk(response.get("columns"), columns, first_row, row_count));
+		first_row += row_count;
+	} while (first_row < total_rows);
+	return *this;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "strategy: " << table.GetStrategy()
+		<< ", value: " << table.GetValue()
+		)
+}
+
+inline
+Table Session::InternalMakeTableChunk(
+	const picojson::value& columns_data,
+	const std::vector<TableColumn>& columns,
+	size_t first_row,
+	size_t row_count
+	) const {
+	WEBDRIVERXX_CHECK(columns_data.is<picojson::array>() &&
+		columns_data.get<picojson::array>().size() == columns.size(),
+		"Script returned wrong number of columns");
+	Table result;
+	result.first_row = first_row;
+	result.row_count = row_count;
+	result.values.resize(columns.size());
+	result.elements.resize(columns.size());
+	for (size_t i = 0; i < columns.size(); ++i) {
+		const picojson::value& cells = columns_data.get(i);
+		WEBDRIVERXX_CHECK(cells.is<picojson::array>() &&
+			cells.get<picojson::array>().size() == row_count,
+			"Script returned wrong number of rows");
+		if (columns[i].kind != TableColumn::CellElement) {
+			result.values[i] = FromJson<std::vector<std::string>>(cells);
+			continue;
+		}
+		result.elements[i].reserve(row_count);
+		for (const auto& cell : cells.get<picojson::array>())
+			result.elements[i].push_back(cell.is<picojson::null>() ? Element() :
+				factory_->MakeElement(FromJson<detail::ElementRef>(cell).ref));
+	}
+	return result;
+}
+
 inline
 std::vector<Cookie> Session::GetCookies() const {
 	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
@@ -252,30 +527,35 @@ std::string Session::GetAlertText() const {
 
 inline
 const Session& Session::SendKeysToAlert(const std::string& text) const {
+	focus_->ForgetNestedFrame(); // The page may react by loading another one
 	resource_->Post("alert_text", "text", text);
 	return *this;
 }
 
 inline
 const Session& Session::AcceptAlert() const {
+	focus_->ForgetNestedFrame();
 	resource_->Post("accept_alert");
 	return *this;
 }
 
 inline
 const Session& Session::DismissAlert() const {
+	focus_->ForgetNestedFrame();
 	resource_->Post("dismiss_alert");
 	return *this;
 }
 
 inline
 const Session& Session::SendKeys(const std::string& keys) const {
+	focus_->ForgetNestedFrame();
 	GetKeyboard().SendKeys(keys);
 	return *this;
 }
 
 inline
 const Session& Session::SendKeys(const Shortcut& shortcut) const {
+	focus_->ForgetNestedFrame();
 	GetKeyboard().SendKeys(shortcut);
 	return *this;
 }
@@ -295,6 +575,27 @@ const Session& Session::MoveTo(const Offset& offset) const {
 	return InternalMoveTo(nullptr, &offset);
 }
 
+inline
+const Session& Session::MoveToPoint(const Point& point) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	const picojson::value target = InternalEvalJsonValue("execute",
+		"var x = arguments[0], y = arguments[1], e = document.elementFromPoint(x, y);"
+		"if (!e) return null;"
+		"var r = e.getBoundingClientRect();"
+		"return [e, Math.floor(x - r.left), Math.floor(y - r.top)];",
+		JsArgs() << point.x << point.y);
+	WEBDRIVERXX_CHECK(target.is<picojson::array>() && target.get<picojson::array>().size() == 3,
+		"No element at the point");
+	const picojson::array& items = target.get<picojson::array>();
+	const Element element = factory_->MakeElement(FromJson<detail::ElementRef>(items[0]).ref);
+	const Offset offset(FromJson<int>(items[1]), FromJson<int>(items[2]));
+	return InternalMoveTo(&element, &offset);
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "x: " << point.x
+		<< ", y: " << point.y
+		)
+}
+
 inline
 const Session& Session::InternalMoveTo(
 	const Element* element,
@@ -318,6 +619,7 @@ const Session& Session::Click(mouse::Button button) const {
 
 inline
 const Session& Session::DoubleClick() const {
+	focus_->ForgetNestedFrame();
 	resource_->Post("doubleclick");
 	return *this;
 }
@@ -334,6 +636,7 @@ const Session& Session::ButtonUp(mouse::Button button) const {
 
 inline
 const Session& Session::InternalMouseButtonCommand(const char* command, mouse::Button button) const {
+	focus_->ForgetNestedFrame();
 	resource_->Post(command, "button", static_cast<int>(button));
 	return *this;
 }
@@ -0,0 +1,230 @@
+#ifndef WEBDRIVERXX_SESSION_REAPER_H
+#define WEBDRIVERXX_SESSION_REAPER_H
+
+#include "cancellation.h"
+#include "types.h"
+#include "detail/error_handling.h"
+#include "detail/http_client.h"
+#include "detail/shared.h"
+#include "detail/thread_pool.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace webdriverxx {
+
+struct ReaperOptions {
+	size_t concurrency; // Deletions in flight at once
+	unsigned max_attempts;
+	Duration attempt_timeout_ms;
+	Duration backoff_ms; // Before the first retry, doubles for every next one
+	// How long the destructor waits for queued deletions.
+	// Deletions that are not done by then are cancelled.
+	Duration flush_timeout_ms;
+
+	ReaperOptions()
+		: concurrency(4)
+		, max_attempts(3)
+		, attempt_timeout_ms(30000)
+		, backoff_ms(500)
+		, flush_timeout_ms(60000)
+	{}
+
+	ReaperOptions& SetConcurrency(size_t value) {
+		concurrency = value;
+		return *this;
+	}
+
+	ReaperOptions& SetMaxAttempts(unsigned value) {
+		max_attempts = value;
+		return *this;
+	}
+
+	ReaperOptions& SetAttemptTimeoutMs(Duration value) {
+		attempt_timeout_ms = value;
+		return *this;
+	}
+
+	ReaperOptions& SetBackoffMs(Duration value) {
+		backoff_ms = value;
+		return *this;
+	}
+
+	ReaperOptions& SetFlushTimeoutMs(Duration value) {
+		flush_timeout_ms = value;
+		return *this;
+	}
+};
+
+struct ReaperReport {
+	unsigned long long queued;
+	unsigned long long deleted; // Including sessions the server no longer knew
+	unsigned long long failed; // Every attempt got an error
+	unsigned long long timed_out; // The last attempt timed out or was cancelled by the destructor
+	unsigned long long pending;
+
+	ReaperReport()
+		: queued(0)
+		, deleted(0)
+		, failed(0)
+		, timed_out(0)
+		, pending(0)
+	{}
+
+	// Sessions that may still be running on the server.
+	unsigned long long GetLeaked() const {
+		return failed + timed_out;
+	}
+};
+
+// Deletes sessions on worker threads, so destroying the last copy of
+// a session doesn't wait for the browser to shut down. Attach it to
+// a Client with Client::SetSessionReaper. Failed deletions are retried.
+// The destructor waits for queued deletions (see ReaperOptions), so keep
+// the reaper alive until the end of main() to flush it on exit.
+class SessionReaper : public detail::SharedObjectBase { // noncopyable
+public:
+	typedef std::function<void(const ReaperReport&)> ReportHandler;
+
+	explicit SessionReaper(const ReaperOptions& options = ReaperOptions())
+		: options_(options)
+		, state_(std::make_shared<State>())
+		, pool_(new detail::ThreadPool(options.concurrency))
+	{
+		WEBDRIVERXX_CHECK(options_.max_attempts > 0, "Reaper should make at least one attempt");
+	}
+
+	~SessionReaper() {
+		if (!Flush(options_.flush_timeout_ms)) {
+			{
+				std::lock_guard<std::mutex> lock(state_->mutex);
+				state_->shutdown.Cancel();
+			}
+			state_->done.notify_all(); // Wakes up backoffs
+		}
+		pool_.reset(); // Waits for cancelled deletions
+		if (report_handler_) {
+			try {
+				report_handler_(GetReport());
+			} catch (const std::exception&) {}
+		}
+	}
+
+	// Called from the destructor with the final report.
+	void SetReportHandler(const ReportHandler& handler) {
+		report_handler_ = handler;
+	}
+
+	// Sends DELETE to the URL in background.
+	void Queue(const detail::Shared<detail::IHttpClient>& http_client, const std::string& url) {
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			++state_->report.queued;
+			++state_->report.pending;
+		}
+		const std::shared_ptr<State> state = state_;
+		const ReaperOptions options = options_;
+		pool_->Post([state, options, http_client, url]{
+			Reap(*state, options, *http_client, url);
+		});
+	}
+
+	// Waits for queued deletions. Returns false if some are still pending.
+	bool Flush(Duration timeout_ms) const {
+		std::unique_lock<std::mutex> lock(state_->mutex);
+		return state_->done.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+			[this]{ return state_->report.pending == 0; });
+	}
+
+	ReaperReport GetReport() const {
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		return state_->report;
+	}
+
+private:
+	// Owned by queued tasks too.
+	struct State {
+		std::mutex mutex;
+		std::condition_variable done;
+		ReaperReport report;
+		const CancellationToken shutdown;
+
+		State() : shutdown(CancellationToken::MakeCancellable()) {}
+	};
+
+	enum Outcome { Deleted, Failed, TimedOut };
+
+	static
+	void Reap(
+		State& state,
+		const ReaperOptions& options,
+		const detail::IHttpClient& http_client,
+		const std::string& url
+		) {
+		Outcome outcome = Failed;
+		Duration backoff_ms = options.backoff_ms;
+		for (unsigned attempt = 1; attempt <= options.max_attempts; ++attempt) {
+			if (attempt > 1) {
+				std::unique_lock<std::mutex> lock(state.mutex);
+				state.done.wait_for(lock, std::chrono::milliseconds(backoff_ms),
+					[&state]{ return state.shutdown.IsCancelled(); });
+				backoff_ms *= 2;
+			}
+			if (state.shutdown.IsCancelled()) {
+				outcome = TimedOut;
+				break;
+			}
+			outcome = Attempt(state, options, http_client, url);
+			if (outcome == Deleted)
+				break;
+		}
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			switch (outcome) {
+			case Deleted: ++state.report.deleted; break;
+			case Failed: ++state.report.failed; break;
+			case TimedOut: ++state.report.timed_out; break;
+			}
+			--state.report.pending;
+		}
+		state.done.notify_all();
+	}
+
+	static
+	Outcome Attempt(
+		const State& state,
+		const ReaperOptions& options,
+		const detail::IHttpClient& http_client,
+		const std::string& url
+		) {
+		CancellationContext cancellation;
+		cancellation.Add(state.shutdown);
+		cancellation.Add(CancellationToken::WithTimeoutMs(options.attempt_timeout_ms));
+		try {
+			const CancellationScope scope(cancellation);
+			const int http_code = http_client.Delete(url).http_code;
+			// 404 means the session is already gone
+			return http_code == 200 || http_code == 404 ? Deleted : Failed;
+		} catch (const std::exception&) {
+			return cancellation.IsCancelled() ? TimedOut : Failed;
+		}
+	}
+
+	SessionReaper(SessionReaper&);
+	SessionReaper& operator = (SessionReaper&);
+
+private:
+	const ReaperOptions options_;
+	const std::shared_ptr<State> state_;
+	ReportHandler report_handler_;
+	std::unique_ptr<detail::ThreadPool> pool_;
+};
+
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef WEBDRIVERXX_SESSION_REGISTRY_H
+#define WEBDRIVERXX_SESSION_REGISTRY_H
+
+#include "client.h"
+#include "session.h"
+#include "capabilities.h"
+#include "detail/error_handling.h"
+#include "detail/time.h"
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace webdriverxx {
+
+const Duration kDefaultSessionRegistryLockTimeoutMs = 5000;
+
+namespace detail {
+
+// Cross-process lock taken on a file with flock() (LockFileEx() on Windows).
+// The OS drops the lock when its holder exits, so a crashed process can't
+// leave the registry locked; the file itself stays in place.
+class RegistryFileLock { // noncopyable
+public:
+	RegistryFileLock(const std::string& path, Duration timeout_ms)
+		: path_(path)
+	{
+		Open();
+		const TimePoint deadline = Now() + timeout_ms;
+		while (!TryLock()) {
+			if (Now() >= deadline) {
+				Close();
+				WEBDRIVERXX_THROW(Fmt() << "Cannot lock session registry (lock: " << path_ << ")");
+			}
+			Sleep(10);
+		}
+	}
+
+	~RegistryFileLock() {
+	#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		::UnlockFileEx(file_, 0, 1, 0, &overlapped);
+	#else
+		::flock(file_, LOCK_UN);
+	#endif
+		Close();
+	}
+
+private:
+	void Open() {
+	#ifdef _WIN32
+		file_ = ::CreateFileA(path_.c_str(), GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+			OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		WEBDRIVERXX_CHECK(file_ != INVALID_HANDLE_VALUE,
+			Fmt() << "Cannot open lock file (path: " << path_ << ")");
+	#else
+		file_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0666);
+		WEBDRIVERXX_CHECK(file_ >= 0, Fmt() << "Cannot open lock file (path: " << path_ << ")");
+	#endif
+	}
+
+	bool TryLock() const {
+	#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		return ::LockFileEx(file_, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY,
+			0, 1, 0, &overlapped) != FALSE;
+	#else
+		// flock() locks belong to the open file, so threads of one process
+		// exclude each other too (unlike fcntl() locks)
+		return ::flock(file_, LOCK_EX | LOCK_NB) == 0;
+	#endif
+	}
+
+	void Close() {
+	#ifdef _WIN32
+		::CloseHandle(file_);
+	#else
+		::close(file_);
+	#endif
+	}
+
+	RegistryFileLock(RegistryFileLock&);
+	RegistryFileLock& operator = (RegistryFileLock&);
+
+private:
+	const std::string path_;
+#ifdef _WIN32
+	HANDLE file_;
+#else
+	int file_;
+#endif
+};
+
+} // namespace detail
+
+// Keeps IDs of idle persistent sessions in a text file, one "key<TAB>id"
+// line per session, so short-lived processes can reuse browsers started
+// by earlier ones instead of starting new ones. A session is used by one
+// process at a time: Acquire removes it from the file, Release puts it back.
+class SessionRegistry { // noncopyable
+public:
+	explicit SessionRegistry(
+		const std::string& path,
+		Duration lock_timeout_ms = kDefaultSessionRegistryLockTimeoutMs
+		)
+		: path_(path)
+		, lock_timeout_ms_(lock_timeout_ms)
+	{}
+
+	// Returns an idle session recorded under the key that is still alive,
+	// or creates a persistent one. Entries of dead sessions are dropped.
+	Session Acquire(
+		const Client& client,
+		const std::string& key,
+		const Capabilities& desired,
+		const Capabilities& required = Capabilities()
+		) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		CheckKey(key);
+		std::string id;
+		while (TakeIdle(key, id)) {
+			const Session session = client.AttachSession(id);
+			if (IsAlive(session))
+				return session;
+		}
+		return client.CreatePersistentSession(desired, required);
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "registry: " << path_
+			<< ", key: " << key
+			)
+	}
+
+	// Records the session as idle for later Acquire calls.
+	void Release(const std::string& key, const Session& session) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		CheckKey(key);
+		const detail::RegistryFileLock lock(GetLockPath(), lock_timeout_ms_);
+		Entries entries = Read();
+		entries.push_back(Entry(key, session.GetId()));
+		Write(entries);
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "registry: " << path_
+			<< ", key: " << key
+			)
+	}
+
+	std::vector<std::string> GetIdleSessionIds(const std::string& key) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		const detail::RegistryFileLock lock(GetLockPath(), lock_timeout_ms_);
+		std::vector<std::string> result;
+		for (const auto& entry : Read())
+			if (entry.first == key)
+				result.push_back(entry.second);
+		return result;
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "registry: " << path_
+			<< ", key: " << key
+			)
+	}
+
+	// Deletes idle sessions of the key on the server and forgets them.
+	void DeleteIdleSessions(const Client& client, const std::string& key) const {
+		WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+		std::string id;
+		while (TakeIdle(key, id)) {
+			try {
+				client.AttachSession(id).DeleteSession();
+			} catch (const std::exception&) {} // Already gone
+		}
+		WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+			<< "registry: " << path_
+			<< ", key: " << key
+			)
+	}
+
+private:
+	typedef std::pair<std::string, std::string> Entry; // key, session ID
+	typedef std::vector<Entry> Entries;
+
+	static
+	void CheckKey(const std::string& key) {
+		WEBDRIVERXX_CHECK(!key.empty() && key.find_first_of("\t\r\n") == std::string::npos,
+			"Registry key should be a non-empty string without tabs and line breaks");
+	}
+
+	static
+	bool IsAlive(const Session& session) {
+		try {
+			session.GetUrl();
+			return true;
+		} catch (const std::exception&) {
+			return false;
+		}
+	}
+
+	bool TakeIdle(const std::string& key, std::string& id) const {
+		const detail::RegistryFileLock lock(GetLockPath(), lock_timeout_ms_);
+		Entries entries = Read();
+		for (auto it = entries.begin(); it != entries.end(); ++it) {
+			if (it->first == key) {
+				id = it->second;
+				entries.erase(it);
+				Write(entries);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string GetLockPath() const {
+		return path_ + ".lock";
+	}
+
+	Entries Read() const {
+		Entries result;
+		std::ifstream file(path_.c_str());
+		std::string line;
+		while (std::getline(file, line)) {
+			const size_t tab = line.find('\t');
+			if (tab != std::string::npos && tab > 0 && tab + 1 < line.size())
+				result.push_back(Entry(line.substr(0, tab), line.substr(tab + 1)));
+		}
+		return result;
+	}
+
+	// Writes a temporary file first, so a crash can't leave a truncated registry.
+	void Write(const Entries& entries) const {
+		const std::string temp_path = path_ + ".tmp";
+		{
+			std::ofstream file(temp_path.c_str(), std::ios::trunc);
+			for (const auto& entry : entries)
+				file << entry.first << '\t' << entry.second << '\n';
+			file.close();
+			WEBDRIVERXX_CHECK(!file.fail(), detail::Fmt() << "Cannot write file (path: " << temp_path << ")");
+		}
+	#ifdef _WIN32
+		std::remove(path_.c_str()); // rename() doesn't replace files on Windows
+	#endif
+		WEBDRIVERXX_CHECK(std::rename(temp_path.c_str(), path_.c_str()) == 0,
+			detail::Fmt() << "Cannot replace file (path: " << path_ << ")");
+	}
+
+	SessionRegistry(SessionRegistry&);
+	SessionRegistry& operator = (SessionRegistry&);
+
+private:
+	const std::string path_;
+	const Duration lock_timeout_ms_;
+};
+
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef WEBDRIVERXX_SESSION_STATE_H
+#define WEBDRIVERXX_SESSION_STATE_H
+
+#include "session.h"
+#include "types.h"
+#include "conversions.h"
+#include "detail/error_handling.h"
+#include <picojson.h>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+// Logged-in state of a site: cookies and web storage of one origin.
+struct SessionState {
+	std::string origin; // Of the page the storage was taken from
+	std::vector<Cookie> cookies;
+	std::map<std::string, std::string> local_storage;
+	std::map<std::string, std::string> session_storage;
+
+	bool operator == (const SessionState& s) const {
+		return origin == s.origin
+			&& cookies == s.cookies
+			&& local_storage == s.local_storage
+			&& session_storage == s.session_storage
+			;
+	}
+};
+
+namespace detail {
+
+const char *const kExportStateScript =
+	"function dump(name) {"
+		"var result = {};"
+		"try {"
+			"var storage = window[name];"
+			"for (var i = 0; i < storage.length; ++i) {"
+				"var key = storage.key(i);"
+				"result[key] = storage.getItem(key);"
+			"}"
+		"} catch (e) {}" // Storage is unavailable on some pages
+		"return result;"
+	"}"
+	"return {"
+		"origin: location.origin,"
+		"local: dump('localStorage'),"
+		"session: dump('sessionStorage')"
+	"};"
+	;
+
+// Takes the origin, local and session storage objects and cookies as
+// [name, value, path, domain, secure, http_only, expiry] arrays. Sets
+// the cookies document.cookie can set, returns indices of the rest
+// or null if the page is of another origin.
+const char *const kImportStateScript =
+	"var origin = arguments[0], local = arguments[1], session = arguments[2], cookies = arguments[3];"
+	"if (location.origin !== origin && (Object.keys(local).length || Object.keys(session).length))"
+		"return null;"
+	"for (var key in local) localStorage.setItem(key, local[key]);"
+	"for (var key in session) sessionStorage.setItem(key, session[key]);"
+	"var host = location.hostname, rest = [];"
+	"for (var i = 0; i < cookies.length; ++i) {"
+		"var c = cookies[i], domain = c[3];"
+		"var host_only = !domain || domain === host;"
+		"var matches = host_only || (domain.charAt(0) === '.' &&"
+			"('.' + host).slice(-domain.length) === domain);"
+		"if (c[5] || (c[4] && location.protocol !== 'https:') || !matches) {"
+			"rest.push(i);"
+			"continue;"
+		"}"
+		"document.cookie = c[0] + '=' + c[1]"
+			"+ '; path=' + (c[2] || '/')"
+			"+ (host_only ? '' : '; domain=' + domain)"
+			"+ (c[6] ? '; expires=' + new Date(c[6] * 1000).toUTCString() : '')"
+			"+ (c[4] ? '; secure' : '');"
+	"}"
+	"return rest;"
+	;
+
+inline
+picojson::value StorageToJson(const std::map<std::string, std::string>& storage) {
+	picojson::object result;
+	for (const auto& item : storage)
+		result[item.first] = picojson::value(item.second);
+	return picojson::value(result);
+}
+
+inline
+std::map<std::string, std::string> StorageFromJson(const picojson::value& value) {
+	WEBDRIVERXX_CHECK(value.is<picojson::object>(), "Storage is not an object");
+	std::map<std::string, std::string> result;
+	for (const auto& item : value.get<picojson::object>())
+		result[item.first] = FromJson<std::string>(item.second);
+	return result;
+}
+
+const char kSessionStateMagic[] = { 'W', 'D', 'X', 'S' };
+const unsigned kSessionStateVersion = 1;
+
+class SessionStateWriter { // noncopyable
+public:
+	explicit SessionStateWriter(std::string& out) : out_(out) {}
+
+	void Write(unsigned value) {
+		for (int i = 0; i < 4; ++i)
+			out_ += static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+
+	void Write(const std::string& value) {
+		Write(static_cast<unsigned>(value.size()));
+		out_ += value;
+	}
+
+	void Write(const std::map<std::string, std::string>& values) {
+		Write(static_cast<unsigned>(values.size()));
+		for (const auto& value : values) {
+			Write(value.first);
+			Write(value.second);
+		}
+	}
+
+private:
+	SessionStateWriter(SessionStateWriter&);
+	SessionStateWriter& operator = (SessionStateWriter&);
+
+private:
+	std::string& out_;
+};
+
+// Checks every read against the size of the data, so
+// a damaged file can't cause huge allocations.
+class SessionStateReader { // noncopyable
+public:
+	explicit SessionStateReader(const std::string& data)
+		: data_(data)
+		, position_(0)
+	{}
+
+	unsigned ReadUnsigned() {
+		Require(4);
+		unsigned result = 0;
+		for (int i = 0; i < 4; ++i)
+			result |= static_cast<unsigned>(static_cast<unsigned char>(data_[position_++])) << (8 * i);
+		return result;
+	}
+
+	std::string ReadString() {
+		const unsigned size = ReadUnsigned();
+		Require(size);
+		const std::string result = data_.substr(position_, size);
+		position_ += size;
+		return result;
+	}
+
+	std::map<std::string, std::string> ReadMap() {
+		std::map<std::string, std::string> result;
+		for (unsigned count = ReadUnsigned(); count; --count) {
+			const std::string key = ReadString();
+			result[key] = ReadString();
+		}
+		return result;
+	}
+
+	bool IsAtEnd() const {
+		return position_ == data_.size();
+	}
+
+private:
+	void Require(size_t size) const {
+		WEBDRIVERXX_CHECK(data_.size() - position_ >= size, "Session state is truncated");
+	}
+
+	SessionStateReader(SessionStateReader&);
+	SessionStateReader& operator = (SessionStateReader&);
+
+private:
+	const std::string& data_;
+	size_t position_;
+};
+
+} // namespace detail
+
+// Compact binary form: a magic, a version, then the origin, cookies and
+// both storages as little-endian 32-bit counts and length-prefixed strings.
+inline
+std::string SerializeSessionState(const SessionState& state) {
+	std::string result(detail::kSessionStateMagic, sizeof(detail::kSessionStateMagic));
+	detail::SessionStateWriter writer(result);
+	writer.Write(detail::kSessionStateVersion);
+	writer.Write(state.origin);
+	writer.Write(static_cast<unsigned>(state.cookies.size()));
+	for (const auto& cookie : state.cookies) {
+		writer.Write(cookie.name);
+		writer.Write(cookie.value);
+		writer.Write(cookie.path);
+		writer.Write(cookie.domain);
+		writer.Write((cookie.secure ? 1u : 0u) | (cookie.http_only ? 2u : 0u));
+		writer.Write(static_cast<unsigned>(cookie.expiry));
+	}
+	writer.Write(state.local_storage);
+	writer.Write(state.session_storage);
+	return result;
+}
+
+inline
+SessionState ParseSessionState(const std::string& data) {
+	const size_t magic_size = sizeof(detail::kSessionStateMagic);
+	WEBDRIVERXX_CHECK(data.compare(0, magic_size, detail::kSessionStateMagic, magic_size) == 0,
+		"Data is not a session state");
+	const std::string body = data.substr(magic_size);
+	detail::SessionStateReader reader(body);
+	const unsigned version = reader.ReadUnsigned();
+	WEBDRIVERXX_CHECK(version == detail::kSessionStateVersion, detail::Fmt()
+		<< "Unsupported session state version (" << version << ")");
+	SessionState result;
+	result.origin = reader.ReadString();
+	for (unsigned count = reader.ReadUnsigned(); count; --count) {
+		Cookie cookie;
+		cookie.name = reader.ReadString();
+		cookie.value = reader.ReadString();
+		cookie.path = reader.ReadString();
+		cookie.domain = reader.ReadString();
+		const unsigned flags = reader.ReadUnsigned();
+		cookie.secure = (flags & 1) != 0;
+		cookie.http_only = (flags & 2) != 0;
+		cookie.expiry = static_cast<int>(reader.ReadUnsigned());
+		result.cookies.push_back(cookie);
+	}
+	result.local_storage = reader.ReadMap();
+	result.session_storage = reader.ReadMap();
+	WEBDRIVERXX_CHECK(reader.IsAtEnd(), "Session state has trailing data");
+	return result;
+}
+
+inline
+void SaveSessionState(const SessionState& state, const std::string& path) {
+	const std::string data = SerializeSessionState(state);
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	WEBDRIVERXX_CHECK(file.is_open(), detail::Fmt() << "Cannot create file (path: " << path << ")");
+	file.write(data.data(), static_cast<std::streamsize>(data.size()));
+	file.close();
+	WEBDRIVERXX_CHECK(!file.fail(), detail::Fmt() << "Cannot write file (path: " << path << ")");
+}
+
+inline
+SessionState LoadSessionState(const std::string& path) {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	std::ifstream file(path.c_str(), std::ios::binary);
+	WEBDRIVERXX_CHECK(file.is_open(), "Cannot open file");
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	WEBDRIVERXX_CHECK(!file.bad(), "Cannot read file");
+	return ParseSessionState(data);
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "path: " << path
+		)
+}
+
+} // namespace webdriverxx
+
+#include "session_state.inl"
+
+#endif
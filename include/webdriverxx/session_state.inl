@@ -0,0 +1,55 @@
+#include "conversions.h"
+#include "detail/error_handling.h"
+
+namespace webdriverxx {
+
+inline
+SessionState Session::ExportState() const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	SessionState result;
+	result.cookies = GetCookies();
+	const picojson::value storage = InternalEvalJsonValue("execute",
+		detail::kExportStateScript, JsArgs());
+	WEBDRIVERXX_CHECK(storage.is<picojson::object>(), "Storage is not an object");
+	result.origin = FromJson<std::string>(storage.get("origin"));
+	result.local_storage = detail::StorageFromJson(storage.get("local"));
+	result.session_storage = detail::StorageFromJson(storage.get("session"));
+	return result;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END()
+}
+
+inline
+const Session& Session::ImportState(const SessionState& state) const {
+	WEBDRIVERXX_FUNCTION_CONTEXT_BEGIN()
+	picojson::array cookies;
+	for (const auto& cookie : state.cookies) {
+		picojson::array spec;
+		spec.push_back(ToJson(cookie.name));
+		spec.push_back(ToJson(cookie.value));
+		spec.push_back(ToJson(cookie.path));
+		spec.push_back(ToJson(cookie.domain));
+		spec.push_back(ToJson(cookie.secure));
+		spec.push_back(ToJson(cookie.http_only));
+		spec.push_back(ToJson(cookie.expiry));
+		cookies.push_back(picojson::value(spec));
+	}
+	const picojson::value rest = InternalEvalJsonValue("execute",
+		detail::kImportStateScript,
+		JsArgs()
+			<< state.origin
+			<< detail::StorageToJson(state.local_storage)
+			<< detail::StorageToJson(state.session_storage)
+			<< picojson::value(cookies)
+		);
+	WEBDRIVERXX_CHECK(!rest.is<picojson::null>(), "Page is of another origin, navigate to it first");
+	for (const unsigned index : FromJson<std::vector<unsigned>>(rest)) {
+		WEBDRIVERXX_CHECK(index < state.cookies.size(), "Cookie index is out of range");
+		SetCookie(state.cookies[index]);
+	}
+	return *this;
+	WEBDRIVERXX_FUNCTION_CONTEXT_END_EX(detail::Fmt()
+		<< "origin: " << state.origin
+		)
+}
+
+} // namespace webdriverxx
@@ -0,0 +1,89 @@
+#ifndef WEBDRIVERXX_TABLE_H
+#define WEBDRIVERXX_TABLE_H
+
+#include "element.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace webdriverxx {
+
+// What Session::ExtractTable takes from a cell of every row.
+struct TableColumn {
+	enum Kind {
+		Text,
+		Attribute,
+		CellElement
+	};
+
+	Kind kind;
+	size_t cell; // Index of the cell (td or th) in a row
+	std::string attribute;
+
+	TableColumn(Kind kind, size_t cell, const std::string& attribute = std::string())
+		: kind(kind)
+		, cell(cell)
+		, attribute(attribute)
+	{}
+};
+
+inline TableColumn CellText(size_t cell) {
+	return TableColumn(TableColumn::Text, cell);
+}
+
+inline TableColumn CellAttribute(size_t cell, const std::string& name) {
+	return TableColumn(TableColumn::Attribute, cell, name);
+}
+
+inline TableColumn CellElement(size_t cell) {
+	return TableColumn(TableColumn::CellElement, cell);
+}
+
+// Rows of a table stored by columns, in the order of requested columns.
+// Text and attribute columns fill values, element columns fill elements,
+// the other vector of a column stays empty. Missing cells give empty
+// strings and default constructed elements.
+struct Table {
+	size_t first_row; // Index of the first row in the whole table
+	size_t row_count;
+	std::vector<std::vector<std::string>> values;
+	std::vector<std::vector<Element>> elements;
+
+	Table() : first_row(0), row_count(0) {}
+};
+
+typedef std::function<void(const Table& chunk)> TableChunkHandler;
+
+namespace detail {
+
+// Takes a table (or thead/tbody/tfoot) element, an array of
+// [kind, cell, attribute] columns, the first row and the number of rows.
+const char *const kExtractTableScript =
+	"var rows = arguments[0].rows, columns = arguments[1];"
+	"var first = arguments[2], end = Math.min(rows.length, first + arguments[3]);"
+	"var result = columns.map(function() { return []; });"
+	"for (var i = first; i < end; ++i) {"
+		"var cells = rows[i].cells;"
+		"for (var j = 0; j < columns.length; ++j) {"
+			"var cell = cells[columns[j][1]];"
+			"switch (columns[j][0]) {"
+			"case 0:"
+				"var text = cell ? (cell.innerText !== undefined ? cell.innerText : cell.textContent) : '';"
+				"result[j].push((text || '').trim());"
+				"break;"
+			"case 1:"
+				"result[j].push(cell && cell.getAttribute(columns[j][2]) || '');"
+				"break;"
+			"default:"
+				"result[j].push(cell || null);"
+			"}"
+		"}"
+	"}"
+	"return { total: rows.length, columns: result };"
+	;
+
+} // namespace detail
+} // namespace webdriverxx
+
+#endif
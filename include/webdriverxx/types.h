@@ -23,6 +23,15 @@ struct Point {
 
 typedef Point Offset;
 
+struct Rect {
+	int x;
+	int y;
+	int width;
+	int height;
+	Rect() : x(0), y(0), width(0), height(0) {}
+	Rect(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+};
+
 struct Cookie {
 	enum {
 		NoExpiry = 0
@@ -1,6 +1,7 @@
 #ifndef WEBDRIVERXX_WAIT_H
 #define WEBDRIVERXX_WAIT_H
 
+#include "cancellation.h"
 #include "detail/error_handling.h"
 #include "detail/time.h"
 #include "detail/to_string.h"
@@ -10,6 +11,7 @@
 namespace webdriverxx {
 namespace detail {
 
+// Stops when cancelled, see CancellationScope.
 template<typename Value, typename DescriptiveGetter>
 Value Wait(
 	DescriptiveGetter getter,
@@ -17,7 +19,9 @@ Value Wait(
 	Duration intervalMs = 50
 	) {
 	const TimePoint timeout = detail::Now() + timeoutMs;
+	const CancellationContext cancellation = CancellationContext::Capture();
 	for (;;) {
+		cancellation.ThrowIfCancelled();
 		const auto value_ptr = getter(nullptr);
 		if (value_ptr)
 			return *value_ptr;
@@ -31,7 +35,7 @@ Value Wait(
 				<< description
 				);
 		}
-		detail::Sleep(intervalMs);
+		detail::Sleep(LimitToDeadline(intervalMs, cancellation.GetDeadline()));
 	}
 }
 
@@ -0,0 +1,260 @@
+#ifndef WEBDRIVERXX_WAIT_ENGINE_H
+#define WEBDRIVERXX_WAIT_ENGINE_H
+
+#include "wait.h"
+#include "wait_match.h"
+#include "types.h"
+#include "cancellation.h"
+#include "detail/error_handling.h"
+#include "detail/shared.h"
+#include "detail/time.h"
+#include "detail/timer_wheel.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+namespace webdriverxx {
+namespace detail {
+
+template<typename Value>
+class PendingWaitState { // noncopyable
+public:
+	typedef std::function<std::unique_ptr<Value>(std::string*)> DescriptiveGetter;
+
+	PendingWaitState(
+		const Shared<TimerWheel>& timers,
+		const DescriptiveGetter& getter,
+		Duration timeoutMs,
+		Duration intervalMs
+		)
+		: timers_(timers)
+		, getter_(getter)
+		, timeout_ms_(timeoutMs)
+		, interval_ms_(intervalMs)
+		, deadline_(Now() + timeoutMs)
+		, cancellation_(CancellationContext::Capture())
+		, timer_id_(0)
+		, done_(false)
+		, future_(promise_.get_future().share())
+	{}
+
+	static
+	void Start(const std::shared_ptr<PendingWaitState>& self) {
+		std::lock_guard<std::mutex> lock(self->mutex_);
+		self->ScheduleAttempt(self, 0);
+	}
+
+	bool Cancel() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (done_)
+				return false;
+			done_ = true;
+			timers_->Cancel(timer_id_);
+		}
+		promise_.set_exception(std::make_exception_ptr(
+			WebDriverException("Wait cancelled")));
+		return true;
+	}
+
+	const std::shared_future<Value>& GetFuture() const {
+		return future_;
+	}
+
+private:
+	// Called under the lock
+	void ScheduleAttempt(const std::shared_ptr<PendingWaitState>& self, Duration delay) {
+		timer_id_ = timers_->Schedule(delay, [self]{ self->Attempt(self); });
+	}
+
+	// Called from the timer thread, getter is called without the lock
+	// so waits can be cancelled while an attempt is in progress.
+	void Attempt(const std::shared_ptr<PendingWaitState>& self) {
+		if (IsDone())
+			return;
+		const CancellationScope scope(cancellation_);
+		if (cancellation_.IsCancelled())
+			return Fail(std::make_exception_ptr(WebDriverException("Wait cancelled")));
+		auto value_ptr = getter_(nullptr);
+		if (value_ptr)
+			return Finish(std::move(value_ptr));
+		if (Now() >= deadline_) {
+			std::string description;
+			value_ptr = getter_(&description);
+			if (value_ptr)
+				return Finish(std::move(value_ptr));
+			return Fail(std::make_exception_ptr(WebDriverException(Fmt()
+				<< "Timeout after " << timeout_ms_ << "ms of waiting, last attempt returned: "
+				<< description
+				)));
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!done_)
+			ScheduleAttempt(self, interval_ms_);
+	}
+
+	bool IsDone() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return done_;
+	}
+
+	bool MarkDone() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (done_)
+			return false;
+		done_ = true;
+		return true;
+	}
+
+	void Finish(std::unique_ptr<Value> value_ptr) {
+		if (MarkDone())
+			promise_.set_value(std::move(*value_ptr));
+	}
+
+	void Fail(std::exception_ptr error) {
+		if (MarkDone())
+			promise_.set_exception(error);
+	}
+
+private:
+	const Shared<TimerWheel> timers_;
+	const DescriptiveGetter getter_;
+	const Duration timeout_ms_;
+	const Duration interval_ms_;
+	const TimePoint deadline_;
+	const CancellationContext cancellation_;
+	std::mutex mutex_;
+	TimerWheel::TimerId timer_id_;
+	bool done_;
+	std::promise<Value> promise_;
+	const std::shared_future<Value> future_;
+};
+
+} // namespace detail
+
+// A wait that is in progress. Waiting for its result
+// doesn't affect the wait itself, it can be done from any thread.
+template<typename Value>
+class PendingWait { // copyable
+public:
+	explicit PendingWait(const std::shared_ptr<detail::PendingWaitState<Value>>& state)
+		: state_(state)
+	{}
+
+	// Blocks until the wait is finished. Returns the value or
+	// throws exception on timeout or cancellation.
+	Value Get() const {
+		return state_->GetFuture().get();
+	}
+
+	const std::shared_future<Value>& GetFuture() const {
+		return state_->GetFuture();
+	}
+
+	bool IsDone() const {
+		return state_->GetFuture().wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	// Stops the wait, Get() throws WebDriverException after that.
+	// Returns false if the wait has already finished.
+	bool Cancel() const {
+		return state_->Cancel();
+	}
+
+private:
+	std::shared_ptr<detail::PendingWaitState<Value>> state_;
+};
+
+// Services any number of pending waits from a single background
+// thread that sleeps on a timer wheel between attempts, instead of
+// blocking a thread per wait. Getters and matchers are copied and
+// called from that thread, so they should be quick and thread safe.
+// Waits inherit the caller's CancellationScope.
+// Pending waits keep the engine alive until they finish.
+class WaitEngine { // copyable
+public:
+	explicit WaitEngine(Duration tickMs = detail::kDefaultTimerTickMs)
+		: timers_(new detail::TimerWheel(tickMs))
+	{}
+
+	// Counterparts of WaitForValue, WaitUntil and WaitForMatch.
+
+	template<typename Getter>
+	auto WaitForValue(
+		Getter getter,
+		Duration timeoutMs = 5000,
+		Duration intervalMs = 50
+		) const -> PendingWait<decltype(getter())> {
+		typedef decltype(getter()) Value;
+		return Start<Value>([getter](std::string* description) {
+				return detail::TryToCallGetter<Value>(getter, description);
+			}, timeoutMs, intervalMs);
+	}
+
+	template<typename Getter>
+	auto WaitUntil(
+		Getter getter,
+		Duration timeoutMs = 5000,
+		Duration intervalMs = 50
+		) const -> PendingWait<decltype(getter())> {
+		typedef decltype(getter()) Value;
+		return Start<Value>([getter](std::string* description) -> std::unique_ptr<Value> {
+				auto value_ptr = detail::TryToCallGetter<Value>(getter, description);
+				if (!value_ptr || !!*value_ptr)
+					return value_ptr;
+				if (description)
+					*description = "Value is falsy";
+				value_ptr.reset();
+				return value_ptr;
+			}, timeoutMs, intervalMs);
+	}
+
+	template<typename Getter, typename Matcher>
+	auto WaitForMatch(
+		Getter getter,
+		Matcher matcher,
+		Duration timeoutMs = 5000,
+		Duration intervalMs = 50
+		) const -> PendingWait<decltype(getter())> {
+		typedef decltype(getter()) Value;
+		return Start<Value>([getter, matcher](std::string* description) mutable
+			-> std::unique_ptr<Value> {
+				const auto& adapter = detail::SelectMakeMatcherAdapter<Value>(matcher,
+					typename std::is_same<void,decltype(MakeMatcherAdapter<Value>(matcher))>::type());
+				auto value_ptr = detail::TryToCallGetter<Value>(getter, description);
+				if (value_ptr && !adapter.Apply(*value_ptr)) {
+					if (description)
+						*description = adapter.DescribeMismatch(*value_ptr);
+					value_ptr.reset();
+				}
+				return value_ptr;
+			}, timeoutMs, intervalMs);
+	}
+
+	size_t GetPendingCount() const {
+		return timers_->GetPendingCount();
+	}
+
+private:
+	template<typename Value, typename DescriptiveGetter>
+	PendingWait<Value> Start(
+		DescriptiveGetter getter,
+		Duration timeoutMs,
+		Duration intervalMs
+		) const {
+		const auto state = std::make_shared<detail::PendingWaitState<Value>>(
+			timers_, getter, timeoutMs, intervalMs);
+		detail::PendingWaitState<Value>::Start(state);
+		return PendingWait<Value>(state);
+	}
+
+private:
+	detail::Shared<detail::TimerWheel> timers_;
+};
+
+} // namespace webdriverxx
+
+#endif
@@ -0,0 +1,58 @@
+#include "mock_server.h"
+#include <webdriverxx/async.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class BenchmarkAsyncSession : public MockSessionTest {
+protected:
+	static const int kNumberOfElements = 50;
+	static const Duration kLatencyMs = 10;
+
+	BenchmarkAsyncSession() {
+		picojson::array refs;
+		for (int i = 0; i < kNumberOfElements; ++i) {
+			const std::string ref = Fmt() << i;
+			ElementRef element_ref = { ref };
+			refs.push_back(ToJson(element_ref));
+			server->On("GET", MockServer::SessionPath("element/" + ref + "/text"),
+				ToJson(std::string("text ") + ref));
+		}
+		server->On("POST", MockServer::SessionPath("elements"), picojson::value(refs));
+	}
+};
+
+TEST_F(BenchmarkAsyncSession, SerialAndConcurrentBulkReads) {
+	server->SetLatencyMs(kLatencyMs);
+	const std::vector<Element> elements = session.FindElements(ByTag("td"));
+
+	TimePoint start = Now();
+	std::vector<std::string> serial;
+	for (const auto& element : elements)
+		serial.push_back(element.GetText());
+	const Duration serial_ms = static_cast<Duration>(Now() - start);
+
+	AsyncSession async(session, kDefaultAsyncConcurrency);
+	start = Now();
+	std::vector<std::future<std::string>> pending;
+	for (const auto& element : elements)
+		pending.push_back(async.Wrap(element).GetText());
+	std::vector<std::string> concurrent;
+	for (auto& text : pending)
+		concurrent.push_back(text.get());
+	const Duration concurrent_ms = static_cast<Duration>(Now() - start);
+
+	ASSERT_EQ(serial, concurrent);
+	std::cout << kNumberOfElements << " reads at " << kLatencyMs << "ms latency: "
+		<< "serial " << serial_ms << "ms, "
+		<< "concurrent (" << kDefaultAsyncConcurrency << ") " << concurrent_ms << "ms"
+		<< std::endl;
+}
+
+} // namespace test
@@ -0,0 +1,81 @@
+#include "mock_server.h"
+#include <webdriverxx/async.h>
+#include <webdriverxx/client.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+const int kNumberOfElements = 50;
+
+class TestAsyncSession : public MockSessionTest {
+protected:
+	TestAsyncSession() {
+		picojson::array refs;
+		for (int i = 0; i < kNumberOfElements; ++i) {
+			const std::string ref = Fmt() << i;
+			ElementRef element_ref = { ref };
+			refs.push_back(ToJson(element_ref));
+			server->On("GET", MockServer::SessionPath("element/" + ref + "/text"),
+				ToJson(std::string("text ") + ref));
+		}
+		server->On("POST", MockServer::SessionPath("elements"), picojson::value(refs));
+		server->On("GET", MockServer::SessionPath("title"), ToJson("Mock"));
+	}
+};
+
+TEST_F(TestAsyncSession, ReturnsValues) {
+	AsyncSession async(session);
+	ASSERT_EQ("Mock", async.GetTitle().get());
+	const auto elements = async.FindElements(ByTag("td")).get();
+	ASSERT_EQ(static_cast<size_t>(kNumberOfElements), elements.size());
+	ASSERT_EQ("text 7", elements[7].GetText().get());
+}
+
+TEST_F(TestAsyncSession, PassesErrorsThroughFutures) {
+	AsyncSession async(session);
+	auto url = async.GetUrl(); // Not mocked
+	ASSERT_THROW(url.get(), WebDriverException);
+}
+
+TEST_F(TestAsyncSession, RunsArbitraryFunctions) {
+	AsyncSession async(session);
+	ASSERT_EQ("Mock!", async.Run([](const Session& s) {
+		return s.GetTitle() + "!";
+	}).get());
+}
+
+TEST_F(TestAsyncSession, WrapsSynchronousElements) {
+	AsyncSession async(session);
+	const Element element = session.FindElements(ByTag("td")).at(3);
+	ASSERT_EQ("text 3", async.Wrap(element).GetText().get());
+}
+
+TEST_F(TestAsyncSession, SendsBulkReadsConcurrently) {
+	const std::vector<Element> elements = session.FindElements(ByTag("td"));
+	// Every read is held until two reads are answered at the same time
+	const MockServer* const mock = &*server;
+	for (const auto& element : elements)
+		server->On("GET", MockServer::SessionPath("element/" + element.GetRef() + "/text"),
+			[mock](const std::string&) {
+				const TimePoint deadline = Now() + 5000;
+				while (mock->GetMaxConcurrentRequests() < 2 && Now() < deadline)
+					Sleep(1);
+				return ToJson("text");
+			});
+
+	AsyncSession async(session, kDefaultAsyncConcurrency);
+	std::vector<std::future<std::string>> pending;
+	for (const auto& element : elements)
+		pending.push_back(async.Wrap(element).GetText());
+	for (auto& text : pending)
+		ASSERT_EQ("text", text.get());
+	ASSERT_LE(2u, server->GetMaxConcurrentRequests());
+	ASSERT_GE(kDefaultAsyncConcurrency, server->GetMaxConcurrentRequests());
+}
+
+} // namespace test
@@ -0,0 +1,108 @@
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/batch.h>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+const char* const kOtherSessionId = "other-session";
+
+class TestCommandBatch : public MockSessionTest {
+protected:
+	TestCommandBatch()
+		: other(client.AttachSession(kOtherSessionId))
+	{
+		const auto receive = [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			const std::string name = FromJson<std::string>(request.get("cookie").get("name"));
+			std::lock_guard<std::mutex> lock(mutex);
+			received.push_back(name);
+			return picojson::value(name);
+		};
+		server->On("POST", MockServer::SessionPath("cookie"), receive);
+		server->On("POST", std::string("session/") + kOtherSessionId + "/cookie", receive);
+	}
+
+	std::vector<std::string> GetReceived(char session) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<std::string> result;
+		for (const auto& name : received)
+			if (name[0] == session)
+				result.push_back(name);
+		return result;
+	}
+
+	const Session other;
+	std::mutex mutex;
+	std::vector<std::string> received;
+};
+
+TEST_F(TestCommandBatch, KeepsOrderOfSessionCommands) {
+	CommandBatch batch;
+	std::vector<std::string> expected;
+	for (int i = 0; i < 5; ++i) {
+		const std::string name = Fmt() << "a" << i;
+		expected.push_back(name);
+		batch.Add(session, [name](const Session& s) { s.SetCookie(Cookie(name, "v")); });
+	}
+	const std::vector<BatchResult> results = batch.Run();
+	ASSERT_EQ(5u, results.size());
+	ASSERT_EQ(expected, GetReceived('a'));
+	ASSERT_EQ(0u, batch.GetSize());
+}
+
+TEST_F(TestCommandBatch, KeepsOrderWithinEachSession) {
+	CommandBatch batch;
+	std::vector<std::string> expected_a, expected_b;
+	for (int i = 0; i < 3; ++i) {
+		const std::string a = Fmt() << "a" << i;
+		const std::string b = Fmt() << "b" << i;
+		expected_a.push_back(a);
+		expected_b.push_back(b);
+		batch.Add(session, [a](const Session& s) { s.SetCookie(Cookie(a, "v")); });
+		batch.Add(other, [b](const Session& s) { s.SetCookie(Cookie(b, "v")); });
+	}
+	const std::vector<BatchResult> results = batch.Run();
+	ASSERT_EQ(6u, results.size());
+	for (const auto& result : results)
+		ASSERT_EQ(BatchResult::Succeeded, result.status) << result.error;
+	ASSERT_EQ(expected_a, GetReceived('a'));
+	ASSERT_EQ(expected_b, GetReceived('b'));
+}
+
+TEST_F(TestCommandBatch, ReturnsResultsInFutures) {
+	CommandBatch batch;
+	auto first = batch.Post(session, "cookie", JsonObject()
+		.Set("cookie", ToJson(Cookie("a1", "v"))));
+	server->On("GET", MockServer::SessionPath("title"), ToJson("Title"));
+	auto second = batch.Add(session, [](const Session& s) { return s.GetTitle(); });
+	batch.Run();
+	ASSERT_EQ("a1", FromJson<std::string>(first.get()));
+	ASSERT_EQ("Title", second.get());
+}
+
+TEST_F(TestCommandBatch, SkipsSessionCommandsAfterFailure) {
+	CommandBatch batch;
+	batch.Add(session, [](const Session& s) { s.SetCookie(Cookie("a0", "v")); });
+	auto failed = batch.Post(session, "not_mocked");
+	auto skipped = batch.Add(session, [](const Session& s) { s.SetCookie(Cookie("a2", "v")); });
+	batch.Add(other, [](const Session& s) { s.SetCookie(Cookie("b0", "v")); });
+	const std::vector<BatchResult> results = batch.Run();
+	ASSERT_EQ(BatchResult::Succeeded, results[0].status);
+	ASSERT_EQ(BatchResult::Failed, results[1].status);
+	ASSERT_NE(std::string::npos, results[1].error.find("not_mocked"));
+	ASSERT_EQ(BatchResult::Skipped, results[2].status);
+	ASSERT_EQ(BatchResult::Succeeded, results[3].status);
+	ASSERT_THROW(failed.get(), WebDriverException);
+	ASSERT_THROW(skipped.get(), WebDriverException);
+	ASSERT_EQ(1u, GetReceived('a').size());
+	ASSERT_EQ(1u, GetReceived('b').size());
+}
+
+} // namespace test
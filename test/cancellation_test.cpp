@@ -0,0 +1,194 @@
+#include "mock_server.h"
+#include <webdriverxx/cancellation.h>
+#include <webdriverxx/async.h>
+#include <webdriverxx/client.h>
+#include <webdriverxx/wait.h>
+#include <webdriverxx/detail/http_connection.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(CancellationToken, IsNotCancelledByDefault) {
+	const CancellationToken token;
+	ASSERT_FALSE(token.CanBeCancelled());
+	ASSERT_FALSE(token.IsCancelled());
+	ASSERT_THROW(token.Cancel(), WebDriverException);
+}
+
+TEST(CancellationToken, CanBeCancelledByCopy) {
+	const CancellationToken token = CancellationToken::MakeCancellable();
+	const CancellationToken copy = token;
+	ASSERT_FALSE(token.IsCancelled());
+	copy.Cancel();
+	ASSERT_TRUE(token.IsCancelled());
+}
+
+TEST(CancellationToken, IsCancelledAfterDeadline) {
+	ASSERT_TRUE(CancellationToken::WithTimeoutMs(0).IsCancelled());
+	ASSERT_FALSE(CancellationToken::WithTimeoutMs(60000).IsCancelled());
+}
+
+TEST(CancellationScope, AppliesToCurrentThreadOnly) {
+	const CancellationToken token = CancellationToken::MakeCancellable();
+	token.Cancel();
+	ASSERT_FALSE(CancellationContext::Capture().IsCancelled());
+	{
+		const CancellationScope scope(token);
+		ASSERT_TRUE(CancellationContext::Capture().IsCancelled());
+		bool cancelled_in_other_thread = true;
+		std::thread([&cancelled_in_other_thread]{
+			cancelled_in_other_thread = CancellationContext::Capture().IsCancelled();
+		}).join();
+		ASSERT_FALSE(cancelled_in_other_thread);
+	}
+	ASSERT_FALSE(CancellationContext::Capture().IsCancelled());
+}
+
+TEST(CancellationScope, CanBeNested) {
+	const CancellationScope outer(CancellationToken::WithTimeoutMs(60000));
+	const CancellationToken inner_token = CancellationToken::WithTimeoutMs(1000);
+	{
+		const CancellationScope inner(inner_token);
+		ASSERT_EQ(2u, CancellationContext::Capture().GetTokens().size());
+		ASSERT_EQ(inner_token.GetDeadline(), CancellationContext::Capture().GetDeadline());
+	}
+	ASSERT_EQ(1u, CancellationContext::Capture().GetTokens().size());
+}
+
+TEST(CancellationScope, StopsWaits) {
+	const CancellationScope scope(CancellationToken::WithTimeoutMs(50));
+	const TimePoint start = Now();
+	ASSERT_THROW(WaitUntil([]{ return false; }, 60000), WebDriverException);
+	ASSERT_GT(1000u, Now() - start);
+}
+
+class TestCancellation : public MockSessionTest {
+protected:
+	TestCancellation() {
+		server->On("GET", MockServer::SessionPath("title"), ToJson("Mock"));
+		const ElementRef element_ref = { "1" };
+		server->On("POST", MockServer::SessionPath("element"), ToJson(element_ref));
+		server->On("GET", MockServer::SessionPath("element/1/text"), ToJson("text"));
+	}
+};
+
+TEST_F(TestCancellation, StopsCommandsOfSessionAndItsElements) {
+	const Element element = session.FindElement(ByTag("p"));
+	const CancellationToken token = CancellationToken::MakeCancellable();
+	session.SetCancellationToken(token);
+	ASSERT_EQ("Mock", session.GetTitle());
+	ASSERT_EQ("text", element.GetText());
+	token.Cancel();
+	ASSERT_THROW(session.GetTitle(), WebDriverException);
+	ASSERT_THROW(element.GetText(), WebDriverException);
+	session.SetCancellationToken(CancellationToken());
+	ASSERT_EQ("Mock", session.GetTitle());
+}
+
+TEST_F(TestCancellation, IsPassedToAsyncCommands) {
+	const AsyncSession async(session, 1);
+	std::future<std::string> title;
+	{
+		const CancellationScope scope(CancellationToken::WithTimeoutMs(0));
+		title = async.GetTitle();
+	}
+	ASSERT_THROW(title.get(), WebDriverException);
+	ASSERT_EQ("Mock", async.GetTitle().get());
+}
+
+TEST_F(TestCancellation, DeletesSessionInsideCancelledScope) {
+	int deleted = 0;
+	server->On("DELETE", MockServer::SessionPath(), [&deleted](const std::string&) {
+		++deleted;
+		return picojson::value();
+	});
+	const CancellationToken token = CancellationToken::MakeCancellable();
+	{
+		const CancellationScope scope(token);
+		const Session owned = client.CreateSession(Capabilities(), Capabilities());
+		owned.SetCancellationToken(token);
+		token.Cancel();
+		ASSERT_THROW(owned.GetTitle(), WebDriverException);
+	}
+	ASSERT_EQ(1, deleted);
+}
+
+TEST(CancellationMask, HidesScopesOfThread) {
+	const CancellationScope scope(CancellationToken::WithTimeoutMs(0));
+	{
+		const CancellationMask mask;
+		ASSERT_TRUE(CancellationContext::Capture().IsEmpty());
+	}
+	ASSERT_TRUE(CancellationContext::Capture().IsCancelled());
+}
+
+#ifndef _WIN32
+
+// Accepts connections and never answers, like a hung driver.
+class HungServer { // noncopyable
+public:
+	HungServer() : socket_(::socket(AF_INET, SOCK_STREAM, 0)) {
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t length = sizeof(address);
+		if (::bind(socket_, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+			::listen(socket_, 16) != 0 ||
+			::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+			throw std::runtime_error("Cannot start server");
+		url_ = Fmt() << "http://127.0.0.1:" << ntohs(address.sin_port) << "/";
+	}
+
+	~HungServer() {
+		::close(socket_);
+	}
+
+	const std::string& GetUrl() const {
+		return url_;
+	}
+
+private:
+	const int socket_;
+	std::string url_;
+};
+
+TEST(HttpConnection, StopsAtDeadline) {
+	HungServer server;
+	HttpConnection connection;
+	const TimePoint start = Now();
+	const CancellationScope scope(CancellationToken::WithTimeoutMs(200));
+	ASSERT_THROW(connection.Get(server.GetUrl() + "status"), WebDriverException);
+	ASSERT_LE(200u, Now() - start);
+	ASSERT_GT(2000u, Now() - start);
+}
+
+TEST(HttpConnection, StopsWhenCancelled) {
+	HungServer server;
+	HttpConnection connection;
+	const CancellationToken token = CancellationToken::MakeCancellable();
+	std::thread canceller([token]{
+		Sleep(100);
+		token.Cancel();
+	});
+	const TimePoint start = Now();
+	const CancellationScope scope(token);
+	ASSERT_THROW(connection.Get(server.GetUrl() + "status"), WebDriverException);
+	canceller.join();
+	ASSERT_GT(3000u, Now() - start);
+}
+
+#endif
+
+} // namespace test
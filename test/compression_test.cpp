@@ -0,0 +1,84 @@
+#include "http_server.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#ifndef _WIN32
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestCompression : public ::testing::Test {
+protected:
+	TestCompression()
+		: mock(new MockServer)
+		, server(mock)
+		, large_text(10000, 'a')
+	{
+		mock->On("GET", MockServer::SessionPath("title"), ToJson(large_text));
+		mock->On("POST", MockServer::SessionPath("execute"), [](const std::string& data) {
+			return picojson::value(data);
+		});
+	}
+
+	Metrics RunCommands(const ConnectionOptions& options) {
+		const Client client(server.GetUrl(), options);
+		const Session session = client.CreateSession(Capabilities(), Capabilities());
+		EXPECT_EQ(large_text, session.GetTitle());
+		const std::string script = "return '" + large_text + "'";
+		EXPECT_NE(std::string::npos, session.Eval<std::string>(script).find(large_text));
+		return client.GetMetrics();
+	}
+
+	Shared<MockServer> mock;
+	HttpServer server;
+	const std::string large_text;
+};
+
+TEST_F(TestCompression, IsOffByDefault) {
+	const Metrics metrics = RunCommands(ConnectionOptions());
+	ASSERT_LT(2 * large_text.size(), metrics.bytes_received);
+	ASSERT_EQ(metrics.bytes_received, metrics.bytes_received_on_wire);
+	ASSERT_LT(large_text.size(), metrics.bytes_sent);
+	ASSERT_EQ(metrics.bytes_sent, metrics.bytes_sent_on_wire);
+}
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+TEST_F(TestCompression, DecodesCompressedResponses) {
+	const Metrics metrics = RunCommands(ConnectionOptions()
+		.SetAcceptCompressedResponses(true));
+	ASSERT_LT(2 * large_text.size(), metrics.bytes_received);
+	ASSERT_GT(metrics.bytes_received / 10, metrics.bytes_received_on_wire);
+	ASSERT_EQ(metrics.bytes_sent, metrics.bytes_sent_on_wire);
+}
+
+TEST_F(TestCompression, CompressesLargeRequests) {
+	const Metrics metrics = RunCommands(ConnectionOptions()
+		.SetRequestCompressionThreshold(1000));
+	ASSERT_LT(large_text.size(), metrics.bytes_sent);
+	ASSERT_GT(metrics.bytes_sent / 10, metrics.bytes_sent_on_wire);
+	ASSERT_EQ(metrics.bytes_received, metrics.bytes_received_on_wire);
+}
+
+TEST_F(TestCompression, DoesNotCompressRequestsBelowThreshold) {
+	const Metrics metrics = RunCommands(ConnectionOptions()
+		.SetRequestCompressionThreshold(100000));
+	ASSERT_EQ(metrics.bytes_sent, metrics.bytes_sent_on_wire);
+}
+
+#else
+
+TEST(Compression, RequiresZlibToCompressRequests) {
+	ASSERT_THROW(Client("http://localhost/", ConnectionOptions()
+		.SetRequestCompressionThreshold(1000)), WebDriverException);
+}
+
+#endif
+
+} // namespace test
+
+#endif
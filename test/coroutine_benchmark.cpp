@@ -0,0 +1,60 @@
+#include <webdriverxx/coroutine.h>
+
+#if WEBDRIVERXX_HAS_COROUTINES
+
+#include "mock_server.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class BenchmarkCoroutines : public MockSessionTest {
+protected:
+	BenchmarkCoroutines() {
+		const ElementRef cell = { "cell" };
+		server->On("POST", MockServer::SessionPath("element"), ToJson(cell));
+		server->On("GET", MockServer::SessionPath("element/cell/text"), ToJson("text"));
+	}
+};
+
+// A scripted flow: find, read, then wait for the page to "settle".
+Task<std::string> ScriptedFlow(CoSession session, Duration settle_ms) {
+	const TimePoint settled = Now() + settle_ms;
+	auto find = session.FindElement(ByTag("td"));
+	const CoElement cell = co_await find;
+	auto read = cell.GetText();
+	const std::string text = co_await read;
+	auto settle = CoWaitUntil(session.GetScheduler(), [settled]{ return Now() >= settled; },
+		60000, 10);
+	co_await settle;
+	co_return text;
+}
+
+TEST_F(BenchmarkCoroutines, ConcurrentFlowsWithSettleWaits) {
+	const int kFlows = 500;
+	const Duration kSettleMs = 200;
+	server->SetLatencyMs(1);
+	Scheduler scheduler(4);
+	CoSession co_session(session, scheduler);
+
+	const TimePoint start = Now();
+	std::vector<std::future<std::string>> flows;
+	for (int i = 0; i < kFlows; ++i)
+		flows.push_back(scheduler.Spawn(ScriptedFlow(co_session, kSettleMs)));
+	for (auto& flow : flows)
+		ASSERT_EQ("text", flow.get());
+	const Duration elapsed_ms = static_cast<Duration>(Now() - start);
+
+	// Blocking waits would need kFlows / threads * kSettleMs
+	std::cout << kFlows << " flows with " << kSettleMs << "ms waits on "
+		<< scheduler.GetThreadCount() << " threads: " << elapsed_ms << "ms" << std::endl;
+}
+
+} // namespace test
+
+#endif // WEBDRIVERXX_HAS_COROUTINES
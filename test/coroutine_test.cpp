@@ -0,0 +1,120 @@
+#include <webdriverxx/coroutine.h>
+
+#if WEBDRIVERXX_HAS_COROUTINES
+
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+const int kNumberOfCells = 10;
+
+class TestCoroutines : public MockSessionTest {
+protected:
+	TestCoroutines() {
+		picojson::array refs;
+		for (int i = 0; i < kNumberOfCells; ++i) {
+			const std::string ref = Fmt() << i;
+			ElementRef element_ref = { ref };
+			refs.push_back(ToJson(element_ref));
+			server->On("GET", MockServer::SessionPath("element/" + ref + "/text"),
+				ToJson(std::string("cell ") + ref));
+		}
+		server->On("POST", MockServer::SessionPath("elements"), picojson::value(refs));
+		server->On("GET", MockServer::SessionPath("title"), ToJson("Mock"));
+	}
+};
+
+// Awaited tasks are named locals, see detail::CoCall.
+
+Task<std::string> ReadCell(CoSession session, int index) {
+	auto find = session.FindElements(ByTag("td"));
+	const std::vector<CoElement> cells = co_await find;
+	auto read = cells.at(index % cells.size()).GetText();
+	co_return co_await read;
+}
+
+Task<std::string> ReadTitle(CoSession session) {
+	auto read = session.GetTitle();
+	co_return co_await read;
+}
+
+Task<> ReadMissingUrl(CoSession session) {
+	auto read = session.GetUrl();
+	co_await read;
+}
+
+TEST_F(TestCoroutines, AwaitsCommands) {
+	Scheduler scheduler;
+	CoSession co_session(session, scheduler);
+	ASSERT_EQ("Mock", scheduler.Spawn(ReadTitle(co_session)).get());
+	ASSERT_EQ("cell 3", scheduler.Spawn(ReadCell(co_session, 3)).get());
+}
+
+TEST_F(TestCoroutines, PassesErrorsToAwaiter) {
+	Scheduler scheduler;
+	auto flow = scheduler.Spawn(ReadMissingUrl(CoSession(session, scheduler)));
+	ASSERT_THROW(flow.get(), WebDriverException);
+}
+
+Task<int> WaitForCounter(Scheduler scheduler, std::shared_ptr<std::atomic<int>> counter) {
+	auto wait = CoWaitUntil(scheduler, [counter]{ return ++*counter >= 3 ? 3 : 0; }, 1000, 0);
+	co_return co_await wait;
+}
+
+TEST_F(TestCoroutines, WaitsUntilValueIsTruthy) {
+	Scheduler scheduler;
+	const auto counter = std::make_shared<std::atomic<int>>(0);
+	ASSERT_EQ(3, scheduler.Spawn(WaitForCounter(scheduler, counter)).get());
+	ASSERT_EQ(3, counter->load());
+}
+
+Task<int> WaitForever(Scheduler scheduler) {
+	auto wait = CoWaitUntil(scheduler, []{ return 0; }, 0);
+	co_return co_await wait;
+}
+
+TEST_F(TestCoroutines, ThrowsOnWaitTimeout) {
+	Scheduler scheduler;
+	auto flow = scheduler.Spawn(WaitForever(scheduler));
+	ASSERT_THROW(flow.get(), WebDriverException);
+}
+
+// A scripted flow: find, read, then wait until all flows have read.
+Task<std::string> ScriptedFlow(CoSession session, int index,
+	std::shared_ptr<std::atomic<int>> arrived, int flows) {
+	auto read = ReadCell(session, index);
+	const std::string text = co_await read;
+	++*arrived;
+	auto settle = CoWaitUntil(session.GetScheduler(), [arrived, flows]{ return *arrived == flows; },
+		5000, 10);
+	co_await settle;
+	co_return text;
+}
+
+TEST_F(TestCoroutines, Runs500ConcurrentFlowsOn4Threads) {
+	const int kFlows = 500;
+	Scheduler scheduler(4);
+	CoSession co_session(session, scheduler);
+	// Blocking waits would keep all threads busy with the first 4 flows
+	// and their waits would time out
+	const auto arrived = std::make_shared<std::atomic<int>>(0);
+	std::vector<std::future<std::string>> flows;
+	for (int i = 0; i < kFlows; ++i)
+		flows.push_back(scheduler.Spawn(ScriptedFlow(co_session, i, arrived, kFlows)));
+	for (int i = 0; i < kFlows; ++i)
+		ASSERT_EQ(std::string("cell ") + std::string(Fmt() << i % kNumberOfCells), flows[i].get());
+	ASSERT_EQ(kFlows, arrived->load());
+	ASSERT_GE(4u, server->GetMaxConcurrentRequests());
+}
+
+} // namespace test
+
+#endif // WEBDRIVERXX_HAS_COROUTINES
@@ -0,0 +1,151 @@
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/dom_snapshot.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+// <html><head><title>T</title></head><body>
+// <div id="main" class="box wide">Hello <a href="/login">Sign  in</a>
+// <ul><li class="item">one</li><li class="item">two</li></ul></div>
+// <div style="display:none">secret</div><input name="q" value="typed">
+// </body></html>
+const char *const kCapturedDom = "["
+	"[-1,\"html\",[],2],"
+	"[0,\"head\",[],0],"
+	"[1,\"title\",[],0],"
+	"[2,\"T\"],"
+	"[0,\"body\",[],2],"
+	"[4,\"div\",[\"id\",\"main\",\"class\",\"box wide\"],2],"
+	"[5,\"Hello \"],"
+	"[5,\"a\",[\"href\",\"/login\"],1],"
+	"[7,\"Sign  in\"],"
+	"[5,\"ul\",[],2],"
+	"[9,\"li\",[\"class\",\"item\"],2],"
+	"[10,\"one\"],"
+	"[9,\"li\",[\"class\",\"item\"],2],"
+	"[12,\"two\"],"
+	"[4,\"div\",[\"style\",\"display:none\"],0],"
+	"[14,\"secret\"],"
+	"[4,\"input\",[\"value\",\"typed\",\"NAME\",\"q\"],1]"
+	"]";
+
+class TestDomSnapshot : public MockSessionTest {
+protected:
+	TestDomSnapshot()
+		: page_changed(false)
+		, snapshot(Capture())
+	{}
+
+	DomSnapshot Capture() {
+		server->On("POST", MockServer::SessionPath("execute"), [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			if (request.get("script").to_str() == kCaptureDomScript) {
+				picojson::value dom;
+				picojson::parse(dom, kCapturedDom);
+				return dom;
+			}
+			promoted.push_back(request.get("args").serialize());
+			return page_changed ? picojson::value() :
+				JsonObject().Set("ELEMENT", "live" + request.get("args").get(0).to_str());
+		});
+		return session.CaptureDom();
+	}
+
+	std::vector<std::string> GetTags(const std::vector<DomElement>& elements) {
+		std::vector<std::string> result;
+		for (const auto& element : elements)
+			result.push_back(element.GetTagName() + ":" + element.GetText());
+		return result;
+	}
+
+	std::vector<std::string> Css(const std::string& selector) {
+		return GetTags(snapshot.FindElements(ByCss(selector)));
+	}
+
+	std::vector<std::string> XPath(const std::string& path) {
+		return GetTags(snapshot.FindElements(ByXPath(path)));
+	}
+
+	static std::vector<std::string> Tags(const std::string& a,
+		const std::string& b = std::string(), const std::string& c = std::string()) {
+		std::vector<std::string> result(1, a);
+		if (!b.empty()) result.push_back(b);
+		if (!c.empty()) result.push_back(c);
+		return result;
+	}
+
+	bool page_changed;
+	std::vector<std::string> promoted;
+	DomSnapshot snapshot;
+};
+
+TEST_F(TestDomSnapshot, AnswersLocatorsWithoutCommands) {
+	const unsigned requests = server->GetRequestCount();
+	const DomSnapshot& dom = snapshot;
+	ASSERT_EQ(17u, dom.GetNodeCount());
+	const DomElement main = dom.FindElement(ById("main"));
+	ASSERT_EQ("div", main.GetTagName());
+	ASSERT_EQ("Hello Sign in\none\ntwo", main.GetText());
+	ASSERT_EQ("box wide", main.GetAttribute("class"));
+	ASSERT_TRUE(main.IsDisplayed());
+	ASSERT_EQ(2u, main.FindElements(ByClass("item")).size());
+	ASSERT_EQ(2u, dom.FindElements(ByTag("DIV")).size());
+	ASSERT_EQ("/login", dom.FindElement(ByLinkText("Sign in")).GetAttribute("href"));
+	ASSERT_EQ(1u, dom.FindElements(ByPartialLinkText("Sign")).size());
+	ASSERT_EQ("typed", dom.FindElement(ByName("q")).GetAttribute("value"));
+	ASSERT_TRUE(dom.FindElement(ByName("q")).HasAttribute("Name"));
+	const DomElement hidden = dom.FindElements(ByTag("div"))[1];
+	ASSERT_FALSE(hidden.IsDisplayed());
+	ASSERT_EQ("", hidden.GetText());
+	ASSERT_TRUE(dom.FindElements(ById("missing")).empty());
+	ASSERT_THROW(dom.FindElement(ById("missing")), WebDriverException);
+	ASSERT_EQ(requests, server->GetRequestCount());
+}
+
+TEST_F(TestDomSnapshot, MatchesCssSelectors) {
+	ASSERT_EQ(Tags("li:two"), Css("div#main > ul li.item:nth-child(2)"));
+	ASSERT_EQ(Tags("a:Sign in", "input:"), Css("a[href^='/'], input[name=q]"));
+	ASSERT_EQ(Tags("li:two"), Css("li + li"));
+	ASSERT_EQ(Tags("li:one", "li:two"), Css(".box ul > *"));
+	ASSERT_EQ(Tags("div:"), Css("div ~ div[style*=none]"));
+	ASSERT_EQ(Tags("li:one"), Css("ul :first-child"));
+	ASSERT_EQ(Tags("div:Hello Sign in\none\ntwo"), Css("[class~=wide]"));
+	ASSERT_TRUE(Css("body > li").empty());
+	ASSERT_EQ(Tags("li:one", "li:two"),
+		GetTags(snapshot.FindElement(ByTag("ul")).FindElements(ByCss("li"))));
+	ASSERT_THROW(Css("li:hover"), WebDriverException);
+	ASSERT_THROW(Css("li >"), WebDriverException);
+}
+
+TEST_F(TestDomSnapshot, EvaluatesXPath) {
+	ASSERT_EQ(Tags("li:two"), XPath("//li[2]"));
+	ASSERT_EQ(Tags("li:two"), XPath("//ul/li[last()]"));
+	ASSERT_EQ(Tags("a:Sign in"), XPath("//a[text()='Sign  in']"));
+	ASSERT_EQ(Tags("a:Sign in"), XPath("//a[normalize-space(.)='Sign in' and @href]"));
+	ASSERT_EQ(Tags("li:two"), XPath("//div[@id='main']//li[contains(., 'tw')]"));
+	ASSERT_EQ(Tags("div:"), XPath("/html/body/div[2]"));
+	ASSERT_EQ(Tags("ul:one\ntwo"), XPath("//li/.."));
+	ASSERT_EQ(Tags("li:one"), XPath("//li[following-sibling::li]"));
+	ASSERT_EQ(Tags("div:Hello Sign in\none\ntwo"), XPath("//*[ul][not(@style)]"));
+	ASSERT_EQ(Tags("li:two"),
+		GetTags(snapshot.FindElement(ById("main")).FindElements(ByXPath(".//li[position() > 1]"))));
+	ASSERT_THROW(XPath("count(//li)"), WebDriverException);
+	ASSERT_THROW(XPath("//li["), WebDriverException);
+}
+
+TEST_F(TestDomSnapshot, PromotesElementsToLiveOnes) {
+	const Element element = snapshot.FindElements(ByTag("li"))[1].ToElement();
+	ASSERT_EQ("live8", element.GetRef());
+	ASSERT_EQ(1u, promoted.size());
+	ASSERT_EQ("[8,\"li\"]", promoted[0]);
+	page_changed = true;
+	ASSERT_THROW(snapshot.FindElement(ByTag("input")).ToElement(), WebDriverException);
+}
+
+} // namespace test
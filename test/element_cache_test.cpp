@@ -0,0 +1,137 @@
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestElementCache : public MockSessionTest {
+protected:
+	TestElementCache()
+		: lookups(0)
+	{
+		server->On("POST", MockServer::SessionPath("element"), [this](const std::string&) {
+			return JsonObject().Set("ELEMENT", Attach(Fmt() << "e" << ++lookups));
+		});
+		server->On("POST", MockServer::SessionPath("url"), picojson::value());
+		server->On("POST", MockServer::SessionPath("frame"), picojson::value());
+		session.SetElementCacheEnabled(true);
+		requests_before = server->GetRequestCount();
+	}
+
+	// The text of an element is its ref
+	std::string Attach(const std::string& ref) {
+		server->On("GET", MockServer::SessionPath("element/" + ref + "/text"), ToJson(ref));
+		return ref;
+	}
+
+	void Detach(const std::string& ref) {
+		server->On("GET", MockServer::SessionPath("element/" + ref + "/text"),
+			[](const std::string&) -> picojson::value {
+				const MockServer::CommandError error = {
+					response_status_code::kStaleElementReference, "Element is not attached" };
+				throw error;
+			});
+	}
+
+	unsigned GetRequestCount() const {
+		return server->GetRequestCount() - requests_before;
+	}
+
+	int lookups;
+	unsigned requests_before;
+};
+
+TEST_F(TestElementCache, ReturnsCachedElements) {
+	const Element first = session.FindElement(ById("login"));
+	ASSERT_EQ(first, session.FindElement(ById("login")));
+	ASSERT_EQ(first, session.FindElement(ById("login")));
+	ASSERT_NE(first, session.FindElement(ByName("login")));
+	ASSERT_EQ(2, lookups);
+	ASSERT_EQ(2u, GetRequestCount());
+	const ElementCacheStats stats = session.GetElementCacheStats();
+	ASSERT_EQ(2u, stats.lookups);
+	ASSERT_EQ(2u, stats.lookups_saved);
+	ASSERT_EQ(0u, stats.stale);
+}
+
+TEST_F(TestElementCache, KeepsContextsApart) {
+	const Element form = session.FindElement(ById("form"));
+	server->On("POST", MockServer::SessionPath("element/" + form.GetRef() + "/element"), [this](const std::string&) {
+		return JsonObject().Set("ELEMENT", Attach(Fmt() << "e" << ++lookups));
+	});
+	const Element field = form.FindElement(ByName("user"));
+	ASSERT_NE(field, session.FindElement(ByName("user")));
+	ASSERT_EQ(field, form.FindElement(ByName("user")));
+	ASSERT_EQ(3, lookups);
+	ASSERT_EQ(3u, GetRequestCount());
+}
+
+TEST_F(TestElementCache, LooksUpStaleElementsAgain) {
+	const Element first = session.FindElement(ById("login"));
+	Detach(first.GetRef());
+	ASSERT_EQ("e2", first.GetText()); // Failed, looked up, repeated
+	ASSERT_EQ(4u, GetRequestCount());
+	const Element second = session.FindElement(ById("login"));
+	ASSERT_EQ("e2", second.GetRef());
+	Detach(second.GetRef());
+	ASSERT_EQ("e3", second.GetText());
+	ASSERT_EQ(7u, GetRequestCount());
+	ASSERT_EQ(3, lookups);
+	ASSERT_EQ(2u, session.GetElementCacheStats().stale);
+}
+
+TEST_F(TestElementCache, ForgetsRefreshedRefs) {
+	const Element first = session.FindElement(ById("login"));
+	Detach(first.GetRef());
+	ASSERT_EQ("e2", first.GetText());
+	try {
+		first.GetText(); // Its ref is no longer in the cache
+		FAIL() << "Stale element was not reported";
+	} catch (const WebDriverException& e) {
+		ASSERT_EQ(response_status_code::kStaleElementReference, e.GetStatusCode());
+	}
+	ASSERT_EQ(2, lookups);
+}
+
+TEST_F(TestElementCache, ReportsStaleElementsNotFromCache) {
+	session.SetElementCacheEnabled(false);
+	const Element element = session.FindElement(ById("login"));
+	Detach(element.GetRef());
+	try {
+		element.GetText();
+		FAIL() << "Stale element was not reported";
+	} catch (const WebDriverException& e) {
+		ASSERT_EQ(response_status_code::kStaleElementReference, e.GetStatusCode());
+	}
+	ASSERT_EQ(1, lookups);
+}
+
+TEST_F(TestElementCache, IsClearedByNavigationAndFrameSwitches) {
+	session.FindElement(ById("login"));
+	session.Navigate("http://example.com/");
+	session.FindElement(ById("login"));
+	session.SetFocusToFrame(0);
+	session.FindElement(ById("login"));
+	session.ClearElementCache();
+	session.FindElement(ById("login"));
+	ASSERT_EQ(4, lookups);
+	ASSERT_EQ(0u, session.GetElementCacheStats().lookups_saved);
+}
+
+TEST_F(TestElementCache, IsOffByDefault) {
+	session.SetElementCacheEnabled(false);
+	session.FindElement(ById("login"));
+	session.FindElement(ById("login"));
+	ASSERT_EQ(2, lookups);
+	ASSERT_EQ(0u, session.GetElementCacheStats().lookups);
+	const Session other = client.CreateSession(Capabilities(), Capabilities());
+	other.FindElement(ById("login"));
+	other.FindElement(ById("login"));
+	ASSERT_EQ(4, lookups);
+}
+
+} // namespace test
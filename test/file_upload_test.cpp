@@ -0,0 +1,183 @@
+#include "http_server.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/file_upload.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#if !defined(_WIN32) && defined(WEBDRIVERXX_ENABLE_ZLIB)
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+inline
+std::string DecodeBase64(const std::string& text) {
+	static const std::string digits =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string result;
+	unsigned bits = 0;
+	int count = 0;
+	for (const char c : text) {
+		if (c == '=')
+			break;
+		bits = (bits << 6) | static_cast<unsigned>(digits.find(c));
+		if (++count == 4) {
+			result += static_cast<char>((bits >> 16) & 0xFF);
+			result += static_cast<char>((bits >> 8) & 0xFF);
+			result += static_cast<char>(bits & 0xFF);
+			bits = 0;
+			count = 0;
+		}
+	}
+	if (count == 2)
+		result += static_cast<char>((bits >> 4) & 0xFF);
+	if (count == 3) {
+		result += static_cast<char>((bits >> 10) & 0xFF);
+		result += static_cast<char>((bits >> 2) & 0xFF);
+	}
+	return result;
+}
+
+inline
+unsigned Get32(const std::string& data, size_t offset) {
+	unsigned result = 0;
+	for (size_t i = 4; i-- > 0;)
+		result = (result << 8) | static_cast<unsigned char>(data[offset + i]);
+	return result;
+}
+
+inline
+unsigned Get16(const std::string& data, size_t offset) {
+	return Get32(data + std::string(2, '\0'), offset) & 0xFFFF;
+}
+
+// Returns the name and the content of the only file of a zip archive.
+inline
+std::pair<std::string, std::string> Unzip(const std::string& zip) {
+	EXPECT_EQ(0x04034b50u, Get32(zip, 0));
+	EXPECT_EQ(8u, Get16(zip, 8));
+	const unsigned crc = Get32(zip, 14);
+	const unsigned compressed_size = Get32(zip, 18);
+	const unsigned size = Get32(zip, 22);
+	const unsigned name_size = Get16(zip, 26);
+	const std::string name = zip.substr(30, name_size);
+	const std::string data = zip.substr(30 + name_size, compressed_size);
+	const size_t directory = 30 + name_size + compressed_size;
+	EXPECT_EQ(0x02014b50u, Get32(zip, directory));
+	const size_t end = directory + 46 + name_size;
+	EXPECT_EQ(0x06054b50u, Get32(zip, end));
+	EXPECT_EQ(directory, Get32(zip, end + 16));
+	EXPECT_EQ(zip.size(), end + 22);
+
+	z_stream stream = {};
+	EXPECT_EQ(Z_OK, inflateInit2(&stream, -15));
+	std::string content(size, '\0');
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	stream.avail_in = static_cast<uInt>(data.size());
+	stream.next_out = reinterpret_cast<Bytef*>(&content[0]);
+	stream.avail_out = static_cast<uInt>(content.size());
+	EXPECT_EQ(Z_STREAM_END, inflate(&stream, Z_FINISH));
+	inflateEnd(&stream);
+	EXPECT_EQ(crc, crc32(0, reinterpret_cast<const Bytef*>(content.data()), static_cast<uInt>(content.size())));
+	return std::make_pair(name, content);
+}
+
+class TestFileUpload : public ::testing::Test {
+protected:
+	TestFileUpload()
+		: mock(new MockServer)
+		, path(Fmt() << "/tmp/webdriverxx-upload-" << ::getpid() << ".txt")
+	{
+		mock->On("POST", MockServer::SessionPath("file"), [this](const std::string& data) {
+			body_size = data.size();
+			const picojson::value request = ParseRequest(data);
+			uploaded = Unzip(DecodeBase64(request.get("file").to_str()));
+			return ToJson("/remote/" + uploaded.first);
+		});
+	}
+
+	~TestFileUpload() {
+		std::remove(path.c_str());
+	}
+
+	void WriteFile(const std::string& content) {
+		std::ofstream(path.c_str(), std::ios::binary) << content;
+	}
+
+	static std::string MakeContent(size_t size) {
+		std::string result;
+		for (size_t i = 0; result.size() < size; ++i)
+			result += Fmt() << i * 2654435761u << ' ';
+		return result.substr(0, size);
+	}
+
+	Shared<MockServer> mock;
+	const std::string path;
+	size_t body_size;
+	std::pair<std::string, std::string> uploaded;
+};
+
+TEST_F(TestFileUpload, SendsZippedFile) {
+	WriteFile("Hello, world!");
+	const Client client(kMockServerUrl, mock);
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	const std::string name = path.substr(path.rfind('/') + 1);
+	ASSERT_EQ("/remote/" + name, UploadFile(session, path));
+	ASSERT_EQ(name, uploaded.first);
+	ASSERT_EQ("Hello, world!", uploaded.second);
+	ASSERT_EQ(FileUploadBody(path).GetSize(), body_size);
+}
+
+TEST_F(TestFileUpload, StreamsLargeFileOverHttp) {
+	const std::string content = MakeContent(3000000);
+	WriteFile(content);
+	HttpServer server(mock);
+	const Client client(server.GetUrl());
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	UploadFile(session, path);
+	ASSERT_EQ(content, uploaded.second);
+	ASSERT_EQ(FileUploadBody(path).GetSize(), body_size);
+}
+
+TEST_F(TestFileUpload, ProducesBodyOfAnnouncedSize) {
+	WriteFile("");
+	ASSERT_EQ(FileUploadBody(path).GetSize(), [this] {
+		FileUploadBody body(path);
+		std::string result;
+		char buffer[7];
+		for (size_t read; (read = body.Read(buffer, sizeof(buffer))) > 0;)
+			result.append(buffer, read);
+		return result.size();
+	}());
+	WriteFile(MakeContent(200000));
+	FileUploadBody body(path);
+	size_t total = 0;
+	char buffer[1000];
+	for (size_t read; (read = body.Read(buffer, sizeof(buffer))) > 0;)
+		total += read;
+	ASSERT_EQ(body.GetSize(), total);
+}
+
+TEST_F(TestFileUpload, ThrowsIfFileChangesWithSameCompressedSize) {
+	WriteFile(std::string(100000, 'a'));
+	FileUploadBody body(path);
+	WriteFile(std::string(100000, 'b')); // Compresses to as many bytes
+	char buffer[1000];
+	ASSERT_THROW({
+		while (body.Read(buffer, sizeof(buffer)) > 0) {}
+	}, WebDriverException);
+}
+
+TEST_F(TestFileUpload, ThrowsIfFileIsMissing) {
+	const Client client(kMockServerUrl, mock);
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_THROW(UploadFile(session, "/tmp/webdriverxx-missing-file"), WebDriverException);
+}
+
+} // namespace test
+
+#endif
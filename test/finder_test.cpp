@@ -1,10 +1,12 @@
 #include "environment.h"
+#include "mock_server.h"
 #include <webdriverxx/webdriver.h>
 #include <gtest/gtest.h>
 
 namespace test {
 
 using namespace webdriverxx;
+using namespace webdriverxx::detail;
 
 class TestFinder : public ::testing::Test {
 protected:
@@ -102,4 +104,59 @@ TEST_F(TestFinder, OfElementFindsMoreThanOneInnerElement) {
 	ASSERT_EQ(2u, driver.FindElement(ById("outer")).FindElements(ByTag("div")).size());
 }
 
+TEST_F(TestFinder, FindsAllLocatorsAtOnce) {
+	std::vector<By> locators;
+	locators.push_back(ById("test_id"));
+	locators.push_back(ByClass("test_class"));
+	locators.push_back(ByCss("body div#css_selectable"));
+	locators.push_back(ByName("test_name"));
+	locators.push_back(ByLinkText("test link text"));
+	locators.push_back(ByPartialLinkText("link text"));
+	locators.push_back(ByXPath("//div[@id='outer']/div"));
+	locators.push_back(ByTag("non_existing"));
+	const auto found = driver.FindAll(locators);
+	ASSERT_EQ(locators.size(), found.size());
+	for (size_t i = 0; i < locators.size(); ++i)
+		ASSERT_EQ(driver.FindElements(locators[i]), found[i]) << locators[i].GetValue();
+}
+
+TEST_F(TestFinder, OfElementFindsAllInnerElementsAtOnce) {
+	const Element outer = driver.FindElement(ById("outer"));
+	std::vector<By> locators;
+	locators.push_back(ById("inner"));
+	locators.push_back(ByTag("div"));
+	locators.push_back(ById("outer"));
+	locators.push_back(ById("next_after_outer"));
+	const auto found = outer.FindAll(locators);
+	ASSERT_EQ(4u, found.size());
+	ASSERT_EQ(1u, found[0].size());
+	ASSERT_EQ(2u, found[1].size());
+	ASSERT_EQ(0u, found[2].size());
+	ASSERT_EQ(0u, found[3].size());
+}
+
+class TestFinderCommands : public MockSessionTest {};
+
+TEST_F(TestFinderCommands, FindsAllLocatorsInOneRequest) {
+	server->On("POST", MockServer::SessionPath("execute"), [](const std::string& data) {
+		const picojson::value args = ParseRequest(data);
+		EXPECT_TRUE(args.get("args").get(0).is<picojson::null>());
+		EXPECT_EQ("css selector", args.get("args").get(1).get(0).get(0).to_str());
+		const ElementRef refs[] = { { "1" }, { "2" } };
+		std::vector<std::vector<ElementRef>> result(2);
+		result[0].assign(refs, refs + 2);
+		return ToJson(result);
+	});
+	const unsigned requests_before = server->GetRequestCount();
+	std::vector<By> locators;
+	locators.push_back(ByCss("div"));
+	locators.push_back(ById("missing"));
+	const auto found = session.FindAll(locators);
+	ASSERT_EQ(1u, server->GetRequestCount() - requests_before);
+	ASSERT_EQ(2u, found.size());
+	ASSERT_EQ(2u, found[0].size());
+	ASSERT_EQ("2", found[0][1].GetRef());
+	ASSERT_TRUE(found[1].empty());
+}
+
 } // namespace test
@@ -0,0 +1,122 @@
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestFocusTracking : public MockSessionTest {
+protected:
+	TestFocusTracking() {
+		server->On("POST", MockServer::SessionPath("frame"), [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			switches.push_back(request.get("id").serialize());
+			return picojson::value();
+		});
+		server->On("POST", MockServer::SessionPath("frame/parent"), [this](const std::string&) {
+			switches.push_back("parent");
+			return picojson::value();
+		});
+		server->On("POST", MockServer::SessionPath("window"), [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			switches.push_back("window " + request.get("name").to_str());
+			return picojson::value();
+		});
+		server->On("DELETE", MockServer::SessionPath("window"), picojson::value());
+		server->On("POST", MockServer::SessionPath("url"), picojson::value());
+		server->On("POST", MockServer::SessionPath("execute"), picojson::value());
+		server->On("POST", MockServer::SessionPath("accept_alert"), picojson::value());
+	}
+
+	std::vector<std::string> TakeSwitches() {
+		std::vector<std::string> result;
+		result.swap(switches);
+		return result;
+	}
+
+	std::vector<std::string> switches;
+};
+
+TEST_F(TestFocusTracking, SkipsRedundantSwitchesToDefaultFrame) {
+	session.SetFocusToDefaultFrame().SetFocusToDefaultFrame().SetFocusToDefaultFrame();
+	ASSERT_EQ(std::vector<std::string>(1, "null"), TakeSwitches());
+	session.SetFocusToParentFrame();
+	ASSERT_TRUE(TakeSwitches().empty());
+}
+
+TEST_F(TestFocusTracking, SwitchesAgainAfterPageMayChange) {
+	session.SetFocusToFrame(0).Navigate("http://example.com/").SetFocusToDefaultFrame();
+	session.SetFocusToFrame(0).Execute("location.reload()").SetFocusToDefaultFrame();
+	session.SetFocusToFrame(0).AcceptAlert().SetFocusToDefaultFrame();
+	const std::vector<std::string> expected = { "0", "null", "0", "null", "0", "null" };
+	ASSERT_EQ(expected, TakeSwitches());
+}
+
+TEST_F(TestFocusTracking, KeepsTopFrameAfterPageMayChange) {
+	session.SetFocusToDefaultFrame();
+	session.Navigate("http://example.com/").SetFocusToDefaultFrame();
+	session.Execute("location.reload()").SetFocusToDefaultFrame();
+	session.AcceptAlert().SetFocusToParentFrame();
+	ASSERT_EQ(std::vector<std::string>(1, "null"), TakeSwitches());
+}
+
+TEST_F(TestFocusTracking, ElementCommandsForgetNestedFrame) {
+	server->On("POST", MockServer::SessionPath("element"), JsonObject().Set("ELEMENT", "e1"));
+	server->On("GET", MockServer::SessionPath("element/e1/text"), ToJson("Link"));
+	server->On("POST", MockServer::SessionPath("element/e1/click"), picojson::value());
+	const Element link = session.SetFocusToDefaultFrame().FindElement(ByTag("a"));
+	link.GetText();
+	link.Click();
+	session.SetFocusToDefaultFrame();
+	ASSERT_EQ(std::vector<std::string>(1, "null"), TakeSwitches());
+	const Element framed_link = session.SetFocusToFrame(0).FindElement(ByTag("a"));
+	framed_link.Click();
+	session.SetFocusToDefaultFrame();
+	const std::vector<std::string> expected = { "0", "null" };
+	ASSERT_EQ(expected, TakeSwitches());
+}
+
+TEST_F(TestFocusTracking, SwitchesOnlyMissingLevelsOfFramePath) {
+	session.SetFocusToFramePath({ "outer" });
+	std::vector<std::string> expected = { "null", "\"outer\"" };
+	ASSERT_EQ(expected, TakeSwitches());
+
+	session.SetFocusToFramePath({ "outer", 1 });
+	ASSERT_EQ(std::vector<std::string>(1, "1"), TakeSwitches());
+
+	session.SetFocusToFramePath({ "outer", 1 });
+	session.SetFocusToParentFrame().SetFocusToFramePath({ "outer" });
+	ASSERT_EQ(std::vector<std::string>(1, "parent"), TakeSwitches());
+
+	session.SetFocusToFramePath({ "other" });
+	expected = { "null", "\"other\"" };
+	ASSERT_EQ(expected, TakeSwitches());
+}
+
+TEST_F(TestFocusTracking, SkipsRedundantSwitchesToWindow) {
+	session.SetFocusToWindow("main").SetFocusToWindow("main");
+	session.SetFocusToFrame(0).SetFocusToWindow("main"); // Back to the top frame
+	session.SetFocusToDefaultFrame();
+	session.CloseCurrentWindow().SetFocusToWindow("main");
+	const std::vector<std::string> expected = {
+		"window main", "0", "window main", "window main" };
+	ASSERT_EQ(expected, TakeSwitches());
+}
+
+TEST_F(TestFocusTracking, SwitchesAgainAfterFailure) {
+	session.SetFocusToDefaultFrame();
+	server->On("POST", MockServer::SessionPath("frame"), [](const std::string&) -> picojson::value {
+		throw std::runtime_error("No such frame");
+	});
+	ASSERT_THROW(session.SetFocusToFrame("missing"), WebDriverException);
+	server->On("POST", MockServer::SessionPath("frame"), picojson::value());
+	const unsigned requests_before = server->GetRequestCount();
+	session.SetFocusToDefaultFrame();
+	ASSERT_EQ(1u, server->GetRequestCount() - requests_before);
+}
+
+} // namespace test
@@ -0,0 +1,118 @@
+#include "environment.h"
+#include "mock_server.h"
+#include <webdriverxx/webdriver.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestFormFillCommands : public MockSessionTest {
+protected:
+	TestFormFillCommands() {
+		fields.push_back(std::make_pair(ByName("user"), "alice"));
+		fields.push_back(std::make_pair(ByName("missing"), "x"));
+		fields.push_back(std::make_pair(ByName("locked"), "y"));
+	}
+
+	FormFields fields;
+};
+
+TEST_F(TestFormFillCommands, SetsValuesWithOneScript) {
+	std::string request;
+	server->On("POST", MockServer::SessionPath("execute"), [&request](const std::string& data) {
+		request = data;
+		picojson::value result;
+		picojson::parse(result, "[[0,\"\"],[1,\"\"],[2,\"Element is disabled\"]]");
+		return result;
+	});
+	const unsigned requests = server->GetRequestCount();
+	const std::vector<FormFieldResult> result = session.FillForm(fields, SetValues);
+	ASSERT_EQ(requests + 1, server->GetRequestCount());
+	ASSERT_NE(std::string::npos, request.find("[[\"name\",\"user\"],[\"name\",\"missing\"],[\"name\",\"locked\"]]"));
+	ASSERT_NE(std::string::npos, request.find("[\"alice\",\"x\",\"y\"]"));
+	ASSERT_EQ(3u, result.size());
+	ASSERT_EQ(FormFieldResult::Filled, result[0].status);
+	ASSERT_EQ(FormFieldResult::NotFound, result[1].status);
+	ASSERT_EQ(FormFieldResult::Failed, result[2].status);
+	ASSERT_EQ("Element is disabled", result[2].error);
+}
+
+TEST_F(TestFormFillCommands, TypesValuesIntoFoundFields) {
+	server->On("POST", MockServer::SessionPath("execute"), [](const std::string&) {
+		picojson::value result;
+		picojson::parse(result, "[[{\"ELEMENT\":\"e1\"}],[],[{\"ELEMENT\":\"e2\"}]]");
+		return result;
+	});
+	std::vector<std::string> commands;
+	server->On("POST", MockServer::SessionPath("element/e1/clear"), [&commands](const std::string&) {
+		commands.push_back("clear");
+		return picojson::value();
+	});
+	server->On("POST", MockServer::SessionPath("element/e1/value"), [&commands](const std::string& data) {
+		commands.push_back(data);
+		return picojson::value();
+	});
+	const std::vector<FormFieldResult> result = session.FillForm(fields);
+	ASSERT_EQ(2u, commands.size());
+	ASSERT_EQ("clear", commands[0]);
+	ASSERT_NE(std::string::npos, commands[1].find("alice"));
+	ASSERT_EQ(FormFieldResult::Filled, result[0].status);
+	ASSERT_EQ(FormFieldResult::NotFound, result[1].status);
+	ASSERT_EQ(FormFieldResult::Failed, result[2].status);
+	ASSERT_FALSE(result[2].error.empty());
+}
+
+class TestFormFill : public ::testing::Test {
+protected:
+	TestFormFill() : driver(GetDriver()) {
+		driver.Navigate(GetTestPageUrl("form.html"));
+	}
+
+	FormFields GetFields() {
+		FormFields result;
+		result.push_back(std::make_pair(ByName("user"), "alice"));
+		result.push_back(std::make_pair(ByName("about"), "Line"));
+		result.push_back(std::make_pair(ByName("locked"), "x"));
+		result.push_back(std::make_pair(ByName("missing"), "x"));
+		return result;
+	}
+
+	WebDriver driver;
+};
+
+TEST_F(TestFormFill, SetsValuesAndFiresEvents) {
+	FormFields fields = GetFields();
+	fields.push_back(std::make_pair(ByName("country"), "Germany"));
+	const std::vector<FormFieldResult> result = driver.FillForm(fields, SetValues);
+	ASSERT_EQ(FormFieldResult::Filled, result[0].status);
+	ASSERT_EQ(FormFieldResult::Failed, result[2].status);
+	ASSERT_EQ(FormFieldResult::NotFound, result[3].status);
+	ASSERT_EQ(FormFieldResult::Filled, result[4].status);
+	ASSERT_EQ("alice", driver.FindElement(ByName("user")).GetAttribute("value"));
+	ASSERT_EQ("de", driver.FindElement(ByName("country")).GetAttribute("value"));
+	ASSERT_EQ("user about country", driver.FindElement(ById("changes")).GetText());
+}
+
+TEST_F(TestFormFill, FailsOnlyFieldThatThrows) {
+	FormFields fields;
+	fields.push_back(std::make_pair(ByXPath("//form/text()"), "x")); // Not an element
+	fields.push_back(std::make_pair(ByName("user"), "alice"));
+	const std::vector<FormFieldResult> result = driver.FillForm(fields, SetValues);
+	ASSERT_EQ(FormFieldResult::Failed, result[0].status);
+	ASSERT_FALSE(result[0].error.empty());
+	ASSERT_EQ(FormFieldResult::Filled, result[1].status);
+	ASSERT_EQ("alice", driver.FindElement(ByName("user")).GetAttribute("value"));
+}
+
+TEST_F(TestFormFill, TypesValues) {
+	const std::vector<FormFieldResult> result = driver.FillForm(GetFields());
+	ASSERT_EQ(FormFieldResult::Filled, result[1].status);
+	ASSERT_EQ(FormFieldResult::NotFound, result[3].status);
+	ASSERT_EQ("Line", driver.FindElement(ByName("about")).GetAttribute("value"));
+}
+
+} // namespace test
@@ -54,6 +54,13 @@ TEST_F(TestFrames, CanSwitchToDeepFrames) {
 	ASSERT_EQ("frame2", driver.FindElement(ById("tag")).GetAttribute("value"));
 }
 
+TEST_F(TestFrames, CanSwitchToFramePath) {
+	driver.SetFocusToFramePath({ 0, 1 });
+	ASSERT_EQ("frame2", driver.FindElement(ById("tag")).GetAttribute("value"));
+	driver.SetFocusToFramePath({ 1 });
+	ASSERT_EQ("frame3", driver.FindElement(ById("tag")).GetAttribute("value"));
+}
+
 TEST_F(TestFrames, CanSwitchToParentFrame) {
 	if (IsPhantom()) return; // Not supported in PhantomJS 1.9.7
 	driver.SetFocusToFrame(0).SetFocusToFrame(1)
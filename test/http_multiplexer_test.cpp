@@ -0,0 +1,91 @@
+#include "http_server.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/cancellation.h>
+#include <webdriverxx/detail/http_multiplexer.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if WEBDRIVERXX_HAS_HTTP_MULTIPLEXER && !defined(_WIN32)
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+// The test server speaks HTTP/1.1 only, so these tests check
+// the request machinery, not multiplexing on the wire.
+
+class TestHttpMultiplexer : public ::testing::Test {
+protected:
+	TestHttpMultiplexer()
+		: mock(new MockServer)
+		, server(mock)
+	{
+		mock->On("GET", MockServer::SessionPath("title"), ToJson("Mock"));
+		mock->On("POST", MockServer::SessionPath("url"), [](const std::string& data) {
+			return picojson::value(data);
+		});
+	}
+
+	Shared<MockServer> mock;
+	HttpServer server;
+};
+
+TEST_F(TestHttpMultiplexer, CanBeCreated) {
+	HttpMultiplexer multiplexer;
+}
+
+TEST_F(TestHttpMultiplexer, SendsRequests) {
+	HttpMultiplexer multiplexer;
+	const std::string url = server.GetUrl() + MockServer::SessionPath();
+	ASSERT_EQ(200, multiplexer.Get(url + "/title").http_code);
+	const HttpResponse posted = multiplexer.Post(url + "/url", "{}");
+	ASSERT_EQ(200, posted.http_code);
+	ASSERT_NE(std::string::npos, posted.body.find("{}"));
+	ASSERT_EQ(200, multiplexer.Delete(url).http_code);
+	ASSERT_EQ(404, multiplexer.Get(url + "/missing").http_code);
+}
+
+TEST_F(TestHttpMultiplexer, SendsConcurrentRequests) {
+	HttpMultiplexer multiplexer;
+	const std::string url = server.GetUrl() + MockServer::SessionPath("url");
+	std::vector<std::thread> threads;
+	std::vector<std::string> bodies(16);
+	for (size_t i = 0; i < bodies.size(); ++i)
+		threads.push_back(std::thread([&multiplexer, &url, &bodies, i] {
+			for (int j = 0; j < 10; ++j)
+				bodies[i] = multiplexer.Post(url, Fmt() << i).body;
+		}));
+	for (auto& thread : threads)
+		thread.join();
+	for (size_t i = 0; i < bodies.size(); ++i)
+		ASSERT_NE(std::string::npos, bodies[i].find(Fmt() << "\"value\":\"" << i << "\"")) << bodies[i];
+	ASSERT_EQ(160u, mock->GetRequestCount());
+}
+
+TEST_F(TestHttpMultiplexer, ThrowsExceptionIfPortIsClosed) {
+	HttpMultiplexer multiplexer;
+	ASSERT_THROW(multiplexer.Get("http://127.0.0.1:7778/"), WebDriverException);
+}
+
+TEST_F(TestHttpMultiplexer, StopsAtDeadline) {
+	mock->SetLatencyMs(500);
+	HttpMultiplexer multiplexer;
+	const TimePoint start = Now();
+	const CancellationScope scope(CancellationToken::WithTimeoutMs(100));
+	ASSERT_THROW(multiplexer.Get(server.GetUrl() + MockServer::SessionPath("title")), WebDriverException);
+	ASSERT_GT(400u, Now() - start);
+}
+
+TEST_F(TestHttpMultiplexer, IsUsedByClient) {
+	const Client client(server.GetUrl(), ConnectionOptions().SetHttpVersion(http_version::Http2));
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_EQ("Mock", session.GetTitle());
+}
+
+} // namespace test
+
+#endif
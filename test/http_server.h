@@ -0,0 +1,267 @@
+#ifndef WEBDRIVERXX_HTTP_SERVER_H
+#define WEBDRIVERXX_HTTP_SERVER_H
+
+#ifndef _WIN32
+
+#include "mock_server.h"
+#include <webdriverxx/detail/error_handling.h>
+#include <webdriverxx/detail/gzip.h>
+#include <webdriverxx/detail/shared.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace test {
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+inline
+std::string Gunzip(const std::string& data) {
+	z_stream stream = {};
+	if (inflateInit2(&stream, 15 + 16) != Z_OK)
+		throw std::runtime_error("Cannot initialize zlib");
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	stream.avail_in = static_cast<uInt>(data.size());
+	std::string result;
+	int status = Z_OK;
+	while (status == Z_OK) {
+		char chunk[4096];
+		stream.next_out = reinterpret_cast<Bytef*>(chunk);
+		stream.avail_out = sizeof(chunk);
+		status = inflate(&stream, Z_NO_FLUSH);
+		result.append(chunk, sizeof(chunk) - stream.avail_out);
+	}
+	inflateEnd(&stream);
+	if (status != Z_STREAM_END)
+		throw std::runtime_error("Cannot decompress data");
+	return result;
+}
+
+#endif
+
+// Serves a MockServer over real HTTP/1.1 connections on a loopback
+// port or a Unix domain socket. Keeps connections alive, one thread
+// per connection. Decodes gzipped requests and gzips responses
+// if the client accepts that and WEBDRIVERXX_ENABLE_ZLIB is defined.
+class HttpServer { // noncopyable
+public:
+	explicit HttpServer(const webdriverxx::detail::Shared<MockServer>& mock)
+		: mock_(mock)
+		, listener_(::socket(AF_INET, SOCK_STREAM, 0))
+		, connections_(0)
+		, stopping_(false)
+	{
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t length = sizeof(address);
+		if (listener_ < 0 ||
+			::bind(listener_, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+			::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+			throw std::runtime_error("Cannot start HTTP server");
+		url_ = webdriverxx::detail::Fmt() << "http://127.0.0.1:" << ntohs(address.sin_port) << "/";
+		Start();
+	}
+
+	// Listens on a Unix domain socket, GetUrl() returns a "unix:" URL.
+	HttpServer(
+		const webdriverxx::detail::Shared<MockServer>& mock,
+		const std::string& unix_socket_path
+		)
+		: mock_(mock)
+		, listener_(::socket(AF_UNIX, SOCK_STREAM, 0))
+		, unix_socket_path_(unix_socket_path)
+		, connections_(0)
+		, stopping_(false)
+	{
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (unix_socket_path.size() >= sizeof(address.sun_path))
+			throw std::runtime_error("Unix socket path is too long");
+		strcpy(address.sun_path, unix_socket_path.c_str());
+		::unlink(unix_socket_path.c_str());
+		if (listener_ < 0 ||
+			::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+			throw std::runtime_error("Cannot start HTTP server");
+		url_ = "unix:" + unix_socket_path;
+		Start();
+	}
+
+	~HttpServer() {
+		stopping_ = true;
+		::shutdown(listener_, SHUT_RDWR);
+		acceptor_.join();
+		::close(listener_);
+		std::vector<std::thread> threads;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (const int socket : sockets_)
+				::shutdown(socket, SHUT_RDWR);
+			threads.swap(threads_);
+		}
+		for (auto& thread : threads)
+			thread.join();
+		if (!unix_socket_path_.empty())
+			::unlink(unix_socket_path_.c_str());
+	}
+
+	const std::string& GetUrl() const {
+		return url_;
+	}
+
+	unsigned GetConnectionCount() const {
+		return connections_;
+	}
+
+private:
+	void Start() {
+		if (::listen(listener_, 128) != 0)
+			throw std::runtime_error("Cannot start HTTP server");
+		acceptor_ = std::thread(&HttpServer::Accept, this);
+	}
+
+	void Accept() {
+		while (!stopping_) {
+			const int socket = ::accept(listener_, nullptr, nullptr);
+			if (socket < 0)
+				continue;
+			++connections_;
+			std::lock_guard<std::mutex> lock(mutex_);
+			sockets_.insert(socket);
+			threads_.push_back(std::thread(&HttpServer::Serve, this, socket));
+		}
+	}
+
+	void Serve(int socket) {
+		std::string buffer;
+		std::string method, path, header, body;
+		while (ReadRequest(socket, buffer, method, path, header, body)) {
+			const std::string url = kMockServerUrl + path.substr(1);
+			std::string encoding;
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+			if (GetHeader(header, "content-encoding") == "gzip")
+				body = Gunzip(body);
+#endif
+			webdriverxx::detail::HttpResponse response =
+				method == "GET" ? mock_->Get(url) :
+				method == "DELETE" ? mock_->Delete(url) :
+				mock_->Post(url, body);
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+			if (GetHeader(header, "accept-encoding").find("gzip") != std::string::npos) {
+				response.body = webdriverxx::detail::Gzip(response.body);
+				encoding = "Content-Encoding: gzip\r\n";
+			}
+#endif
+			const std::string reply = webdriverxx::detail::Fmt()
+				<< "HTTP/1.1 " << response.http_code << " Mock\r\n"
+				<< "Content-Type: application/json;charset=UTF-8\r\n"
+				<< encoding
+				<< "Content-Length: " << response.body.size() << "\r\n"
+				<< "\r\n"
+				<< response.body;
+			if (!WriteAll(socket, reply))
+				break;
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		sockets_.erase(socket);
+		::close(socket);
+	}
+
+	static
+	bool ReadRequest(
+		int socket,
+		std::string& buffer,
+		std::string& method,
+		std::string& path,
+		std::string& header,
+		std::string& body
+		) {
+		size_t header_end;
+		while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos)
+			if (!Receive(socket, buffer))
+				return false;
+		header = buffer.substr(0, header_end);
+		buffer.erase(0, header_end + 4);
+		const size_t method_end = header.find(' ');
+		const size_t path_end = header.find(' ', method_end + 1);
+		method = header.substr(0, method_end);
+		path = header.substr(method_end + 1, path_end - method_end - 1);
+		std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+		const size_t length = static_cast<size_t>(
+			std::strtoul(GetHeader(header, "content-length").c_str(), nullptr, 10));
+		while (buffer.size() < length)
+			if (!Receive(socket, buffer))
+				return false;
+		body = buffer.substr(0, length);
+		buffer.erase(0, length);
+		return true;
+	}
+
+	// The header should be in lower case.
+	static
+	std::string GetHeader(const std::string& header, const std::string& name) {
+		const size_t name_start = header.find("\r\n" + name + ":");
+		if (name_start == std::string::npos)
+			return std::string();
+		size_t value_start = name_start + name.size() + 3;
+		while (value_start < header.size() && header[value_start] == ' ')
+			++value_start;
+		return header.substr(value_start, header.find("\r\n", value_start) - value_start);
+	}
+
+	static
+	bool Receive(int socket, std::string& buffer) {
+		char chunk[4096];
+		const ssize_t size = ::recv(socket, chunk, sizeof(chunk), 0);
+		if (size <= 0)
+			return false;
+		buffer.append(chunk, static_cast<size_t>(size));
+		return true;
+	}
+
+	static
+	bool WriteAll(int socket, const std::string& data) {
+		for (size_t sent = 0; sent < data.size();) {
+			const ssize_t size = ::send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+			if (size <= 0)
+				return false;
+			sent += static_cast<size_t>(size);
+		}
+		return true;
+	}
+
+	HttpServer(HttpServer&);
+	HttpServer& operator = (HttpServer&);
+
+private:
+	const webdriverxx::detail::Shared<MockServer> mock_;
+	const int listener_;
+	const std::string unix_socket_path_;
+	std::string url_;
+	std::atomic<unsigned> connections_;
+	std::atomic<bool> stopping_;
+	std::mutex mutex_;
+	std::set<int> sockets_;
+	std::vector<std::thread> threads_;
+	std::thread acceptor_;
+};
+
+} // namespace test
+
+#endif // _WIN32
+
+#endif
@@ -0,0 +1,38 @@
+#include "images.h"
+#include <webdriverxx/image.h>
+#include <webdriverxx/detail/time.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(BenchmarkImage, FindInFullHdFrames) {
+	const Image frame = MakeScene(1920, 1080, 7);
+	const std::string screenshot = EncodeBase64(EncodePng(frame));
+	const int kFrames = 3;
+	TimePoint start = Now();
+	for (int i = 0; i < kFrames; ++i)
+		DecodeScreenshot(screenshot);
+	const double decode_ms = static_cast<double>(Now() - start) / kFrames;
+	const auto measure = [&frame, kFrames](const Image& pattern) {
+		const TimePoint start = Now();
+		for (int i = 0; i < kFrames; ++i)
+			EXPECT_EQ(1u, FindImage(frame, pattern).size());
+		return static_cast<double>(Now() - start) / kFrames;
+	};
+	const double icon_ms = measure(frame.Crop(1001, 555, 64, 64));
+	const double button_ms = measure(frame.Crop(333, 877, 160, 40));
+	std::cout << "1920x1080 frame: decoding " << decode_ms
+		<< " ms, finding a 64x64 icon " << icon_ms
+		<< " ms, a 160x40 button " << button_ms << " ms" << std::endl;
+}
+
+} // namespace test
+
+#endif
@@ -0,0 +1,55 @@
+#include "images.h"
+#include <webdriverxx/image_diff.h>
+#include <webdriverxx/detail/time.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(BenchmarkImageDiff, FullHdFrames) {
+	const Image page = MakePage(1920, 1080);
+	const std::string baseline = EncodePng(page);
+	Image changed = page;
+	for (int x = 500; x < 700; ++x)
+		Shift(changed, x, 300, 10);
+	const std::string actual = EncodePng(changed);
+	const int kPairs = 8;
+
+	TimePoint start = Now();
+	for (int i = 0; i < kPairs; ++i)
+		EXPECT_EQ(200u, DiffPngs(baseline, actual).mismatched_pixels);
+	const double sequential_ms = static_cast<double>(Now() - start) / kPairs;
+
+	const Image decoded_baseline = DecodePng(baseline);
+	const Image decoded_actual = DecodePng(actual);
+	start = Now();
+	for (int i = 0; i < kPairs; ++i)
+		DiffImages(decoded_baseline, decoded_actual);
+	const double pixels_ms = static_cast<double>(Now() - start) / kPairs;
+
+	const ImageComparer comparer;
+	start = Now();
+	std::vector<std::future<ImageDiff>> diffs;
+	for (int i = 0; i < kPairs; ++i)
+		diffs.push_back(comparer.Compare(baseline, actual));
+	for (auto& diff : diffs)
+		EXPECT_EQ(200u, diff.get().mismatched_pixels);
+	const double parallel_ms = static_cast<double>(Now() - start) / kPairs;
+
+	std::cout << "1920x1080 PNG pair: " << sequential_ms << " ms with decoding, "
+		<< pixels_ms << " ms comparing pixels only, "
+		<< parallel_ms << " ms per pair on " << ImageComparer::GetDefaultThreadCount()
+		<< " threads" << std::endl;
+}
+
+} // namespace test
+
+#endif
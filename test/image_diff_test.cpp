@@ -0,0 +1,127 @@
+#include "images.h"
+#include <webdriverxx/image_diff.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <string>
+#include <vector>
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(TestImageDiff, ReportsEqualImages) {
+	const Image page = MakePage(64, 48);
+	const ImageDiff diff = DiffImages(page, page);
+	ASSERT_TRUE(diff.same_size);
+	ASSERT_TRUE(diff.pixels_compared);
+	ASSERT_EQ(64u * 48, diff.compared_pixels);
+	ASSERT_EQ(0u, diff.mismatched_pixels);
+	ASSERT_EQ(0, diff.mismatch_ratio);
+	ASSERT_EQ(64, diff.mask.width);
+	ASSERT_EQ(-1, diff.hash_distance);
+}
+
+TEST(TestImageDiff, CountsPixelsBeyondTolerance) {
+	const Image page = MakePage(64, 48);
+	Image changed = page;
+	Shift(changed, 3, 4, 3);
+	Shift(changed, 63, 47, -1);
+	const ImageDiff diff = DiffImages(page, changed);
+	ASSERT_EQ(2u, diff.mismatched_pixels);
+	ASSERT_DOUBLE_EQ(2.0 / (64 * 48), diff.mismatch_ratio);
+	ASSERT_EQ(255, diff.mask.GetPixel(3, 4)[0]);
+	ASSERT_EQ(255, diff.mask.GetPixel(3, 4)[3]);
+	ASSERT_EQ(0, diff.mask.GetPixel(4, 4)[3]);
+	ASSERT_EQ(1u, DiffImages(page, changed, ImageDiffOptions().SetTolerance(2)).mismatched_pixels);
+	ASSERT_EQ(0u, DiffImages(page, changed, ImageDiffOptions().SetTolerance(3)).mismatched_pixels);
+	ASSERT_TRUE(DiffImages(page, changed, ImageDiffOptions().SetMakeMask(false)).mask.pixels.empty());
+}
+
+TEST(TestImageDiff, SkipsIgnoredRegions) {
+	const Image page = MakePage(64, 48);
+	Image changed = page;
+	Shift(changed, 10, 10, 50);
+	Shift(changed, 40, 30, 50);
+	const ImageDiff diff = DiffImages(page, changed, ImageDiffOptions()
+		.Ignore(Rect(5, 5, 10, 10))
+		.Ignore(Rect(10, 10, 10, 10)) // Overlaps the first one
+		.Ignore(Rect(60, 40, 100, 100))); // Goes beyond the image
+	ASSERT_EQ(1u, diff.mismatched_pixels);
+	ASSERT_EQ(64u * 48 - 175 - 32, diff.compared_pixels);
+	ASSERT_EQ(0, diff.mask.GetPixel(10, 10)[3]);
+	ASSERT_EQ(255, diff.mask.GetPixel(40, 30)[3]);
+}
+
+TEST(TestImageDiff, PrefiltersByPerceptualHash) {
+	const Image page = MakePage(640, 480);
+	Image changed = page;
+	Shift(changed, 100, 100, 1);
+	ASSERT_EQ(GetPerceptualHash(page), GetPerceptualHash(changed));
+	// Equal hashes don't hide the change
+	const ImageDiff similar = DiffImages(page, changed, ImageDiffOptions().SetMaxHashDistance(0));
+	ASSERT_TRUE(similar.pixels_compared);
+	ASSERT_EQ(0, similar.hash_distance);
+	ASSERT_EQ(1u, similar.mismatched_pixels);
+
+	Image inverted = page;
+	for (auto& channel : inverted.pixels)
+		channel = static_cast<unsigned char>(255 - channel);
+	const ImageDiff different = DiffImages(page, inverted, ImageDiffOptions().SetMaxHashDistance(5));
+	ASSERT_FALSE(different.pixels_compared);
+	ASSERT_GT(different.hash_distance, 5);
+	ASSERT_EQ(1, different.mismatch_ratio);
+	ASSERT_TRUE(different.mask.pixels.empty());
+}
+
+TEST(TestImageDiff, HashesWithoutIgnoredRegions) {
+	const Image page = MakePage(640, 480);
+	Image changed = page;
+	const Rect ad(0, 0, 320, 480);
+	for (int y = ad.y; y < ad.height; ++y)
+		for (int x = ad.x; x < ad.width; ++x)
+			for (int c = 0; c < 3; ++c)
+				changed.GetPixel(x, y)[c] = static_cast<unsigned char>(255 - changed.GetPixel(x, y)[c]);
+	ASSERT_GT(CountDifferentBits(GetPerceptualHash(page), GetPerceptualHash(changed)), 5);
+	const ImageDiff diff = DiffImages(page, changed, ImageDiffOptions()
+		.Ignore(ad)
+		.SetMaxHashDistance(5));
+	ASSERT_TRUE(diff.pixels_compared);
+	ASSERT_EQ(0, diff.hash_distance);
+	ASSERT_EQ(0u, diff.mismatched_pixels);
+}
+
+TEST(TestImageDiff, TreatsDifferentSizesAsDifferent) {
+	const ImageDiff diff = DiffImages(MakePage(64, 48), MakePage(64, 49));
+	ASSERT_FALSE(diff.same_size);
+	ASSERT_EQ(1, diff.mismatch_ratio);
+}
+
+TEST(TestImageDiff, DoesNotDecodeIdenticalFiles) {
+	ASSERT_TRUE(DiffPngs("not a png", "not a png").mask.pixels.empty());
+	ASSERT_THROW(DiffPngs("not a png", "not a png either"), WebDriverException);
+}
+
+TEST(TestImageDiff, ComparesInParallel) {
+	const Image page = MakePage(320, 240);
+	const std::string baseline = EncodePng(page);
+	const ImageComparer comparer(4);
+	std::vector<std::future<ImageDiff>> diffs;
+	for (int i = 0; i < 8; ++i) {
+		Image changed = page;
+		for (int x = 0; x < i; ++x)
+			Shift(changed, x, 0, 100);
+		diffs.push_back(comparer.Compare(baseline, EncodePng(changed)));
+	}
+	diffs.push_back(comparer.CompareScreenshot(baseline, EncodeBase64(baseline)));
+	for (size_t i = 0; i < 8; ++i)
+		ASSERT_EQ(i, diffs[i].get().mismatched_pixels);
+	ASSERT_EQ(0u, diffs[8].get().mismatched_pixels);
+	ASSERT_THROW(comparer.Compare(baseline, "broken").get(), WebDriverException);
+}
+
+} // namespace test
+
+#endif
@@ -0,0 +1,174 @@
+#include "images.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/image.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef WEBDRIVERXX_ENABLE_ZLIB
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+inline
+void Paste(const Image& pattern, Image& image, int x, int y) {
+	for (int row = 0; row < pattern.height; ++row)
+		std::copy(pattern.GetPixel(0, row), pattern.GetPixel(0, row) + pattern.width * 4,
+			image.GetPixel(x, y + row));
+}
+
+inline
+std::vector<int> GetPixels(const Image& image) {
+	return std::vector<int>(image.pixels.begin(), image.pixels.end());
+}
+
+TEST(TestImage, RoundTripsPng) {
+	const Image image = MakeScene(123, 45, 1);
+	const std::string png = EncodePng(image);
+	const Image decoded = DecodePng(png);
+	ASSERT_EQ(123, decoded.width);
+	ASSERT_EQ(45, decoded.height);
+	ASSERT_TRUE(image.pixels == decoded.pixels);
+	ASSERT_TRUE(image.pixels == DecodeScreenshot(EncodeBase64(png)).pixels);
+	ASSERT_LT(png.size(), image.pixels.size() / 4);
+}
+
+TEST(TestImage, DecodesAllFiltersAndColorTypes) {
+	// 3x5 RGB, rows use filters None, Sub, Up, Average and Paeth
+	const Image rgb = DecodeScreenshot("iVBORw0KGgoAAAANSUhEUgAAAAMAAAAFCAIAAAAPE8H1AAAANUlEQVR4nGNgYGB3E2Hv0WB"
+		"nlIsCsoyAiEkuikEuykguKoXZZguL0fYUo+21LCAxESM5kRQA1rcJ3HlfUF8AAAAASUVORK5CYII=");
+	ASSERT_EQ(3, rgb.width);
+	ASSERT_EQ(5, rgb.height);
+	const int expected[][3] = { {140, 40, 7}, {170, 130, 107}, {200, 220, 207}, {230, 54, 51}, {4, 144, 151} };
+	for (int y = 0; y < 5; ++y) {
+		const unsigned char* pixel = rgb.GetPixel(2, y);
+		ASSERT_EQ(expected[y][0], pixel[0]);
+		ASSERT_EQ(expected[y][1], pixel[1]);
+		ASSERT_EQ(expected[y][2], pixel[2]);
+		ASSERT_EQ(255, pixel[3]);
+	}
+	// 2-bit palette red, green, blue with transparent red: indices 2, 0, 1
+	const int palette[] = { 0, 0, 255, 255, 255, 0, 0, 0, 0, 255, 0, 255 };
+	ASSERT_EQ(std::vector<int>(palette, palette + 12), GetPixels(DecodeScreenshot(
+		"iVBORw0KGgoAAAANSUhEUgAAAAMAAAABAgMAAABmjvwnAAAACVBMVEX/AAAA/wAAAP8tSs2KAAAAAXRSTlMAQObYZgAA"
+		"AApJREFUeJxjaAEAAIYAhbz1zdYAAAAASUVORK5CYII=")));
+	// 16-bit gray 0x1234, 0xFFFF
+	const int gray16[] = { 0x12, 0x12, 0x12, 255, 255, 255, 255, 255 };
+	ASSERT_EQ(std::vector<int>(gray16, gray16 + 8), GetPixels(DecodeScreenshot(
+		"iVBORw0KGgoAAAANSUhEUgAAAAIAAAABEAAAAACB2fwVAAAADUlEQVR4nGMQMvn/HwAD5gJFLkKWdQAAAABJRU5ErkJggg==")));
+	// 1-bit gray 1, 0, 1
+	const int gray1[] = { 255, 255, 255, 255, 0, 0, 0, 255, 255, 255, 255, 255 };
+	ASSERT_EQ(std::vector<int>(gray1, gray1 + 12), GetPixels(DecodeScreenshot(
+		"iVBORw0KGgoAAAANSUhEUgAAAAMAAAABAQAAAAAzmykZAAAACklEQVR4nGNYAAAAogCh3I2xzAAAAABJRU5ErkJggg==")));
+	// 16-bit gray 0x1234, 0x1235 with transparent 0x1234
+	const int gray16_key[] = { 0x12, 0x12, 0x12, 0, 0x12, 0x12, 0x12, 255 };
+	ASSERT_EQ(std::vector<int>(gray16_key, gray16_key + 8), GetPixels(DecodeScreenshot(
+		"iVBORw0KGgoAAAANSUhEUgAAAAIAAAABEAAAAACB2fwVAAAAAnRSTlMSNC/TSV4AAAANSURBVHicYxAyETIFAAFCAI47CDOaAAAAAElFTkSuQmCC")));
+	// RGB (10, 20, 30), (10, 20, 31) with transparent (10, 20, 30)
+	const int rgb_key[] = { 10, 20, 30, 0, 10, 20, 31, 255 };
+	ASSERT_EQ(std::vector<int>(rgb_key, rgb_key + 8), GetPixels(DecodeScreenshot(
+		"iVBORw0KGgoAAAANSUhEUgAAAAIAAAABCAIAAAB7QOjdAAAABnRSTlMACgAUAB7FNin/AAAAD0lEQVR4nGPgEpHjEpEHAAGEAHqcn8DWAAAAAElFTkSuQmCC")));
+}
+
+TEST(TestImage, RejectsInvalidPng) {
+	ASSERT_THROW(DecodePng("GIF89a"), WebDriverException);
+	std::string png = EncodePng(MakeScene(10, 10, 1));
+	png[40] ^= 1;
+	ASSERT_THROW(DecodePng(png), WebDriverException);
+	ASSERT_THROW(DecodePng(png.substr(0, 50)), WebDriverException);
+	ASSERT_THROW(DecodeScreenshot("iVBO*"), WebDriverException);
+}
+
+TEST(TestImage, FindsPatternAtAnyOffset) {
+	const Image scene = MakeScene(400, 300, 2);
+	const Image pattern = scene.Crop(151, 97, 40, 30);
+	for (const int levels : { 0, 1, 4 }) {
+		const std::vector<ImageMatch> matches = FindImage(scene, pattern, ImageSearch().SetMaxLevels(levels));
+		ASSERT_EQ(1u, matches.size());
+		ASSERT_EQ(151, matches[0].top_left.x);
+		ASSERT_EQ(97, matches[0].top_left.y);
+		ASSERT_EQ(171, matches[0].center.x);
+		ASSERT_EQ(112, matches[0].center.y);
+		ASSERT_GT(matches[0].score, 0.999);
+	}
+}
+
+TEST(TestImage, FindsSeveralMatchesBestFirst) {
+	Image scene = MakeScene(400, 300, 3);
+	const Image pattern = scene.Crop(151, 97, 40, 30);
+	Paste(pattern, scene, 20, 21);
+	Image dimmed = pattern;
+	for (size_t i = 0; i < dimmed.pixels.size(); i += 4)
+		dimmed.pixels[i] = static_cast<unsigned char>(dimmed.pixels[i] / 2);
+	Paste(dimmed, scene, 301, 250);
+	const std::vector<ImageMatch> matches = FindImage(scene, pattern, ImageSearch().SetMaxMatches(10));
+	ASSERT_EQ(3u, matches.size());
+	ASSERT_EQ(301, matches[2].top_left.x);
+	ASSERT_EQ(250, matches[2].top_left.y);
+	ASSERT_LT(matches[2].score, matches[1].score);
+	ASSERT_EQ(2u, FindImage(scene, pattern, ImageSearch().SetMaxMatches(2)).size());
+	ASSERT_EQ(2u, FindImage(scene, pattern, ImageSearch().SetMaxMatches(10).SetThreshold(0.99)).size());
+}
+
+TEST(TestImage, FindsAllMatchesForHugeLimit) {
+	Image scene = MakeScene(400, 300, 6);
+	const Image pattern = scene.Crop(151, 97, 40, 30);
+	for (int row = 0; row < 3; ++row)
+		for (int column = 0; column < 4; ++column)
+			if (row != 1 || column != 1)
+				Paste(pattern, scene, 10 + column * 100, 10 + row * 100);
+	const std::vector<ImageMatch> matches = FindImage(scene, pattern, ImageSearch()
+		.SetMaxMatches(std::numeric_limits<size_t>::max()));
+	ASSERT_EQ(12u, matches.size()); // 11 pasted and the original
+}
+
+TEST(TestImage, FindsNothingIfPatternIsAbsent) {
+	const Image scene = MakeScene(400, 300, 4);
+	ASSERT_TRUE(FindImage(scene, MakeScene(400, 300, 5).Crop(151, 97, 40, 30)).empty());
+	ASSERT_TRUE(FindImage(scene.Crop(0, 0, 30, 30), scene.Crop(0, 0, 40, 30)).empty());
+	ASSERT_THROW(FindImage(scene, Image(20, 20)), WebDriverException);
+}
+
+class TestImageCommands : public MockSessionTest {};
+
+TEST_F(TestImageCommands, SessionFindsImageInCssPixels) {
+	const Image screen = MakeScene(200, 100, 6);
+	server->On("GET", MockServer::SessionPath("screenshot"), ToJson(EncodeBase64(EncodePng(screen))));
+	server->On("POST", MockServer::SessionPath("execute"), [](const std::string& data) {
+		const picojson::value request = ParseRequest(data);
+		if (request.get("script").to_str().find("devicePixelRatio") != std::string::npos)
+			return picojson::value(2.0);
+		picojson::array result;
+		result.push_back(JsonObject().Set("ELEMENT", "canvas"));
+		result.push_back(picojson::value(5.0));
+		result.push_back(picojson::value(7.0));
+		return picojson::value(result);
+	});
+	std::string moved;
+	server->On("POST", MockServer::SessionPath("moveto"), [&moved](const std::string& data) {
+		moved = data;
+		return picojson::value();
+	});
+
+	const std::vector<ImageMatch> matches = session.FindImage(screen.Crop(61, 33, 32, 24));
+	ASSERT_EQ(1u, matches.size());
+	ASSERT_EQ(30, matches[0].top_left.x);
+	ASSERT_EQ(16, matches[0].top_left.y);
+	ASSERT_EQ(38, matches[0].center.x);
+	ASSERT_EQ(22, matches[0].center.y);
+
+	session.MoveToPoint(matches[0].center);
+	const picojson::value request = ParseRequest(moved);
+	ASSERT_EQ("canvas", request.get("element").to_str());
+	ASSERT_EQ(5, request.get("xoffset").get<double>());
+	ASSERT_EQ(7, request.get("yoffset").get<double>());
+}
+
+} // namespace test
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef WEBDRIVERXX_IMAGES_H
+#define WEBDRIVERXX_IMAGES_H
+
+#include <webdriverxx/image.h>
+#include <algorithm>
+
+namespace test {
+
+// Rectangles of random colors and sizes over a gradient.
+inline
+webdriverxx::Image MakeScene(int width, int height, unsigned seed) {
+	webdriverxx::Image result(width, height);
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x) {
+			unsigned char* pixel = result.GetPixel(x, y);
+			pixel[0] = static_cast<unsigned char>(x * 255 / width);
+			pixel[1] = static_cast<unsigned char>(y * 255 / height);
+			pixel[2] = 128;
+			pixel[3] = 255;
+		}
+	unsigned state = seed;
+	const auto next = [&state]() -> int {
+		state = state * 1103515245 + 12345;
+		return static_cast<int>((state >> 16) & 0x7FFF);
+	};
+	for (int i = 0; i < width * height / 300; ++i) {
+		const int left = next() % width, top = next() % height;
+		const int right = std::min(width, left + 8 + next() % 60);
+		const int bottom = std::min(height, top + 8 + next() % 40);
+		const unsigned char color[] = {
+			static_cast<unsigned char>(next()),
+			static_cast<unsigned char>(next()),
+			static_cast<unsigned char>(next())
+		};
+		for (int y = top; y < bottom; ++y)
+			for (int x = left; x < right; ++x)
+				std::copy(color, color + 3, result.GetPixel(x, y));
+	}
+	return result;
+}
+
+// Horizontal stripes of shifting colors.
+inline
+webdriverxx::Image MakePage(int width, int height) {
+	webdriverxx::Image result(width, height);
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x) {
+			unsigned char* pixel = result.GetPixel(x, y);
+			pixel[0] = static_cast<unsigned char>((y / 10) * 40 + x / 8);
+			pixel[1] = static_cast<unsigned char>(x * 255 / width);
+			pixel[2] = static_cast<unsigned char>(y % 20 < 10 ? 30 : 220);
+			pixel[3] = 255;
+		}
+	return result;
+}
+
+// Changes the green channel of a pixel.
+inline
+void Shift(webdriverxx::Image& image, int x, int y, int delta) {
+	unsigned char* pixel = image.GetPixel(x, y);
+	pixel[1] = static_cast<unsigned char>(pixel[1] + delta);
+}
+
+} // namespace test
+
+#endif
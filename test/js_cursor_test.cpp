@@ -0,0 +1,149 @@
+#include "environment.h"
+#include "mock_server.h"
+#include <webdriverxx/webdriver.h>
+#include <webdriverxx/js_cursor.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestJsCursor : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		GetDriver().Navigate(GetTestPageUrl("js.html"));
+	}
+
+	TestJsCursor() : driver(GetDriver()) {}
+
+	WebDriver driver;
+};
+
+TEST_F(TestJsCursor, ReadsWholeArrayInPages) {
+	const JsCursor<int> cursor(driver,
+		"var a = []; for (var i = 0; i < arguments[0]; ++i) a.push(i); return a;",
+		JsArgs() << 2500, 1000);
+	ASSERT_EQ(2500u, cursor.GetSize());
+	std::vector<int> page;
+	std::vector<size_t> page_sizes;
+	int expected = 0;
+	while (cursor.Next(page)) {
+		page_sizes.push_back(page.size());
+		for (int value : page)
+			ASSERT_EQ(expected++, value);
+	}
+	ASSERT_EQ(2500, expected);
+	ASSERT_EQ(3u, page_sizes.size());
+	ASSERT_EQ(500u, page_sizes[2]);
+	ASSERT_TRUE(cursor.IsAtEnd());
+}
+
+TEST_F(TestJsCursor, LimitsPageBytes) {
+	const JsCursor<std::string> cursor(driver,
+		"var a = []; for (var i = 0; i < 10; ++i) a.push(new Array(101).join('x')); return a;",
+		JsArgs(), 1000, 350);
+	std::vector<std::string> page;
+	ASSERT_TRUE(cursor.Next(page));
+	ASSERT_EQ(3u, page.size());
+	ASSERT_EQ(std::string(100, 'x'), page[0]);
+}
+
+TEST_F(TestJsCursor, ReturnsOversizedItemAlone) {
+	const JsCursor<std::string> cursor(driver,
+		"return [new Array(101).join('x'), 'y'];", JsArgs(), 1000, 10);
+	std::vector<std::string> page;
+	ASSERT_TRUE(cursor.Next(page));
+	ASSERT_EQ(1u, page.size());
+	ASSERT_TRUE(cursor.Next(page));
+	ASSERT_EQ("y", page[0]);
+	ASSERT_FALSE(cursor.Next(page));
+}
+
+TEST_F(TestJsCursor, ReleasesArrayInBrowser) {
+	JsCursor<int> cursor(driver, "return [1, 2, 3];");
+	const std::string count_script =
+		"var c = window.__webdriverxx_cursors || {};"
+		"return Object.keys(c).length - ('next_id' in c ? 1 : 0);";
+	const int before = driver.Eval<int>(count_script);
+	JsCursor<int>(driver, "return [1, 2, 3];").Close();
+	ASSERT_EQ(before, driver.Eval<int>(count_script));
+	cursor.ForEach([](int) {});
+	ASSERT_EQ(before - 1, driver.Eval<int>(count_script));
+}
+
+TEST_F(TestJsCursor, HandlesEmptyArray) {
+	const JsCursor<int> cursor(driver, "return [];");
+	ASSERT_EQ(0u, cursor.GetSize());
+	ASSERT_TRUE(cursor.IsAtEnd());
+	std::vector<int> page;
+	ASSERT_FALSE(cursor.Next(page));
+}
+
+TEST_F(TestJsCursor, ThrowsIfScriptDoesNotReturnArray) {
+	ASSERT_THROW(JsCursor<int>(driver, "return 1;"), WebDriverException);
+}
+
+class TestJsCursorPages : public MockSessionTest {
+protected:
+	TestJsCursorPages()
+		: closed(std::make_shared<int>(0))
+	{
+		const std::shared_ptr<int> closed_count = closed;
+		const std::shared_ptr<int> next = std::make_shared<int>(0);
+		// Emulates the browser side of a cursor over 2500 numbers
+		server->On("POST", MockServer::SessionPath("execute"), [closed_count, next](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			const std::string script = FromJson<std::string>(request.get("script"));
+			const picojson::value& args = request.get("args");
+			const int kTotal = 2500;
+			if (script.find("cursors[id] =") != std::string::npos)
+				return static_cast<picojson::value>(JsonObject()
+					.Set("id", "1")
+					.Set("size", kTotal));
+			if (script == kCloseJsCursorScript) {
+				++*closed_count;
+				return picojson::value();
+			}
+			std::vector<int> page;
+			for (int i = 0; i < FromJson<int>(args.get(1)) && *next < kTotal; ++i)
+				page.push_back((*next)++);
+			return ToJson(page);
+		});
+	}
+
+	std::shared_ptr<int> closed;
+};
+
+TEST_F(TestJsCursorPages, TransfersOnePagePerRequest) {
+	const JsCursor<int> cursor(session, "return huge;", JsArgs(), 1000);
+	const unsigned requests_before = server->GetRequestCount();
+	std::vector<int> page;
+	ASSERT_TRUE(cursor.Next(page));
+	ASSERT_EQ(1u, server->GetRequestCount() - requests_before);
+	ASSERT_EQ(1000u, page.size());
+	ASSERT_EQ(0, *closed);
+}
+
+TEST_F(TestJsCursorPages, ClosesCursorAfterLastPage) {
+	const JsCursor<int> cursor(session, "return huge;", JsArgs(), 1000);
+	int sum = 0;
+	cursor.ForEach([&sum](int value) { sum += value; });
+	ASSERT_EQ(2500 * 2499 / 2, sum);
+	ASSERT_EQ(1, *closed);
+}
+
+TEST_F(TestJsCursorPages, ClosesCursorOnDestruction) {
+	{
+		const JsCursor<int> cursor(session, "return huge;");
+		const JsCursor<int> copy = cursor;
+		std::vector<int> page;
+		copy.Next(page);
+	}
+	ASSERT_EQ(1, *closed);
+}
+
+} // namespace test
@@ -0,0 +1,179 @@
+#ifndef WEBDRIVERXX_MOCK_SERVER_H
+#define WEBDRIVERXX_MOCK_SERVER_H
+
+#include <webdriverxx/detail/http_client.h>
+#include <webdriverxx/detail/shared.h>
+#include <webdriverxx/detail/time.h>
+#include <webdriverxx/cancellation.h>
+#include <webdriverxx/client.h>
+#include <webdriverxx/conversions.h>
+#include <gtest/gtest.h>
+#include <picojson.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace test {
+
+const char* const kMockServerUrl = "http://mock/";
+const char* const kMockSessionId = "mock-session";
+
+// In-process stand-in for a WebDriver server. Answers requests
+// with preconfigured values after a configurable delay.
+class MockServer
+	: public webdriverxx::detail::IHttpClient
+	, public webdriverxx::detail::SharedObjectBase
+{
+public:
+	typedef std::function<picojson::value(const std::string& data)> Handler;
+
+	// Thrown by handlers to fail the command with a status, like a server does.
+	struct CommandError {
+		webdriverxx::response_status_code::Value status;
+		std::string message;
+	};
+
+	explicit MockServer(webdriverxx::Duration latency_ms = 0)
+		: latency_ms_(latency_ms)
+		, requests_(0)
+		, concurrent_(0)
+		, max_concurrent_(0)
+	{
+		On("POST", "session", picojson::value(picojson::object()));
+		On("DELETE", SessionPath(), picojson::value());
+	}
+
+	static std::string SessionPath(const std::string& command = std::string()) {
+		const std::string path = std::string("session/") + kMockSessionId;
+		return command.empty() ? path : path + "/" + command;
+	}
+
+	void SetLatencyMs(webdriverxx::Duration latency_ms) {
+		latency_ms_ = latency_ms;
+	}
+
+	void On(const std::string& method, const std::string& path, const Handler& handler) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		handlers_[method + " " + path] = handler;
+	}
+
+	void On(const std::string& method, const std::string& path, const picojson::value& value) {
+		On(method, path, [value](const std::string&) { return value; });
+	}
+
+	unsigned GetRequestCount() const {
+		return requests_;
+	}
+
+	// Highest number of requests that were being answered at the same time.
+	unsigned GetMaxConcurrentRequests() const {
+		return max_concurrent_;
+	}
+
+	webdriverxx::detail::HttpResponse Get(const std::string& url) const {
+		return Respond("GET", url, std::string());
+	}
+
+	webdriverxx::detail::HttpResponse Delete(const std::string& url) const {
+		return Respond("DELETE", url, std::string());
+	}
+
+	webdriverxx::detail::HttpResponse Post(const std::string& url, const std::string& data) const {
+		return Respond("POST", url, data);
+	}
+
+private:
+	webdriverxx::detail::HttpResponse Respond(
+		const std::string& method,
+		const std::string& url,
+		const std::string& data
+		) const {
+		++requests_;
+		const ConcurrencyCounter counter(*this);
+		webdriverxx::detail::Sleep(latency_ms_);
+		// Like HttpConnection, fails requests that are cancelled
+		webdriverxx::CancellationContext::Capture().ThrowIfCancelled();
+		const std::string path = url.substr(std::string(kMockServerUrl).length());
+		Handler handler;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			const auto it = handlers_.find(method + " " + path);
+			if (it != handlers_.end())
+				handler = it->second;
+		}
+		webdriverxx::detail::HttpResponse response;
+		if (!handler) {
+			response.http_code = 404;
+			response.body = method + " " + path + " is not mocked";
+			return response;
+		}
+		int status = webdriverxx::response_status_code::kSuccess;
+		picojson::value value;
+		try {
+			value = handler(data);
+			response.http_code = 200;
+		} catch (const CommandError& error) {
+			status = error.status;
+			value = webdriverxx::JsonObject().Set("message", error.message);
+			response.http_code = 500;
+		}
+		response.body = static_cast<const picojson::value&>(webdriverxx::JsonObject()
+			.Set("sessionId", kMockSessionId)
+			.Set("status", status)
+			.Set("value", value)
+			).serialize();
+		return response;
+	}
+
+	class ConcurrencyCounter {
+	public:
+		explicit ConcurrencyCounter(const MockServer& server) : server_(server) {
+			const unsigned concurrent = ++server_.concurrent_;
+			unsigned max = server_.max_concurrent_;
+			while (concurrent > max && !server_.max_concurrent_.compare_exchange_weak(max, concurrent)) {}
+		}
+
+		~ConcurrencyCounter() {
+			--server_.concurrent_;
+		}
+
+	private:
+		const MockServer& server_;
+	};
+
+private:
+	std::atomic<webdriverxx::Duration> latency_ms_;
+	mutable std::atomic<unsigned> requests_;
+	mutable std::atomic<unsigned> concurrent_;
+	mutable std::atomic<unsigned> max_concurrent_;
+	mutable std::mutex mutex_;
+	std::map<std::string, Handler> handlers_;
+};
+
+// Parses the JSON body of a request received by a MockServer handler.
+inline picojson::value ParseRequest(const std::string& data) {
+	picojson::value result;
+	const std::string error = picojson::parse(result, data);
+	EXPECT_EQ("", error) << data;
+	return result;
+}
+
+// Fixture of tests that run commands of a session against a MockServer.
+class MockSessionTest : public ::testing::Test {
+protected:
+	explicit MockSessionTest(webdriverxx::Duration latency_ms = 0)
+		: server(new MockServer(latency_ms))
+		, client(kMockServerUrl, server)
+		, session(client.CreateSession(webdriverxx::Capabilities(), webdriverxx::Capabilities()))
+	{}
+
+	webdriverxx::detail::Shared<MockServer> server;
+	webdriverxx::Client client;
+	webdriverxx::Session session;
+};
+
+} // namespace test
+
+#endif
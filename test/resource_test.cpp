@@ -360,4 +360,70 @@ TEST_F(TestResource, ThrowsOnMissingValue)
 	ASSERT_THROW(resource.Get("command"), WebDriverException);
 }
 
+// Retries
+
+TEST_F(TestResource, DoesNotRetryByDefault)
+{
+	EXPECT_CALL(*http_client, Get(_)).WillOnce(Throw(WebDriverException("HTTP failed")));
+	Resource resource(kTestUrl, http_client);
+	ASSERT_THROW(resource.Get("command"), WebDriverException);
+	ASSERT_EQ(0u, resource.GetTransport()->GetMetrics()->GetSnapshot().retries);
+}
+
+TEST_F(TestResource, RetriesSafeRequestsAfterTransportErrors)
+{
+	Resource resource(kTestUrl, http_client);
+	resource.GetTransport()->SetRetryPolicy(RetryPolicy(3, 0));
+	EXPECT_CALL(*http_client, Get(_))
+		.WillOnce(Throw(WebDriverException("HTTP failed")))
+		.WillOnce(Throw(WebDriverException("HTTP failed")))
+		.WillOnce(ReturnPointee(&http_response));
+	ASSERT_EQ(12345, resource.Get("command").get<double>());
+	const Metrics metrics = resource.GetTransport()->GetMetrics()->GetSnapshot();
+	ASSERT_EQ(3u, metrics.requests);
+	ASSERT_EQ(2u, metrics.retries);
+}
+
+TEST_F(TestResource, RetriesElementLookupsAfterGatewayErrors)
+{
+	Resource resource(kTestUrl, http_client);
+	resource.GetTransport()->SetRetryPolicy(RetryPolicy(2, 0));
+	HttpResponse bad_gateway;
+	bad_gateway.http_code = 502;
+	EXPECT_CALL(*http_client, Post(_,_))
+		.WillOnce(Return(bad_gateway))
+		.WillOnce(ReturnPointee(&http_response));
+	ASSERT_EQ(12345, resource.Post("element").get<double>());
+}
+
+TEST_F(TestResource, GivesUpAfterMaxAttempts)
+{
+	Resource resource(kTestUrl, http_client);
+	resource.GetTransport()->SetRetryPolicy(RetryPolicy(2, 0));
+	http_response.http_code = 503;
+	EXPECT_CALL(*http_client, Get(_)).Times(2);
+	ASSERT_THROW(resource.Get("command"), WebDriverException);
+}
+
+TEST_F(TestResource, DoesNotRetryUnsafeRequests)
+{
+	Resource resource(kTestUrl, http_client);
+	resource.GetTransport()->SetRetryPolicy(RetryPolicy(3, 0));
+	EXPECT_CALL(*http_client, Post(_,_)).WillOnce(Throw(WebDriverException("HTTP failed")));
+	ASSERT_THROW(resource.Post("click"), WebDriverException);
+	ASSERT_FALSE(IsSafeToRepeat("POST", "execute"));
+	ASSERT_FALSE(IsSafeToRepeat("POST", "url"));
+	ASSERT_TRUE(IsSafeToRepeat("GET", "title"));
+}
+
+TEST_F(TestResource, DoesNotRetryOtherServerErrors)
+{
+	Resource resource(kTestUrl, http_client);
+	resource.GetTransport()->SetRetryPolicy(RetryPolicy(3, 0));
+	http_response.http_code = 500;
+	http_response.body = "{\"sessionId\":\"123\",\"status\":13,\"value\":{\"message\":\"Failed\"}}";
+	EXPECT_CALL(*http_client, Get(_)).Times(1);
+	ASSERT_THROW(resource.Get("command"), WebDriverException);
+}
+
 } // namespace test
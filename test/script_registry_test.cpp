@@ -0,0 +1,102 @@
+#include "environment.h"
+#include "mock_server.h"
+#include <webdriverxx/webdriver.h>
+#include <webdriverxx/script_registry.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestScriptRegistryCalls : public MockSessionTest {
+protected:
+	TestScriptRegistryCalls()
+		: installed(false)
+		, installs(0)
+		, calls(0)
+		, max_call_size(0)
+	{
+		// Emulates a page: functions are kept until the next navigation
+		server->On("POST", MockServer::SessionPath("execute"), [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			const std::string script = request.get("script").to_str();
+			const picojson::value& args = request.get("args");
+			if (script.find("=[") != std::string::npos) {
+				installed = true;
+				++installs;
+				return picojson::value(picojson::array(1, args.get(0)));
+			}
+			++calls;
+			max_call_size = std::max(max_call_size, data.size());
+			return installed ? picojson::value(picojson::array(1, args.get(0))) : picojson::value(0.0);
+		});
+		server->On("POST", MockServer::SessionPath("url"), [this](const std::string&) {
+			installed = false;
+			return picojson::value();
+		});
+		registry.Add("echo", "function(x) { return x; /* " + std::string(40000, '.') + " */ }");
+	}
+
+	ScriptRegistry registry;
+	bool installed;
+	int installs;
+	int calls;
+	size_t max_call_size;
+};
+
+TEST_F(TestScriptRegistryCalls, InstallsFunctionsOncePerDocument) {
+	for (int i = 0; i < 3; ++i)
+		ASSERT_EQ(i, registry.Eval<int>(session, "echo", JsArgs() << i));
+	ASSERT_EQ(1, installs);
+	session.Navigate("http://example.com/");
+	ASSERT_EQ("abc", registry.Eval<std::string>(session, "echo", JsArgs() << "abc"));
+	registry.Execute(session, "echo", JsArgs() << 1);
+	ASSERT_EQ(2, installs);
+	ASSERT_EQ(5, calls);
+}
+
+TEST_F(TestScriptRegistryCalls, UploadsOnlyIndexOfFunction) {
+	registry.Eval<int>(session, "echo", JsArgs() << 1);
+	registry.Eval<int>(session, "echo", JsArgs() << 1);
+	ASSERT_GT(200u, max_call_size);
+}
+
+TEST_F(TestScriptRegistryCalls, InstallsChangedLibraryAgain) {
+	registry.Execute(session, "echo", JsArgs() << 1);
+	ScriptRegistry other = registry;
+	other.Add("sum", "function(a, b) { return a + b; }");
+	installed = false; // The page has only the first library
+	other.Execute(session, "echo", JsArgs() << 1);
+	ASSERT_EQ(2, installs);
+}
+
+TEST_F(TestScriptRegistryCalls, RejectsUnknownAndDuplicateNames) {
+	ASSERT_TRUE(registry.Contains("echo"));
+	ASSERT_FALSE(registry.Contains("sum"));
+	ASSERT_THROW(registry.Execute(session, "sum"), WebDriverException);
+	ASSERT_THROW(registry.Add("echo", "function() {}"), WebDriverException);
+}
+
+class TestScriptRegistry : public ::testing::Test {
+protected:
+	TestScriptRegistry() : driver(GetDriver()) {}
+
+	WebDriver driver;
+};
+
+TEST_F(TestScriptRegistry, CallsFunctionsAfterReload) {
+	ScriptRegistry registry;
+	registry
+		.Add("sum", "function(a, b) { return a + b; }")
+		.Add("title", "function() { return document.title; }");
+	driver.Navigate(GetTestPageUrl("js.html"));
+	ASSERT_EQ(3, registry.Eval<int>(driver, "sum", JsArgs() << 1 << 2));
+	const std::string title = registry.Eval<std::string>(driver, "title");
+	driver.Refresh();
+	ASSERT_EQ(title, registry.Eval<std::string>(driver, "title"));
+	ASSERT_EQ(7, registry.Eval<int>(driver, "sum", JsArgs() << 3 << 4));
+}
+
+} // namespace test
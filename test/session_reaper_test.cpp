@@ -0,0 +1,127 @@
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/session_reaper.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestSessionReaper : public MockSessionTest {
+protected:
+	TestSessionReaper()
+		: deletions(0)
+		, released(false)
+	{}
+
+	void OnDelete(int failures) {
+		server->On("DELETE", MockServer::SessionPath(), [this, failures](const std::string&) {
+			if (++deletions <= failures)
+				throw std::runtime_error("Connection reset");
+			return picojson::value();
+		});
+	}
+
+	void CreateAndReleaseSession() {
+		client.CreateSession(Capabilities(), Capabilities());
+	}
+
+	std::atomic<int> deletions;
+	std::atomic<bool> released;
+};
+
+TEST_F(TestSessionReaper, DeletesSessionsInBackground) {
+	// The deletion can't finish before the release has returned
+	server->On("DELETE", MockServer::SessionPath(), [this](const std::string&) {
+		const TimePoint deadline = Now() + 5000;
+		while (!released && Now() < deadline)
+			Sleep(1);
+		++deletions;
+		return picojson::value();
+	});
+	const Shared<SessionReaper> reaper(new SessionReaper);
+	client.SetSessionReaper(reaper);
+	CreateAndReleaseSession();
+	ASSERT_EQ(0, deletions);
+	released = true;
+	ASSERT_TRUE(reaper->Flush(5000));
+	ASSERT_EQ(1, deletions);
+	const ReaperReport report = reaper->GetReport();
+	ASSERT_EQ(1u, report.queued);
+	ASSERT_EQ(1u, report.deleted);
+	ASSERT_EQ(0u, report.pending);
+	ASSERT_EQ(0u, report.GetLeaked());
+}
+
+TEST_F(TestSessionReaper, RetriesFailedDeletions) {
+	OnDelete(2);
+	const Shared<SessionReaper> reaper(new SessionReaper(ReaperOptions().SetBackoffMs(10)));
+	client.SetSessionReaper(reaper);
+	CreateAndReleaseSession();
+	ASSERT_TRUE(reaper->Flush(5000));
+	ASSERT_EQ(3, deletions);
+	ASSERT_EQ(1u, reaper->GetReport().deleted);
+}
+
+TEST_F(TestSessionReaper, ReportsLeakedSessions) {
+	OnDelete(100);
+	const Shared<SessionReaper> reaper(new SessionReaper(ReaperOptions()
+		.SetMaxAttempts(2)
+		.SetBackoffMs(10)));
+	client.SetSessionReaper(reaper);
+	CreateAndReleaseSession();
+	CreateAndReleaseSession();
+	ASSERT_TRUE(reaper->Flush(5000));
+	ASSERT_EQ(4, deletions);
+	const ReaperReport report = reaper->GetReport();
+	ASSERT_EQ(0u, report.deleted);
+	ASSERT_EQ(2u, report.failed);
+	ASSERT_EQ(2u, report.GetLeaked());
+}
+
+TEST_F(TestSessionReaper, ReportsTimedOutDeletions) {
+	const Shared<SessionReaper> reaper(new SessionReaper(ReaperOptions()
+		.SetMaxAttempts(1)
+		.SetAttemptTimeoutMs(50)));
+	client.SetSessionReaper(reaper);
+	{
+		const Session session = client.CreateSession(Capabilities(), Capabilities());
+		server->SetLatencyMs(200);
+	}
+	ASSERT_TRUE(reaper->Flush(5000));
+	ASSERT_EQ(1u, reaper->GetReport().timed_out);
+}
+
+TEST_F(TestSessionReaper, CancelsDeletionsOnDestruction) {
+	OnDelete(100);
+	ReaperReport report;
+	TimePoint start = 0;
+	{
+		Shared<SessionReaper> reaper(new SessionReaper(ReaperOptions()
+			.SetBackoffMs(60000)
+			.SetFlushTimeoutMs(50)));
+		reaper->SetReportHandler([&report](const ReaperReport& final_report) {
+			report = final_report;
+		});
+		client.SetSessionReaper(reaper);
+		CreateAndReleaseSession();
+		client.SetSessionReaper(Shared<SessionReaper>());
+		start = Now();
+	}
+	ASSERT_GT(5000u, Now() - start);
+	ASSERT_EQ(1u, report.queued);
+	ASSERT_EQ(1u, report.timed_out);
+	ASSERT_EQ(0u, report.pending);
+}
+
+TEST_F(TestSessionReaper, EmptyReaperDeletesSynchronously) {
+	OnDelete(0);
+	client.SetSessionReaper(Shared<SessionReaper>());
+	CreateAndReleaseSession();
+	ASSERT_EQ(1, deletions);
+}
+
+} // namespace test
@@ -0,0 +1,119 @@
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/session_registry.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestSessionReuse : public MockSessionTest {
+protected:
+	TestSessionReuse()
+		: registry_path("webdriverxx-session-registry-test.txt")
+		, created(0)
+		, deleted(0)
+	{
+		std::remove(registry_path.c_str());
+		server->On("POST", "session", [this](const std::string&) {
+			++created;
+			return picojson::value(picojson::object());
+		});
+		server->On("DELETE", MockServer::SessionPath(), [this](const std::string&) {
+			++deleted;
+			return picojson::value();
+		});
+		server->On("GET", MockServer::SessionPath("url"), ToJson("about:blank"));
+	}
+
+	~TestSessionReuse() {
+		std::remove(registry_path.c_str());
+		std::remove((registry_path + ".lock").c_str());
+	}
+
+	const std::string registry_path;
+	std::atomic<int> created;
+	std::atomic<int> deleted;
+};
+
+TEST_F(TestSessionReuse, AttachesWithoutOwnership) {
+	{
+		const Session session = client.AttachSession(kMockSessionId);
+		ASSERT_EQ(kMockSessionId, session.GetId());
+		ASSERT_EQ("about:blank", session.GetUrl());
+	}
+	ASSERT_EQ(0, deleted);
+	ASSERT_THROW(client.AttachSession(""), WebDriverException);
+}
+
+TEST_F(TestSessionReuse, KeepsPersistentSessions) {
+	client.CreatePersistentSession(Capabilities(), Capabilities());
+	ASSERT_EQ(0, deleted);
+	client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_EQ(1, deleted);
+}
+
+TEST_F(TestSessionReuse, ReusesReleasedSessions) {
+	const SessionRegistry registry(registry_path);
+	{
+		const Session session = registry.Acquire(client, "chrome", Capabilities());
+		ASSERT_EQ(1, created);
+		registry.Release("chrome", session);
+	}
+	ASSERT_EQ(1u, registry.GetIdleSessionIds("chrome").size());
+	// As if from another process
+	const Session session = SessionRegistry(registry_path).Acquire(client, "chrome", Capabilities());
+	ASSERT_EQ(kMockSessionId, session.GetId());
+	ASSERT_EQ(1, created);
+	ASSERT_EQ(0, deleted);
+	ASSERT_TRUE(registry.GetIdleSessionIds("chrome").empty());
+}
+
+TEST_F(TestSessionReuse, SeparatesKeys) {
+	const SessionRegistry registry(registry_path);
+	registry.Release("firefox", client.AttachSession(kMockSessionId));
+	registry.Acquire(client, "chrome", Capabilities());
+	ASSERT_EQ(1, created);
+	ASSERT_EQ(1u, registry.GetIdleSessionIds("firefox").size());
+	ASSERT_THROW(registry.Release("a\tb", client.AttachSession(kMockSessionId)), WebDriverException);
+}
+
+TEST_F(TestSessionReuse, DropsDeadSessions) {
+	const SessionRegistry registry(registry_path);
+	registry.Release("chrome", client.AttachSession("gone"));
+	registry.Acquire(client, "chrome", Capabilities());
+	ASSERT_EQ(1, created);
+	ASSERT_TRUE(registry.GetIdleSessionIds("chrome").empty());
+}
+
+TEST_F(TestSessionReuse, DeletesIdleSessions) {
+	const SessionRegistry registry(registry_path);
+	registry.Release("chrome", client.AttachSession(kMockSessionId));
+	registry.DeleteIdleSessions(client, "chrome");
+	ASSERT_EQ(1, deleted);
+	ASSERT_TRUE(registry.GetIdleSessionIds("chrome").empty());
+}
+
+TEST_F(TestSessionReuse, IgnoresLockFileWithoutHolder) {
+	std::fclose(std::fopen((registry_path + ".lock").c_str(), "w"));
+	const SessionRegistry registry(registry_path, 50);
+	registry.Release("chrome", client.AttachSession(kMockSessionId));
+	ASSERT_EQ(1u, registry.GetIdleSessionIds("chrome").size());
+}
+
+TEST_F(TestSessionReuse, WaitsForHeldLock) {
+	const SessionRegistry registry(registry_path, 50);
+	{
+		const RegistryFileLock lock(registry_path + ".lock", 0);
+		ASSERT_THROW(registry.Release("chrome", client.AttachSession(kMockSessionId)),
+			WebDriverException);
+	}
+	registry.Release("chrome", client.AttachSession(kMockSessionId));
+	ASSERT_EQ(1u, registry.GetIdleSessionIds("chrome").size());
+}
+
+} // namespace test
@@ -0,0 +1,121 @@
+#include "environment.h"
+#include "mock_server.h"
+#include <webdriverxx/webdriver.h>
+#include <webdriverxx/session_state.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+namespace {
+
+SessionState MakeState() {
+	SessionState state;
+	state.origin = "http://example.com";
+	state.cookies.push_back(Cookie("sid", "abc", "/", ".example.com", true, true, 1700000000));
+	state.cookies.push_back(Cookie("theme", "dark"));
+	state.local_storage["token"] = std::string("x\0y", 3);
+	state.local_storage["user"] = "{\"id\":1}";
+	state.session_storage["tab"] = "2";
+	return state;
+}
+
+} // namespace
+
+TEST(SessionState, SurvivesSerialization) {
+	const SessionState state = MakeState();
+	ASSERT_EQ(state, ParseSessionState(SerializeSessionState(state)));
+	ASSERT_EQ(SessionState(), ParseSessionState(SerializeSessionState(SessionState())));
+}
+
+TEST(SessionState, RejectsDamagedData) {
+	const std::string data = SerializeSessionState(MakeState());
+	ASSERT_THROW(ParseSessionState(data.substr(0, data.size() - 1)), WebDriverException);
+	ASSERT_THROW(ParseSessionState(data + "x"), WebDriverException);
+	ASSERT_THROW(ParseSessionState("JSON"), WebDriverException);
+	std::string huge_string = data;
+	huge_string[11] = '\x7F'; // High byte of the origin length
+	ASSERT_THROW(ParseSessionState(huge_string), WebDriverException);
+}
+
+TEST(SessionState, IsSavedToFile) {
+	const std::string path = "webdriverxx-session-state-test.bin";
+	SaveSessionState(MakeState(), path);
+	const SessionState loaded = LoadSessionState(path);
+	std::remove(path.c_str());
+	ASSERT_EQ(MakeState(), loaded);
+	ASSERT_THROW(LoadSessionState(path), WebDriverException);
+}
+
+class TestSessionStateCommands : public MockSessionTest {
+protected:
+	TestSessionStateCommands() {
+		server->On("POST", MockServer::SessionPath("cookie"), [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			posted_cookies.push_back(FromJson<Cookie>(request.get("cookie")));
+			return picojson::value();
+		});
+	}
+
+	std::vector<Cookie> posted_cookies;
+};
+
+TEST_F(TestSessionStateCommands, ExportsWithTwoCommands) {
+	const SessionState state = MakeState();
+	server->On("GET", MockServer::SessionPath("cookie"), ToJson(state.cookies));
+	server->On("POST", MockServer::SessionPath("execute"), JsonObject()
+		.Set("origin", state.origin)
+		.Set("local", StorageToJson(state.local_storage))
+		.Set("session", StorageToJson(state.session_storage)));
+	const unsigned requests_before = server->GetRequestCount();
+	ASSERT_EQ(state, session.ExportState());
+	ASSERT_EQ(2u, server->GetRequestCount() - requests_before);
+}
+
+TEST_F(TestSessionStateCommands, SetsOnlyCookiesScriptCannotSet) {
+	server->On("POST", MockServer::SessionPath("execute"), ToJson(std::vector<int>(1, 0)));
+	const unsigned requests_before = server->GetRequestCount();
+	session.ImportState(MakeState());
+	ASSERT_EQ(2u, server->GetRequestCount() - requests_before);
+	ASSERT_EQ(1u, posted_cookies.size());
+	ASSERT_EQ("sid", posted_cookies[0].name);
+}
+
+TEST_F(TestSessionStateCommands, RequiresPageOfSameOrigin) {
+	server->On("POST", MockServer::SessionPath("execute"), picojson::value());
+	ASSERT_THROW(session.ImportState(MakeState()), WebDriverException);
+	ASSERT_TRUE(posted_cookies.empty());
+}
+
+class TestSessionState : public ::testing::Test {
+protected:
+	TestSessionState() : driver(GetDriver()) {}
+
+	WebDriver driver;
+};
+
+TEST_F(TestSessionState, RestoresCookiesAndStorage) {
+	driver.Navigate(GetTestPageUrl("session.html"));
+	driver.DeleteCookies();
+	driver.Execute("localStorage.clear(); sessionStorage.clear();");
+	driver.SetCookie(Cookie("state_cookie", "value1"));
+	driver.Execute("localStorage.setItem('a', '1'); sessionStorage.setItem('b', '2');");
+	const SessionState state = driver.ExportState();
+	ASSERT_EQ("1", state.local_storage.at("a"));
+	ASSERT_EQ("2", state.session_storage.at("b"));
+
+	driver.DeleteCookies();
+	driver.Execute("localStorage.clear(); sessionStorage.clear();");
+	driver.ImportState(ParseSessionState(SerializeSessionState(state)));
+	ASSERT_EQ("1", driver.Eval<std::string>("return localStorage.getItem('a')"));
+	ASSERT_EQ("2", driver.Eval<std::string>("return sessionStorage.getItem('b')"));
+	const std::vector<Cookie> cookies = driver.GetCookies();
+	ASSERT_EQ(1u, cookies.size());
+	ASSERT_EQ("value1", cookies[0].value);
+}
+
+} // namespace test
@@ -0,0 +1,179 @@
+#include "http_server.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/detail/json_stream.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+namespace {
+
+// Feeds the document in pieces of the given size.
+std::string StreamValue(const std::string& document, size_t piece, std::string* rest = nullptr) {
+	std::string result;
+	JsonStringStreamer streamer([&result](const std::string& chunk) {
+		result += chunk;
+		return true;
+	});
+	for (size_t i = 0; i < document.size(); i += piece)
+		streamer.Feed(document.data() + i, std::min(piece, document.size() - i));
+	if (rest)
+		*rest = streamer.GetRest();
+	return streamer.IsStreamed() ? result : "<not streamed>";
+}
+
+} // namespace
+
+TEST(JsonStringStreamer, UnescapesSplitSequences) {
+	const std::string text = "<p class=\"a\">\\caf\xC3\xA9\n\t/\xF0\x9F\x98\x80</p>";
+	const std::string document = static_cast<picojson::value>(JsonObject()
+		.Set("sessionId", "123")
+		.Set("status", 0)
+		.Set("value", text)
+		.Set("extra", "\"value\":\"not this\"")
+		).serialize();
+	const std::string escaped = "{\"value\":\"caf\\u00e9 \\ud83d\\ude00 \\/ \\\" \\\\\"}";
+	for (size_t piece = 1; piece <= 7; ++piece) {
+		ASSERT_EQ(text, StreamValue(document, piece));
+		ASSERT_EQ("caf\xC3\xA9 \xF0\x9F\x98\x80 / \" \\", StreamValue(escaped, piece));
+	}
+}
+
+TEST(JsonStringStreamer, KeepsOtherMembers) {
+	std::string rest;
+	StreamValue("{\"status\": 0, \"value\" : \"abc\", \"sessionId\": \"x\"}", 3, &rest);
+	picojson::value parsed;
+	ASSERT_TRUE(picojson::parse(parsed, rest).empty());
+	ASSERT_EQ(0, FromJson<int>(parsed.get("status")));
+	ASSERT_EQ("", FromJson<std::string>(parsed.get("value")));
+	ASSERT_EQ("x", FromJson<std::string>(parsed.get("sessionId")));
+}
+
+TEST(JsonStringStreamer, IgnoresNestedAndNonStringValues) {
+	std::string rest;
+	const std::string document = "{\"status\":13,\"value\":{\"message\":\"oops\",\"value\":\"a\"}}";
+	ASSERT_EQ("<not streamed>", StreamValue(document, 2, &rest));
+	ASSERT_EQ(document, rest);
+	ASSERT_EQ("<not streamed>", StreamValue("{\"values\":\"a\",\"value\":null}", 1));
+}
+
+TEST(JsonStringStreamer, StopsWhenHandlerAsks) {
+	size_t calls = 0;
+	JsonStringStreamer streamer([&calls](const std::string&) {
+		return ++calls < 2;
+	});
+	ASSERT_TRUE(streamer.Feed("{\"value\":\"ab", 12));
+	ASSERT_FALSE(streamer.Feed("cd", 2));
+	ASSERT_FALSE(streamer.Feed("ef\"}", 4));
+	ASSERT_EQ(2u, calls);
+	ASSERT_TRUE(streamer.IsStopped());
+}
+
+#ifndef _WIN32
+
+class TestStreamSource : public ::testing::Test {
+protected:
+	TestStreamSource()
+		: mock(new MockServer)
+		, server(mock)
+		, source(MakeSource())
+	{
+		mock->On("GET", MockServer::SessionPath("source"), ToJson(source));
+	}
+
+	static std::string MakeSource() {
+		std::string result = "<html><body>";
+		for (int i = 0; i < 20000; ++i)
+			result += Fmt() << "<p id=\"p" << i << "\">\xC3\xA9</p>\n";
+		return result + "<div id=\"marker\"></div></body></html>";
+	}
+
+	Shared<MockServer> mock;
+	HttpServer server;
+	const std::string source;
+};
+
+TEST_F(TestStreamSource, PassesSourceInChunks) {
+	const Client client(server.GetUrl());
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	std::string received;
+	size_t chunks = 0;
+	session.StreamSource([&](const std::string& chunk) {
+		received += chunk;
+		++chunks;
+		return true;
+	});
+	ASSERT_EQ(source, received);
+	ASSERT_LT(1u, chunks);
+	ASSERT_LT(source.size(), client.GetMetrics().bytes_received);
+}
+
+TEST_F(TestStreamSource, StopsEarly) {
+	const Client client(server.GetUrl());
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	std::string received;
+	session.StreamSource([&received](const std::string& chunk) {
+		received += chunk;
+		return received.find("id=\"p100\"") == std::string::npos;
+	});
+	ASSERT_LT(received.size(), source.size() / 2);
+	// The connection is still usable
+	ASSERT_EQ(source, session.GetSource());
+}
+
+#if WEBDRIVERXX_HAS_HTTP_MULTIPLEXER
+
+TEST_F(TestStreamSource, PassesSourceInChunksThroughHttpMultiplexer) {
+	const Client client(server.GetUrl(), ConnectionOptions().SetHttpVersion(http_version::Http2));
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	std::string received;
+	size_t chunks = 0;
+	session.StreamSource([&](const std::string& chunk) {
+		received += chunk;
+		++chunks;
+		return received.find("id=\"p5000\"") == std::string::npos;
+	});
+	ASSERT_LT(1u, chunks);
+	ASSERT_LT(received.size(), source.size() / 2);
+	ASSERT_EQ(source, session.GetSource());
+}
+
+#endif
+
+TEST_F(TestStreamSource, WorksWithClientsThatCannotStream) {
+	const Client client(kMockServerUrl, mock);
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	std::string received;
+	session.StreamSource([&received](const std::string& chunk) {
+		received += chunk;
+		return true;
+	});
+	ASSERT_EQ(source, received);
+}
+
+TEST_F(TestStreamSource, ThrowsIfValueIsNotString) {
+	mock->On("GET", MockServer::SessionPath("source"), ToJson(123));
+	const Client client(server.GetUrl());
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_THROW(session.StreamSource([](const std::string&) { return true; }),
+		WebDriverException);
+}
+
+TEST_F(TestStreamSource, PassesHandlerExceptions) {
+	const Client client(server.GetUrl());
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_THROW(session.StreamSource([](const std::string&) -> bool {
+		throw std::runtime_error("handler");
+	}), WebDriverException);
+}
+
+#endif
+
+} // namespace test
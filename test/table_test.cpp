@@ -0,0 +1,101 @@
+#include "environment.h"
+#include "mock_server.h"
+#include <webdriverxx/webdriver.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestTable : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		WebDriver& driver = GetDriver();
+		driver.Navigate(GetTestPageUrl("table.html"));
+		driver.FindElement(ById("table_loaded"));
+	}
+
+	TestTable() : driver(GetDriver()) {}
+
+	WebDriver driver;
+};
+
+TEST_F(TestTable, ExtractsTextAttributesAndElements) {
+	std::vector<TableColumn> columns;
+	columns.push_back(CellText(0));
+	columns.push_back(CellAttribute(0, "data-id"));
+	columns.push_back(CellText(1));
+	columns.push_back(CellElement(1));
+	const Table table = driver.ExtractTable(ByCss("#grid tbody"), columns);
+	ASSERT_EQ(3u, table.row_count);
+	ASSERT_EQ("Banana", table.values[0][1]);
+	ASSERT_EQ("3", table.values[1][2]);
+	ASSERT_EQ("10", table.values[2][0]);
+	ASSERT_EQ("", table.values[2][2]);
+	ASSERT_EQ("20", table.elements[3][1].GetText());
+	ASSERT_EQ(Element(), table.elements[3][2]);
+	ASSERT_TRUE(table.values[3].empty());
+}
+
+TEST_F(TestTable, ExtractsWholeTableInChunks) {
+	std::vector<TableColumn> columns;
+	columns.push_back(CellText(0));
+	std::vector<size_t> chunks;
+	std::vector<std::string> names;
+	driver.ExtractTable(ById("grid"), columns, [&](const Table& chunk) {
+		chunks.push_back(chunk.first_row);
+		names.insert(names.end(), chunk.values[0].begin(), chunk.values[0].end());
+	}, 3);
+	ASSERT_EQ(2u, chunks.size());
+	ASSERT_EQ(3u, chunks[1]);
+	ASSERT_EQ(4u, names.size());
+	ASSERT_EQ("Name", names[0]);
+	ASSERT_EQ("Cherry", names[3]);
+}
+
+// A table of 2500 rows, every cell contains its row number.
+class TestTableChunks : public MockSessionTest {
+protected:
+	TestTableChunks() {
+		const ElementRef table_ref = { "table" };
+		server->On("POST", MockServer::SessionPath("element"), ToJson(table_ref));
+		server->On("POST", MockServer::SessionPath("execute"), [](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			const picojson::value& args = request.get("args");
+			const int kTotal = 2500;
+			const int first = FromJson<int>(args.get(2));
+			const int end = std::min(kTotal, first + FromJson<int>(args.get(3)));
+			std::vector<std::string> cells;
+			for (int row = first; row < end; ++row)
+				cells.push_back(Fmt() << row);
+			return static_cast<picojson::value>(JsonObject()
+				.Set("total", kTotal)
+				.Set("columns", std::vector<std::vector<std::string>>(1, cells)));
+		});
+	}
+};
+
+TEST_F(TestTableChunks, RequestsRowsInChunks) {
+	const unsigned requests_before = server->GetRequestCount();
+	const Table table = session.ExtractTable(ById("grid"),
+		std::vector<TableColumn>(1, CellText(0)), 1000);
+	ASSERT_EQ(4u, server->GetRequestCount() - requests_before); // Find and 3 chunks
+	ASSERT_EQ(2500u, table.row_count);
+	ASSERT_EQ(2500u, table.values[0].size());
+	ASSERT_EQ("1999", table.values[0][1999]);
+}
+
+TEST_F(TestTableChunks, PassesChunksToHandler) {
+	std::vector<Table> chunks;
+	session.ExtractTable(ById("grid"), std::vector<TableColumn>(1, CellText(0)),
+		[&chunks](const Table& chunk) { chunks.push_back(chunk); }, 1000);
+	ASSERT_EQ(3u, chunks.size());
+	ASSERT_EQ(2000u, chunks[2].first_row);
+	ASSERT_EQ(500u, chunks[2].row_count);
+	ASSERT_EQ("2000", chunks[2].values[0][0]);
+}
+
+} // namespace test
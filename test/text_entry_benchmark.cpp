@@ -0,0 +1,40 @@
+#include "environment.h"
+#include <webdriverxx/webdriver.h>
+#include <gtest/gtest.h>
+#include <functional>
+#include <iostream>
+#include <string>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class BenchmarkTextEntry : public ::testing::Test {
+protected:
+	BenchmarkTextEntry() : driver(GetDriver()) {
+		driver.Navigate(GetTestPageUrl("form.html"));
+	}
+
+	WebDriver driver;
+};
+
+TEST_F(BenchmarkTextEntry, LongTextWithEachMethod) {
+	const Element about = driver.FindElement(ByName("about"));
+	const std::string text(20000, 'x');
+	const auto measure = [&](const std::function<void()>& enter) {
+		about.Clear();
+		const TimePoint start = Now();
+		enter();
+		const Duration elapsed = Now() - start;
+		EXPECT_EQ(text.size(), about.GetAttribute("value").size());
+		return elapsed;
+	};
+	const Duration send_keys = measure([&] { about.SendKeys(text); });
+	const Duration chunks = measure([&] { about.EnterText(text); });
+	const Duration script = measure([&] { about.EnterText(text, TextEntry::SetValue); });
+	std::cout << "Entering " << text.size() << " characters: SendKeys " << send_keys
+		<< " ms, chunks of 1000 " << chunks << " ms, script " << script << " ms" << std::endl;
+}
+
+} // namespace test
@@ -0,0 +1,107 @@
+#include "environment.h"
+#include "mock_server.h"
+#include <webdriverxx/webdriver.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(SplitUtf8, KeepsCharactersWhole) {
+	const std::string euro = "\xE2\x82\xAC";
+	const std::vector<std::string> chunks = SplitUtf8("ab" + euro + "cd", 2);
+	ASSERT_EQ(3u, chunks.size());
+	ASSERT_EQ("ab", chunks[0]);
+	ASSERT_EQ(euro + "c", chunks[1]);
+	ASSERT_EQ("d", chunks[2]);
+	ASSERT_TRUE(SplitUtf8("", 2).empty());
+	ASSERT_EQ(1u, SplitUtf8("abc", 3).size());
+}
+
+class TestTextEntryCommands : public MockSessionTest {
+protected:
+	TestTextEntryCommands() {
+		server->On("POST", MockServer::SessionPath("element"), JsonObject().Set("ELEMENT", "e1"));
+		server->On("POST", MockServer::SessionPath("element/e1/clear"), [this](const std::string&) {
+			cleared.push_back(typed.size());
+			return picojson::value();
+		});
+		server->On("POST", MockServer::SessionPath("element/e1/value"), [this](const std::string& data) {
+			const picojson::value request = ParseRequest(data);
+			typed.push_back(request.get("value").get(0).to_str());
+			return picojson::value();
+		});
+	}
+
+	std::vector<std::string> typed;
+	std::vector<size_t> cleared; // Chunks typed before each clear
+};
+
+TEST_F(TestTextEntryCommands, TypesTextInChunks) {
+	const std::string text(2500, 'x');
+	session.FindElement(ByTag("textarea")).EnterText(text);
+	ASSERT_EQ(3u, typed.size());
+	ASSERT_EQ(text, typed[0] + typed[1] + typed[2]);
+	typed.clear();
+	session.FindElement(ByTag("textarea")).EnterText("abcde", TextEntry().SetChunkSize(2));
+	ASSERT_EQ(3u, typed.size());
+}
+
+TEST_F(TestTextEntryCommands, ClearsBeforeTyping) {
+	const Element element = session.FindElement(ByTag("textarea"));
+	element.EnterText("abc", TextEntry().SetChunkSize(2));
+	element.EnterText("d");
+	const std::vector<size_t> expected = { 0, 2 };
+	ASSERT_EQ(expected, cleared);
+	ASSERT_EQ(3u, typed.size());
+}
+
+TEST_F(TestTextEntryCommands, SetsValueWithOneScript) {
+	std::string request;
+	server->On("POST", MockServer::SessionPath("execute"), [&request](const std::string& data) {
+		request = data;
+		picojson::value result;
+		picojson::parse(result, request.find("locked") == std::string::npos ?
+			"[[0,\"\"]]" : "[[2,\"Element is read-only\"]]");
+		return result;
+	});
+	const Element element = session.FindElement(ByTag("textarea"));
+	const unsigned requests = server->GetRequestCount();
+	element.EnterText(std::string(100000, 'x'), TextEntry(TextEntry::SetValue));
+	ASSERT_EQ(requests + 1, server->GetRequestCount());
+	ASSERT_TRUE(typed.empty());
+	ASSERT_NE(std::string::npos, request.find("{\"ELEMENT\":\"e1\"}"));
+	ASSERT_THROW(element.EnterText("locked", TextEntry::SetValue), WebDriverException);
+}
+
+class TestTextEntry : public ::testing::Test {
+protected:
+	TestTextEntry() : driver(GetDriver()) {
+		driver.Navigate(GetTestPageUrl("form.html"));
+	}
+
+	WebDriver driver;
+};
+
+TEST_F(TestTextEntry, EntersTextWithBothMethods) {
+	const Element about = driver.FindElement(ByName("about"));
+	about.EnterText("abc", TextEntry().SetChunkSize(2));
+	ASSERT_EQ("abc", about.GetAttribute("value"));
+	about.EnterText("{\"a\": 1}", TextEntry::SetValue);
+	ASSERT_EQ("{\"a\": 1}", about.GetAttribute("value"));
+	ASSERT_EQ("about", driver.FindElement(ById("changes")).GetText());
+}
+
+TEST_F(TestTextEntry, BothMethodsReplaceValue) {
+	const Element user = driver.FindElement(ByName("user"));
+	user.SendKeys("old");
+	user.EnterText("abc", TextEntry().SetChunkSize(2));
+	ASSERT_EQ("abc", user.GetAttribute("value"));
+	user.EnterText("de", TextEntry::SetValue);
+	ASSERT_EQ("de", user.GetAttribute("value"));
+}
+
+} // namespace test
@@ -0,0 +1,38 @@
+#include "http_server.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+
+#ifndef _WIN32
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+// Prints average command latency of both transports.
+TEST(BenchmarkUnixSocket, AgainstTcpLoopback) {
+	const Shared<MockServer> mock(new MockServer);
+	mock->On("GET", MockServer::SessionPath("title"), ToJson("Mock"));
+	HttpServer unix_server(mock, Fmt() << "/tmp/webdriverxx-benchmark-" << ::getpid() << ".sock");
+	HttpServer tcp_server(mock);
+	const int kRequests = 2000;
+	const auto measure = [kRequests](const Client& client) {
+		const Session session = client.CreateSession(Capabilities(), Capabilities());
+		session.GetTitle(); // Warm up the connection
+		const TimePoint start = Now();
+		for (int i = 0; i < kRequests; ++i)
+			session.GetTitle();
+		return static_cast<double>(Now() - start) * 1000 / kRequests;
+	};
+	const double tcp_us = measure(Client(tcp_server.GetUrl()));
+	const double unix_us = measure(Client(unix_server.GetUrl()));
+	std::cout << "Average command latency: TCP loopback " << tcp_us
+		<< " us, Unix domain socket " << unix_us << " us" << std::endl;
+}
+
+} // namespace test
+
+#endif
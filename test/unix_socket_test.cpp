@@ -0,0 +1,70 @@
+#include "http_server.h"
+#include "mock_server.h"
+#include <webdriverxx/client.h>
+#include <webdriverxx/detail/http_connection.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#ifndef _WIN32
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+class TestUnixSocket : public ::testing::Test {
+protected:
+	TestUnixSocket()
+		: mock(new MockServer)
+		, server(mock, Fmt() << "/tmp/webdriverxx-test-" << ::getpid() << ".sock")
+	{
+		mock->On("GET", MockServer::SessionPath("title"), ToJson("Mock"));
+	}
+
+	std::string GetSocketPath() const {
+		return server.GetUrl().substr(std::string("unix:").size());
+	}
+
+	Shared<MockServer> mock;
+	HttpServer server;
+};
+
+TEST_F(TestUnixSocket, IsUsedByHttpConnection) {
+	const HttpConnection connection(ConnectionOptions().SetUnixSocketPath(GetSocketPath()));
+	const HttpResponse response =
+		connection.Get("http://localhost/" + MockServer::SessionPath("title"));
+	ASSERT_EQ(200, response.http_code);
+	ASSERT_NE(std::string::npos, response.body.find("Mock"));
+}
+
+TEST_F(TestUnixSocket, IsUsedForUnixUrls) {
+	const Client client(server.GetUrl());
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_EQ("Mock", session.GetTitle());
+	ASSERT_EQ(1u, server.GetConnectionCount());
+}
+
+TEST_F(TestUnixSocket, TakesBasePathFromUnixUrl) {
+	mock->On("GET", "wd/hub/status", JsonObject().Set("ready", true));
+	const Client client(server.GetUrl() + ":/wd/hub/");
+	ASSERT_EQ(1u, client.GetStatus().count("ready"));
+}
+
+TEST_F(TestUnixSocket, IsUsedWithHttpUrlAndOptions) {
+	const Client client("http://localhost/", ConnectionOptions().SetUnixSocketPath(GetSocketPath()));
+	const Session session = client.CreateSession(Capabilities(), Capabilities());
+	ASSERT_EQ("Mock", session.GetTitle());
+}
+
+TEST(UnixSocket, ThrowsExceptionIfPathIsMissing) {
+	ASSERT_THROW(Client("unix:"), WebDriverException);
+}
+
+TEST(UnixSocket, ThrowsExceptionIfSocketDoesNotExist) {
+	const Client client("unix:/tmp/webdriverxx-test-missing.sock");
+	ASSERT_THROW(client.GetStatus(), WebDriverException);
+}
+
+} // namespace test
+
+#endif
@@ -0,0 +1,30 @@
+#include <webdriverxx/wait_engine.h>
+#include <webdriverxx/detail/time.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(BenchmarkWaitEngine, ManyWaitsFromOneThread) {
+	const int kWaits = 1000;
+	const Duration kSettleMs = 100;
+	WaitEngine engine;
+	const TimePoint start = Now();
+	const TimePoint settled = start + kSettleMs;
+	std::vector<PendingWait<bool>> waits;
+	for (int i = 0; i < kWaits; ++i)
+		waits.push_back(engine.WaitUntil([settled]{ return Now() >= settled; }, 5000, 10));
+	for (const auto& wait : waits)
+		EXPECT_TRUE(wait.Get());
+	const TimePoint done = Now();
+
+	std::cout << kWaits << " waits polled every 10 ms: all satisfied "
+		<< static_cast<Duration>(done - settled) << " ms after the condition became true, "
+		<< static_cast<Duration>(done - start) << " ms in total" << std::endl;
+}
+
+} // namespace test
@@ -0,0 +1,86 @@
+#include <webdriverxx/wait_engine.h>
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace test {
+
+using namespace webdriverxx;
+using namespace webdriverxx::detail;
+
+TEST(TimerWheel, CallsFunctionsAfterDelay) {
+	TimerWheel wheel(1, 8); // Delays longer than a turn of the wheel too
+	std::promise<TimePoint> fired;
+	const TimePoint start = Now();
+	wheel.Schedule(30, [&fired]{ fired.set_value(Now()); });
+	const Duration elapsed = static_cast<Duration>(fired.get_future().get() - start);
+	ASSERT_LE(30u, elapsed);
+	ASSERT_GT(1000u, elapsed);
+	ASSERT_EQ(0u, wheel.GetPendingCount());
+}
+
+TEST(TimerWheel, CancelsTimers) {
+	TimerWheel wheel;
+	std::atomic<int> counter(0);
+	const auto id = wheel.Schedule(20, [&counter]{ ++counter; });
+	wheel.Schedule(0, [&counter]{ counter += 10; });
+	ASSERT_TRUE(wheel.Cancel(id));
+	ASSERT_FALSE(wheel.Cancel(id));
+	Sleep(50);
+	ASSERT_EQ(10, counter.load());
+}
+
+TEST(WaitEngine, WaitsForValue) {
+	WaitEngine engine;
+	ASSERT_EQ(123, engine.WaitForValue([]{ return 123; }).Get());
+}
+
+TEST(WaitEngine, CallsGetterUntilValueIsTruthy) {
+	WaitEngine engine;
+	const auto counter = std::make_shared<std::atomic<int>>(0);
+	const auto wait = engine.WaitUntil([counter]{ return ++*counter >= 3; }, 1000, 0);
+	ASSERT_TRUE(wait.Get());
+	ASSERT_EQ(3, counter->load());
+}
+
+TEST(WaitEngine, WaitsForMatch) {
+	WaitEngine engine;
+	const auto counter = std::make_shared<std::atomic<int>>(0);
+	ASSERT_EQ(5, engine.WaitForMatch([counter]{ return ++*counter; },
+		[](int value) { return value == 5; }, 1000, 1).Get());
+	ASSERT_EQ(7, engine.WaitForMatch([counter]{ return ++*counter; },
+		::testing::Eq(7), 1000, 1).Get());
+}
+
+TEST(WaitEngine, ThrowsExceptionOnTimeout) {
+	WaitEngine engine;
+	const auto wait = engine.WaitUntil([]{ return false; }, 0);
+	ASSERT_THROW(wait.Get(), WebDriverException);
+}
+
+TEST(WaitEngine, CancelsWaits) {
+	WaitEngine engine;
+	const auto wait = engine.WaitUntil([]{ return false; }, 60000);
+	ASSERT_FALSE(wait.IsDone());
+	ASSERT_TRUE(wait.Cancel());
+	ASSERT_TRUE(wait.IsDone());
+	ASSERT_FALSE(wait.Cancel());
+	ASSERT_THROW(wait.Get(), WebDriverException);
+}
+
+TEST(WaitEngine, ServicesManyWaitsFromOneThread) {
+	const int kWaits = 1000;
+	const Duration kSettleMs = 100;
+	WaitEngine engine;
+	const TimePoint settled = Now() + kSettleMs;
+	std::vector<PendingWait<bool>> waits;
+	for (int i = 0; i < kWaits; ++i)
+		waits.push_back(engine.WaitUntil([settled]{ return Now() >= settled; }, 5000, 10));
+	for (const auto& wait : waits)
+		ASSERT_TRUE(wait.Get());
+	ASSERT_EQ(0u, engine.GetPendingCount());
+}
+
+} // namespace test